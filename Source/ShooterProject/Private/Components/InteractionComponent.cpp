@@ -3,25 +3,44 @@
 
 #include "Components/InteractionComponent.h"
 #include "Components/ActorComponent.h"
+#include "Components/WidgetComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectHash.h"
 #include "Player/ShooterProjectCharacter.h"
+#include "Player/ShooterProjectPlayerController.h"
 #include "UI/InteractionWidget.h"
 
-UInteractionComponent::UInteractionComponent()
+//Only local players have an interaction widget, and there are never more than a few of them
+static void ForEachLocalPlayerController(UWorld* World, TFunctionRef<void(AShooterProjectPlayerController*)> Func)
 {
-	SetComponentTickEnabled(false);
+	if (!World || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
 
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		AShooterProjectPlayerController* PC = Cast<AShooterProjectPlayerController>(It->Get());
+
+		if (PC && PC->IsLocalController())
+		{
+			Func(PC);
+		}
+	}
+}
+
+
+UInteractionComponent::UInteractionComponent()
+{
 	InteractionTime = 0.f;
 	InteractionDistance = 200.f;
 	InteractibleNameText = FText::FromString("Interactable Object");
 	InteractibleActionText = FText::FromString("Interact");
 	bAllowMultipleInteractors = true;
 
-	Space = EWidgetSpace::Screen;
-	DrawSize = FIntPoint(600, 100);
-	bDrawAtDesiredSize = true;
-
 	SetActive(true);
-	SetHiddenInGame(true);
 }
 
 
@@ -55,6 +74,17 @@ void UInteractionComponent::Deactivate()
 }
 
 
+void UInteractionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ForEachLocalPlayerController(GetWorld(), [this](AShooterProjectPlayerController* PC)
+	{
+		PC->HideInteractionWidget(this);
+	});
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
 bool UInteractionComponent::CanInteract(class AShooterProjectCharacter* Character) const
 {
 	const bool bPlayerAlreadyInteracting = !bAllowMultipleInteractors && Interactors.Num() >= 1;
@@ -64,13 +94,10 @@ bool UInteractionComponent::CanInteract(class AShooterProjectCharacter* Characte
 
 void UInteractionComponent::RefreshWidget()
 {
-	if (!bHiddenInGame && GetOwner()->GetNetMode() != NM_DedicatedServer)
+	ForEachLocalPlayerController(GetWorld(), [this](AShooterProjectPlayerController* PC)
 	{
-		if (UInteractionWidget* InteractionWidget = Cast<UInteractionWidget>(GetUserWidgetObject()))
-		{
-			InteractionWidget->UpdateInteractionWidget(this);
-		}
-	}
+		PC->RefreshInteractionWidget(this);
+	});
 }
 
 
@@ -83,7 +110,10 @@ void UInteractionComponent::BeginFocus(class AShooterProjectCharacter* Character
 
 	OnBeginFocus.Broadcast(Character);
 
-	SetHiddenInGame(false);
+	if (AShooterProjectPlayerController* PC = Cast<AShooterProjectPlayerController>(Character->GetController()))
+	{
+		PC->ShowInteractionWidget(this);
+	}
 
 	//Object outliner
 	if (!GetOwner()->HasAuthority())
@@ -96,7 +126,6 @@ void UInteractionComponent::BeginFocus(class AShooterProjectCharacter* Character
 			}
 		}
 	}
-	RefreshWidget();
 }
 
 
@@ -104,7 +133,10 @@ void UInteractionComponent::EndFocus(class AShooterProjectCharacter* Character)
 {
 	OnEndFocus.Broadcast(Character);
 
-	SetHiddenInGame(true);
+	if (AShooterProjectPlayerController* PC = Character ? Cast<AShooterProjectPlayerController>(Character->GetController()) : nullptr)
+	{
+		PC->HideInteractionWidget(this);
+	}
 
 	if (!GetOwner()->HasAuthority())
 	{
@@ -159,3 +191,93 @@ float UInteractionComponent::GetInteractPercentage()
 	}
 	return 0.f;
 }
+
+
+static FAutoConsoleCommandWithWorldAndArgs InteractionWidgetBenchmarkCommand(
+	TEXT("ui.InteractionWidgetBenchmark"),
+	TEXT("Compare the construction time and memory of interactables that each own a widget component with our data only interaction components. Needs a local player. Usage: ui.InteractionWidgetBenchmark [Interactables]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const AShooterProjectPlayerController* PC = World ? Cast<AShooterProjectPlayerController>(World->GetFirstPlayerController()) : nullptr;
+
+		if (!PC || !PC->GetInteractionWidgetClass())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ui.InteractionWidgetBenchmark: needs a local player with an interaction widget class"));
+			return;
+		}
+
+		const int32 NumInteractables = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		const TSubclassOf<UUserWidget> WidgetClass = PC->GetInteractionWidgetClass();
+
+		//Builds NumInteractables components on a throwaway actor, returning how long it took and the bytes of UObject memory they use
+		auto Measure = [World, NumInteractables, WidgetClass](const bool bWithWidget, double& OutSeconds, int64& OutBytes)
+		{
+			AActor* Host = World->SpawnActor<AActor>();
+			Host->SetRootComponent(NewObject<USceneComponent>(Host, TEXT("Root")));
+			Host->GetRootComponent()->RegisterComponent();
+
+			TArray<UObject*> Objects;
+			const double StartTime = FPlatformTime::Seconds();
+
+			for (int32 i = 0; i < NumInteractables; ++i)
+			{
+				if (bWithWidget)
+				{
+					//What every interactable used to carry around
+					UWidgetComponent* WidgetComponent = NewObject<UWidgetComponent>(Host);
+					WidgetComponent->SetWidgetSpace(EWidgetSpace::Screen);
+					WidgetComponent->SetDrawSize(FVector2D(600.f, 100.f));
+					WidgetComponent->SetWidgetClass(WidgetClass);
+					WidgetComponent->SetupAttachment(Host->GetRootComponent());
+					WidgetComponent->RegisterComponent();
+					WidgetComponent->InitWidget();
+
+					Objects.Add(WidgetComponent);
+					Objects.Add(WidgetComponent->GetUserWidgetObject());
+				}
+				else
+				{
+					UInteractionComponent* InteractionComponent = NewObject<UInteractionComponent>(Host);
+					InteractionComponent->SetupAttachment(Host->GetRootComponent());
+					InteractionComponent->RegisterComponent();
+
+					Objects.Add(InteractionComponent);
+				}
+			}
+
+			OutSeconds = FPlatformTime::Seconds() - StartTime;
+			OutBytes = 0;
+
+			//Widgets are counted with everything in their widget tree
+			for (UObject* Object : Objects)
+			{
+				if (!Object)
+				{
+					continue;
+				}
+
+				TArray<UObject*> Inners;
+				GetObjectsWithOuter(Object, Inners, true);
+				Inners.Add(Object);
+
+				for (UObject* Inner : Inners)
+				{
+					FArchiveCountMem CountMem(Inner);
+					OutBytes += Inner->GetClass()->GetStructureSize() + CountMem.GetMax();
+				}
+			}
+
+			Host->Destroy();
+		};
+
+		double WidgetSeconds, DataSeconds;
+		int64 WidgetBytes, DataBytes;
+
+		Measure(true, WidgetSeconds, WidgetBytes);
+		Measure(false, DataSeconds, DataBytes);
+
+		const double Scale = 1000.0 / NumInteractables;
+
+		UE_LOG(LogTemp, Log, TEXT("ui.InteractionWidgetBenchmark: per 1k interactables, widget components took %.2fms and %.1f KB, data only components took %.2fms and %.1f KB"),
+			WidgetSeconds * 1000.0 * Scale, WidgetBytes / 1024.0 * Scale, DataSeconds * 1000.0 * Scale, DataBytes / 1024.0 * Scale);
+	}));
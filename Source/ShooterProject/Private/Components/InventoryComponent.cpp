@@ -4,9 +4,10 @@
 #include "Components/InventoryComponent.h"
 #include "Net/UnrealNetwork.h"
 #include "Engine/ActorChannel.h"
+#include "Framework/NetBandwidthProfiler.h"
+#include "Net/DataBunch.h"
 #include "Items/Item.h"
-
-#define LOCTEXT_NAMESPACE "Inventory"
+#include "Items/ItemTextCache.h"
 
 
 // Sets default values for this component's properties
@@ -16,6 +17,18 @@ UInventoryComponent::UInventoryComponent()
 }
 
 
+FText FItemAddResult::GetErrorText() const
+{
+	return FItemTextCache::Get().GetAddErrorText(Error, ItemClass);
+}
+
+
+FText UInventoryComponent::GetItemAddErrorText(const FItemAddResult& AddResult)
+{
+	return AddResult.GetErrorText();
+}
+
+
 FItemAddResult UInventoryComponent::TryAddItem(class UItem* Item)
 {
 	return TryAddItem_Internal(Item);
@@ -77,8 +90,20 @@ bool UInventoryComponent::RemoveItem(class UItem* Item)
 		{
 			Items.RemoveSingle(Item);
 
+			if (TArray<UItem*, TInlineAllocator<1>>* ItemsOfClass = ItemClassIndex.Find(Item->GetClass()))
+			{
+				ItemsOfClass->RemoveSingle(Item);
+
+				if (ItemsOfClass->Num() == 0)
+				{
+					ItemClassIndex.Remove(Item->GetClass());
+				}
+			}
+
 			ReplicatedItemsKey++;
 
+			OnItemRemoved.Broadcast(Item);
+
 			return true;
 		}
 	}
@@ -102,13 +127,7 @@ UItem* UInventoryComponent::FindItem(class UItem* Item) const
 {
 	if (Item)
 	{
-		for (auto& InvItem : Items)
-		{
-			if (InvItem && InvItem->GetClass() == Item->GetClass())
-			{
-				return InvItem;
-			}
-		}
+		return FindItemByClass(Item->GetClass());
 	}
 
 	return nullptr;
@@ -117,13 +136,17 @@ UItem* UInventoryComponent::FindItem(class UItem* Item) const
 
 UItem* UInventoryComponent::FindItemByClass(TSubclassOf<class UItem> ItemClass) const
 {
-	for (auto& InvItem : Items)
+	if (const TArray<UItem*, TInlineAllocator<1>>* ItemsOfClass = ItemClassIndex.Find(ItemClass))
 	{
-		if (InvItem && InvItem->GetClass() == ItemClass)
+		for (UItem* InvItem : *ItemsOfClass)
 		{
-			return InvItem;
+			if (InvItem)
+			{
+				return InvItem;
+			}
 		}
 	}
+
 	return nullptr;
 }
 
@@ -144,6 +167,53 @@ TArray<UItem*> UInventoryComponent::FindItemsByClass(TSubclassOf<class UItem> It
 }
 
 
+int32 UInventoryComponent::GetItemQuantity(TSubclassOf<class UItem> ItemClass) const
+{
+	int32 Quantity = 0;
+
+	if (const TArray<UItem*, TInlineAllocator<1>>* ItemsOfClass = ItemClassIndex.Find(ItemClass))
+	{
+		for (const UItem* InvItem : *ItemsOfClass)
+		{
+			if (InvItem)
+			{
+				Quantity += InvItem->GetQuantity();
+			}
+		}
+	}
+
+	return Quantity;
+}
+
+
+int32 UInventoryComponent::ConsumeItemsByClass(TSubclassOf<class UItem> ItemClass, const int32 Quantity)
+{
+	int32 Consumed = 0;
+
+	//Consuming can remove a stack from the index, so always take from the last stack
+	while (Consumed < Quantity)
+	{
+		const TArray<UItem*, TInlineAllocator<1>>* ItemsOfClass = ItemClassIndex.Find(ItemClass);
+
+		if (!ItemsOfClass || ItemsOfClass->Num() == 0)
+		{
+			break;
+		}
+
+		const int32 ConsumedFromStack = ConsumeItem(ItemsOfClass->Last(), Quantity - Consumed);
+
+		if (ConsumedFromStack <= 0)
+		{
+			break;
+		}
+
+		Consumed += ConsumedFromStack;
+	}
+
+	return Consumed;
+}
+
+
 float UInventoryComponent::GetCurrentWeight() const
 {
 	float Weight = 0.f;
@@ -196,7 +266,13 @@ bool UInventoryComponent::ReplicateSubobjects(class UActorChannel *Channel, clas
 		{
 			if (Channel->KeyNeedsToReplicate(Item->GetUniqueID(), Item->RepKey))
 			{
-				bWroteSomething |= Channel->ReplicateSubobject(Item, *Bunch, *RepFlags);
+				const int64 NumBitsBefore = Bunch->GetNumBits();
+
+				if (Channel->ReplicateSubobject(Item, *Bunch, *RepFlags))
+				{
+					bWroteSomething = true;
+					FNetBandwidthProfiler::Get().Track(ENetBandwidthCategory::Subobject, Item->GetClass()->GetFName(), Bunch->GetNumBits() - NumBitsBefore);
+				}
 			}
 		}
 	}
@@ -215,6 +291,7 @@ UItem* UInventoryComponent::AddItem(class UItem* Item)
 		NewItem->OwningInventory = this;
 		NewItem->AddedToInventory(this);
 		Items.Add(NewItem);
+		ItemClassIndex.FindOrAdd(NewItem->GetClass()).Add(NewItem);
 		NewItem->MarkDirtyForReplication();
 
 		return NewItem;
@@ -226,10 +303,26 @@ UItem* UInventoryComponent::AddItem(class UItem* Item)
 
 void UInventoryComponent::OnRep_Items()
 {
+	RebuildItemClassIndex();
+
 	OnInventoryUpdated.Broadcast();
 }
 
 
+void UInventoryComponent::RebuildItemClassIndex()
+{
+	ItemClassIndex.Reset();
+
+	for (UItem* Item : Items)
+	{
+		if (Item)
+		{
+			ItemClassIndex.FindOrAdd(Item->GetClass()).Add(Item);
+		}
+	}
+}
+
+
 FItemAddResult UInventoryComponent::TryAddItem_Internal(class UItem* Item)
 {
 	if (GetOwner() && GetOwner()->HasAuthority())
@@ -240,7 +333,7 @@ FItemAddResult UInventoryComponent::TryAddItem_Internal(class UItem* Item)
 		//Checks if Inventory is full
 		if (Items.Num() + 1 > GetCapacity())
 		{
-			return FItemAddResult::AddedNone(AddAmount, LOCTEXT("InventoryCapacityFullText", "Couldn't add item to inventory. Inventory is full"));
+			return FItemAddResult::AddedNone(AddAmount, EItemAddError::IAE_InventoryFull);
 		}
 
 		//Items with a weight of zero don't require a weight check
@@ -248,7 +341,7 @@ FItemAddResult UInventoryComponent::TryAddItem_Internal(class UItem* Item)
 		{
 			if (GetCurrentWeight() + Item->Weight > GetWeightCapacity())
 			{
-				return FItemAddResult::AddedNone(AddAmount, LOCTEXT("InventoryTooMuchWeightText", "Couldn't add item to Inventory. Carrying too much weight"));
+				return FItemAddResult::AddedNone(AddAmount, EItemAddError::IAE_TooMuchWeight);
 			}
 		}
 
@@ -266,7 +359,7 @@ FItemAddResult UInventoryComponent::TryAddItem_Internal(class UItem* Item)
 					const int32 CapacityMaxAddAmount = ExistingItem->MaxStackSize - ExistingItem->GetQuantity();
 					int32 ActualAddAmount = FMath::Min(AddAmount, CapacityMaxAddAmount);
 
-					FText ErrorText = LOCTEXT("InventoryErrorText", "Couldn't add all of the item to your inventory");
+					EItemAddError Error = EItemAddError::IAE_NotAllAdded;
 
 					//Adjust based on how much weight we can carry
 					if (!FMath::IsNearlyZero(Item->Weight))
@@ -277,18 +370,18 @@ FItemAddResult UInventoryComponent::TryAddItem_Internal(class UItem* Item)
 
 						if (ActualAddAmount < AddAmount)
 						{
-							ErrorText = FText::Format(LOCTEXT("InventoryTooMuchWeightText", "Couldn't add entire stack of {ItemName} to Inventory"), Item->ItemDisplayName);
+							Error = EItemAddError::IAE_StackTooMuchWeight;
 						}
 					}
 					else if (ActualAddAmount < AddAmount)
 					{
 						//If the item weights none and we cant take it, then where was a capacity issue
-						ErrorText = FText::Format(LOCTEXT("InventoryCapacityFullText", "Couldn't add entire stack of {ItemName} to Inventory. Inventory was full."), Item->ItemDisplayName);
+						Error = EItemAddError::IAE_StackInventoryFull;
 					}
 
 					if (ActualAddAmount <= 0)
 					{
-						return FItemAddResult::AddedNone(AddAmount, LOCTEXT("InventoryErrorText", "Couldn't add item to inventory"));
+						return FItemAddResult::AddedNone(AddAmount, EItemAddError::IAE_CouldntAdd, Item->GetClass());
 					}
 
 					ExistingItem->SetQuantity(ExistingItem->GetQuantity() + ActualAddAmount);
@@ -298,7 +391,7 @@ FItemAddResult UInventoryComponent::TryAddItem_Internal(class UItem* Item)
 
 					if (ActualAddAmount < AddAmount)
 					{
-						return FItemAddResult::AddedSome(AddAmount, ActualAddAmount, ErrorText);
+						return FItemAddResult::AddedSome(AddAmount, ActualAddAmount, Error, Item->GetClass());
 					}
 					else
 					{
@@ -307,7 +400,7 @@ FItemAddResult UInventoryComponent::TryAddItem_Internal(class UItem* Item)
 				}
 				else
 				{
-					return FItemAddResult::AddedNone(AddAmount, FText::Format(LOCTEXT("InventoryFullStackText", "Couldn't add {ItemName}. You already have a full stack of this item"), Item->ItemDisplayName));
+					return FItemAddResult::AddedNone(AddAmount, EItemAddError::IAE_FullStack, Item->GetClass());
 				}
 			}
 			else
@@ -331,8 +424,5 @@ FItemAddResult UInventoryComponent::TryAddItem_Internal(class UItem* Item)
 	
 	//AddItem should never be called on a client
 	check(false);
-	return FItemAddResult::AddedNone(-1, LOCTEXT("ErrorMessage", ""));
+	return FItemAddResult::AddedNone(-1, EItemAddError::IAE_None);
 }
-
-#undef LOCTEXT_NAMESPACE
-
@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/AssetStreamingSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+
+UAssetStreamingSubsystem::UAssetStreamingSubsystem()
+{
+	CacheBudgetMB = 256.f;
+	CachedBytes = 0;
+}
+
+
+bool UAssetStreamingSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UAssetStreamingSubsystem::Deinitialize()
+{
+	for (TPair<FSoftObjectPath, FStreamedAsset>& Asset : Assets)
+	{
+		if (Asset.Value.Handle.IsValid())
+		{
+			Asset.Value.Handle->CancelHandle();
+		}
+	}
+
+	Assets.Empty();
+	CachedBytes = 0;
+
+	Super::Deinitialize();
+}
+
+
+void UAssetStreamingSubsystem::RequestAsset(const FSoftObjectPath& Path, const EAssetStreamPriority Priority, FSimpleDelegate OnLoaded /*= FSimpleDelegate()*/)
+{
+	if (Path.IsNull())
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	if (FStreamedAsset* Asset = Assets.Find(Path))
+	{
+		Asset->LastRequestTime = Now;
+
+		if (Asset->bLoaded)
+		{
+			OnLoaded.ExecuteIfBound();
+			return;
+		}
+
+		if (OnLoaded.IsBound())
+		{
+			Asset->PendingCallbacks.Add(MoveTemp(OnLoaded));
+		}
+
+		//A request at a higher priority jumps the queue. The old handle is let go once it finishes, which loads nothing twice.
+		if (Priority > Asset->Priority)
+		{
+			TSharedPtr<FStreamableHandle> OldHandle = Asset->Handle;
+
+			Asset->Priority = Priority;
+			Asset->Handle = StreamableManager.RequestAsyncLoad(Path, FStreamableDelegate::CreateUObject(this, &UAssetStreamingSubsystem::OnAssetLoaded, Path), (int32)Priority * FStreamableManager::AsyncLoadHighPriority);
+
+			if (OldHandle.IsValid())
+			{
+				OldHandle->ReleaseHandle();
+			}
+		}
+
+		return;
+	}
+
+	FStreamedAsset& NewAsset = Assets.Add(Path);
+	NewAsset.Priority = Priority;
+	NewAsset.LastRequestTime = Now;
+
+	//Something else already loaded it, so we just hold on to it from here on
+	if (UObject* LoadedAsset = Path.ResolveObject())
+	{
+		NewAsset.Handle = StreamableManager.RequestAsyncLoad(Path, FStreamableDelegate());
+		NewAsset.bLoaded = true;
+		NewAsset.SizeBytes = LoadedAsset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+		CachedBytes += NewAsset.SizeBytes;
+
+		OnLoaded.ExecuteIfBound();
+		TrimCache();
+		return;
+	}
+
+	if (OnLoaded.IsBound())
+	{
+		NewAsset.PendingCallbacks.Add(MoveTemp(OnLoaded));
+	}
+
+	NewAsset.Handle = StreamableManager.RequestAsyncLoad(Path, FStreamableDelegate::CreateUObject(this, &UAssetStreamingSubsystem::OnAssetLoaded, Path), (int32)Priority * FStreamableManager::AsyncLoadHighPriority);
+}
+
+
+void UAssetStreamingSubsystem::OnAssetLoaded(FSoftObjectPath Path)
+{
+	FStreamedAsset* Asset = Assets.Find(Path);
+
+	//Both handles finish when a request was bumped up the queue, so only the first one counts
+	if (!Asset || Asset->bLoaded)
+	{
+		return;
+	}
+
+	UObject* LoadedAsset = Path.ResolveObject();
+
+	//Forget it rather than caching nothing, so the next request tries again. Whoever was waiting never gets called back.
+	if (!LoadedAsset)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to stream %s, dropping %d callbacks"), *Path.ToString(), Asset->PendingCallbacks.Num());
+
+		FStreamedAsset FailedAsset;
+		Assets.RemoveAndCopyValue(Path, FailedAsset);
+
+		if (FailedAsset.Handle.IsValid())
+		{
+			FailedAsset.Handle->ReleaseHandle();
+		}
+
+		return;
+	}
+
+	Asset->bLoaded = true;
+	Asset->SizeBytes = LoadedAsset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	CachedBytes += Asset->SizeBytes;
+
+	//Callbacks can request more assets, which can move the map around, so take them out first
+	TArray<FSimpleDelegate> Callbacks = MoveTemp(Asset->PendingCallbacks);
+
+	for (FSimpleDelegate& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound();
+	}
+
+	TrimCache();
+}
+
+
+void UAssetStreamingSubsystem::TrimCache()
+{
+	const int64 BudgetBytes = (int64)(CacheBudgetMB * 1024.f * 1024.f);
+
+	if (CachedBytes <= BudgetBytes)
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> LoadedPaths;
+
+	for (const TPair<FSoftObjectPath, FStreamedAsset>& Asset : Assets)
+	{
+		if (Asset.Value.bLoaded)
+		{
+			LoadedPaths.Add(Asset.Key);
+		}
+	}
+
+	LoadedPaths.Sort([this](const FSoftObjectPath& A, const FSoftObjectPath& B)
+	{
+		return Assets[A].LastRequestTime < Assets[B].LastRequestTime;
+	});
+
+	//Letting go only drops our hold on the asset. Anything still showing it keeps it loaded until that lets go too.
+	for (const FSoftObjectPath& Path : LoadedPaths)
+	{
+		if (CachedBytes <= BudgetBytes)
+		{
+			break;
+		}
+
+		FStreamedAsset Asset;
+		Assets.RemoveAndCopyValue(Path, Asset);
+
+		CachedBytes -= Asset.SizeBytes;
+
+		if (Asset.Handle.IsValid())
+		{
+			Asset.Handle->ReleaseHandle();
+		}
+	}
+}
+
+
+void UAssetStreamingSubsystem::LogCache() const
+{
+	int32 NumLoading = 0;
+
+	for (const TPair<FSoftObjectPath, FStreamedAsset>& Asset : Assets)
+	{
+		if (!Asset.Value.bLoaded)
+		{
+			++NumLoading;
+		}
+	}
+
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+
+	UE_LOG(LogTemp, Log, TEXT("streaming.AssetCache: %d assets cached (%.1f / %.1f MB), %d loading, process using %.1f MB physical"),
+		Assets.Num() - NumLoading, CachedBytes / (1024.0 * 1024.0), CacheBudgetMB, NumLoading, MemoryStats.UsedPhysical / (1024.0 * 1024.0));
+}
+
+
+static FAutoConsoleCommandWithWorldAndArgs AssetCacheCommand(
+	TEXT("streaming.AssetCache"),
+	TEXT("Log what the asset streaming cache holds and the resident memory of the process. Map load times are logged by LoadMap. Usage: streaming.AssetCache"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (const UAssetStreamingSubsystem* Streaming = World ? World->GetSubsystem<UAssetStreamingSubsystem>() : nullptr)
+		{
+			Streaming->LogCache();
+		}
+	}));
@@ -0,0 +1,420 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/BatchedTickSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Items/WeaponClass.h"
+#include "Misc/App.h"
+#include "Player/ShooterProjectCharacter.h"
+#include "Player/ShooterProjectPlayerController.h"
+#include "World/Pickup.h"
+
+DECLARE_CYCLE_STAT(TEXT("Batched Character Tick"), STAT_BatchedCharacterTick, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("Batched Weapon Tick"), STAT_BatchedWeaponTick, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("Batched Interaction Widget Tick"), STAT_BatchedInteractionWidgetTick, STATGROUP_Game);
+
+static const TCHAR* GetBatchName(const EBatchedTick Batch)
+{
+	switch (Batch)
+	{
+	case EBatchedTick::Characters:
+		return TEXT("Characters");
+	case EBatchedTick::Weapons:
+		return TEXT("Weapons");
+	case EBatchedTick::InteractionWidgets:
+		return TEXT("InteractionWidgets");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+
+void FBatchedTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRefOrdered& MyCompletionGraphEvent)
+{
+	if (Subsystem && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Subsystem->TickBatch(Batch, DeltaTime);
+	}
+}
+
+
+FString FBatchedTickFunction::DiagnosticMessage()
+{
+	return FString::Printf(TEXT("UBatchedTickSubsystem[%s]"), GetBatchName(Batch));
+}
+
+
+UBatchedTickSubsystem::UBatchedTickSubsystem()
+{
+	//Characters tick where their own tick used to, weapons fire after movement so shots come from where we ended up
+	CharacterTick.TickGroup = TG_PrePhysics;
+	WeaponTick.TickGroup = TG_PostPhysics;
+	InteractionWidgetTick.TickGroup = TG_PostUpdateWork;
+
+	for (uint8 Batch = 0; Batch < (uint8)EBatchedTick::MAX; ++Batch)
+	{
+		LastTickSeconds[Batch] = 0.0;
+	}
+}
+
+
+bool UBatchedTickSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UBatchedTickSubsystem::Deinitialize()
+{
+	for (FBatchedTickFunction& TickFunction : TickFunctions)
+	{
+		if (TickFunction.IsTickFunctionRegistered())
+		{
+			TickFunction.UnRegisterTickFunction();
+		}
+	}
+
+	Characters.Empty();
+	Weapons.Empty();
+	InteractionWidgets.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UBatchedTickSubsystem::AddCharacter(AShooterProjectCharacter* Character)
+{
+	if (Character)
+	{
+		Characters.AddUnique(Character);
+		UpdateTickFunction(EBatchedTick::Characters);
+	}
+}
+
+
+void UBatchedTickSubsystem::RemoveCharacter(AShooterProjectCharacter* Character)
+{
+	Characters.RemoveSwap(Character);
+	UpdateTickFunction(EBatchedTick::Characters);
+}
+
+
+void UBatchedTickSubsystem::AddWeapon(AWeaponClass* Weapon)
+{
+	if (Weapon)
+	{
+		Weapons.AddUnique(Weapon);
+		UpdateTickFunction(EBatchedTick::Weapons);
+	}
+}
+
+
+void UBatchedTickSubsystem::RemoveWeapon(AWeaponClass* Weapon)
+{
+	Weapons.RemoveSwap(Weapon);
+	UpdateTickFunction(EBatchedTick::Weapons);
+}
+
+
+void UBatchedTickSubsystem::AddInteractionWidget(AShooterProjectPlayerController* PlayerController)
+{
+	if (PlayerController)
+	{
+		InteractionWidgets.AddUnique(PlayerController);
+		UpdateTickFunction(EBatchedTick::InteractionWidgets);
+	}
+}
+
+
+void UBatchedTickSubsystem::RemoveInteractionWidget(AShooterProjectPlayerController* PlayerController)
+{
+	InteractionWidgets.RemoveSwap(PlayerController);
+	UpdateTickFunction(EBatchedTick::InteractionWidgets);
+}
+
+
+int32 UBatchedTickSubsystem::GetNum(const EBatchedTick Batch) const
+{
+	switch (Batch)
+	{
+	case EBatchedTick::Characters:
+		return Characters.Num();
+	case EBatchedTick::Weapons:
+		return Weapons.Num();
+	case EBatchedTick::InteractionWidgets:
+		return InteractionWidgets.Num();
+	default:
+		return 0;
+	}
+}
+
+
+const FBatchedTickSettings& UBatchedTickSubsystem::GetSettings(const EBatchedTick Batch) const
+{
+	switch (Batch)
+	{
+	case EBatchedTick::Weapons:
+		return WeaponTick;
+	case EBatchedTick::InteractionWidgets:
+		return InteractionWidgetTick;
+	default:
+		return CharacterTick;
+	}
+}
+
+
+void UBatchedTickSubsystem::UpdateTickFunction(const EBatchedTick Batch)
+{
+	FBatchedTickFunction& TickFunction = TickFunctions[(uint8)Batch];
+
+	if (!TickFunction.IsTickFunctionRegistered())
+	{
+		ULevel* Level = GetWorld() ? GetWorld()->PersistentLevel : nullptr;
+
+		if (!Level)
+		{
+			return;
+		}
+
+		const FBatchedTickSettings& Settings = GetSettings(Batch);
+
+		TickFunction.Subsystem = this;
+		TickFunction.Batch = Batch;
+		TickFunction.bCanEverTick = true;
+		TickFunction.bStartWithTickEnabled = false;
+		TickFunction.TickGroup = Settings.TickGroup;
+		TickFunction.TickInterval = Settings.TickInterval;
+		TickFunction.RegisterTickFunction(Level);
+	}
+
+	const bool bShouldTick = GetNum(Batch) > 0;
+
+	if (TickFunction.IsTickFunctionEnabled() != bShouldTick)
+	{
+		TickFunction.SetTickFunctionEnable(bShouldTick);
+	}
+}
+
+
+void UBatchedTickSubsystem::TickBatch(const EBatchedTick Batch, const float DeltaTime)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	//Backwards, as ticking something can remove it from its batch and the last entry is swapped into its place
+	switch (Batch)
+	{
+	case EBatchedTick::Characters:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BatchedCharacterTick);
+
+		for (int32 i = Characters.Num() - 1; i >= 0; --i)
+		{
+			if (Characters.IsValidIndex(i) && Characters[i])
+			{
+				Characters[i]->TickInteraction(DeltaTime);
+			}
+		}
+
+		break;
+	}
+	case EBatchedTick::Weapons:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BatchedWeaponTick);
+
+		for (int32 i = Weapons.Num() - 1; i >= 0; --i)
+		{
+			if (Weapons.IsValidIndex(i) && Weapons[i])
+			{
+				Weapons[i]->HandleFiring();
+			}
+		}
+
+		break;
+	}
+	case EBatchedTick::InteractionWidgets:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BatchedInteractionWidgetTick);
+
+		for (int32 i = InteractionWidgets.Num() - 1; i >= 0; --i)
+		{
+			if (InteractionWidgets.IsValidIndex(i) && InteractionWidgets[i])
+			{
+				InteractionWidgets[i]->UpdateInteractionWidgetPosition();
+			}
+		}
+
+		break;
+	}
+	default:
+		break;
+	}
+
+	LastTickSeconds[(uint8)Batch] = FPlatformTime::Seconds() - StartTime;
+}
+
+
+static FAutoConsoleCommandWithWorldAndArgs TickAuditCommand(
+	TEXT("tick.Audit"),
+	TEXT("List the classes of every actor and component with a tick function enabled, and what the batched tick subsystem is ticking. Usage: tick.Audit [NumClasses]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		const int32 NumClasses = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10;
+
+		TMap<UClass*, int32> TickingClasses;
+		int32 NumActorTicks = 0;
+		int32 NumComponentTicks = 0;
+
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			if (It->PrimaryActorTick.IsTickFunctionEnabled())
+			{
+				++TickingClasses.FindOrAdd(It->GetClass());
+				++NumActorTicks;
+			}
+
+			for (UActorComponent* Component : It->GetComponents())
+			{
+				if (Component && Component->PrimaryComponentTick.IsTickFunctionEnabled())
+				{
+					++TickingClasses.FindOrAdd(Component->GetClass());
+					++NumComponentTicks;
+				}
+			}
+		}
+
+		TickingClasses.ValueSort([](const int32 A, const int32 B) { return A > B; });
+
+		UE_LOG(LogTemp, Log, TEXT("tick.Audit: %d actor ticks, %d component ticks enabled"), NumActorTicks, NumComponentTicks);
+
+		int32 NumLogged = 0;
+
+		for (const TPair<UClass*, int32>& TickingClass : TickingClasses)
+		{
+			if (NumLogged++ >= NumClasses)
+			{
+				break;
+			}
+
+			UE_LOG(LogTemp, Log, TEXT("  %-48s %d"), *TickingClass.Key->GetName(), TickingClass.Value);
+		}
+
+		if (const UBatchedTickSubsystem* BatchedTick = World->GetSubsystem<UBatchedTickSubsystem>())
+		{
+			for (uint8 Batch = 0; Batch < (uint8)EBatchedTick::MAX; ++Batch)
+			{
+				UE_LOG(LogTemp, Log, TEXT("  Batched %-40s %d, %.4fms last tick"), GetBatchName((EBatchedTick)Batch), BatchedTick->GetNum((EBatchedTick)Batch),
+					BatchedTick->GetLastTickSeconds((EBatchedTick)Batch) * 1000.0);
+			}
+		}
+	}));
+
+
+static FAutoConsoleCommandWithWorldAndArgs TickStressTestCommand(
+	TEXT("tick.StressTest"),
+	TEXT("Spawn characters and interactables around the first player, then log the average frame time and batched tick cost over a number of frames. Server only. Usage: tick.StressTest [Characters] [Interactables] [Frames]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const AGameModeBase* GameMode = World ? World->GetAuthGameMode() : nullptr;
+		const APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+
+		if (!GameMode || !PC || !PC->GetPawn())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("tick.StressTest: needs a server with a player"));
+			return;
+		}
+
+		const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(0, FCString::Atoi(*Args[0])) : 200;
+		const int32 NumInteractables = Args.Num() > 1 ? FMath::Max(0, FCString::Atoi(*Args[1])) : 5000;
+		const int32 NumFrames = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 300;
+
+		const FVector Origin = PC->GetPawn()->GetActorLocation();
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		//Lay them out on square grids around the player
+		const int32 CharactersPerRow = FMath::CeilToInt(FMath::Sqrt((float)NumCharacters));
+
+		for (int32 i = 0; i < NumCharacters; ++i)
+		{
+			const FVector Offset((i % CharactersPerRow - CharactersPerRow / 2) * 200.f, (i / CharactersPerRow + 1) * 200.f, 0.f);
+			World->SpawnActor<APawn>(GameMode->DefaultPawnClass, Origin + Offset, FRotator::ZeroRotator, SpawnParams);
+		}
+
+		const int32 InteractablesPerRow = FMath::CeilToInt(FMath::Sqrt((float)NumInteractables));
+
+		for (int32 i = 0; i < NumInteractables; ++i)
+		{
+			const FVector Offset((i % InteractablesPerRow - InteractablesPerRow / 2) * 100.f, -(i / InteractablesPerRow + 1) * 100.f, 0.f);
+			World->SpawnActor<APickup>(APickup::StaticClass(), Origin + Offset, FRotator::ZeroRotator, SpawnParams);
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("tick.StressTest: spawned %d characters and %d interactables, measuring %d frames"), NumCharacters, NumInteractables, NumFrames);
+
+		//Skip the frames where everything we just spawned is still settling, then average the rest
+		static const int32 NumWarmupFrames = 30;
+
+		struct FStressTestSamples
+		{
+			int32 Frame = 0;
+			double FrameSeconds = 0.0;
+			double MaxFrameSeconds = 0.0;
+			double BatchSeconds[(uint8)EBatchedTick::MAX] = {};
+		};
+
+		TSharedRef<FStressTestSamples> Samples = MakeShared<FStressTestSamples>();
+		TWeakObjectPtr<UWorld> WeakWorld = World;
+
+		FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Samples, WeakWorld, NumFrames](float DeltaTime)
+		{
+			UWorld* TestWorld = WeakWorld.Get();
+
+			if (!TestWorld)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("tick.StressTest: world went away before the measurement finished"));
+				return false;
+			}
+
+			if (Samples->Frame++ < NumWarmupFrames)
+			{
+				return true;
+			}
+
+			Samples->FrameSeconds += FApp::GetDeltaTime();
+			Samples->MaxFrameSeconds = FMath::Max(Samples->MaxFrameSeconds, FApp::GetDeltaTime());
+
+			const UBatchedTickSubsystem* BatchedTick = TestWorld->GetSubsystem<UBatchedTickSubsystem>();
+
+			for (uint8 Batch = 0; Batch < (uint8)EBatchedTick::MAX; ++Batch)
+			{
+				Samples->BatchSeconds[Batch] += BatchedTick ? BatchedTick->GetLastTickSeconds((EBatchedTick)Batch) : 0.0;
+			}
+
+			if (Samples->Frame - NumWarmupFrames < NumFrames)
+			{
+				return true;
+			}
+
+			UE_LOG(LogTemp, Log, TEXT("tick.StressTest: %d frames, %.3fms average frame, %.3fms worst frame"), NumFrames,
+				Samples->FrameSeconds / NumFrames * 1000.0, Samples->MaxFrameSeconds * 1000.0);
+
+			for (uint8 Batch = 0; Batch < (uint8)EBatchedTick::MAX; ++Batch)
+			{
+				UE_LOG(LogTemp, Log, TEXT("  Batched %-40s %d, %.4fms average tick"), GetBatchName((EBatchedTick)Batch),
+					BatchedTick ? BatchedTick->GetNum((EBatchedTick)Batch) : 0, Samples->BatchSeconds[Batch] / NumFrames * 1000.0);
+			}
+
+			return false;
+		}));
+	}));
@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/CharacterSignificanceSubsystem.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/InteractionComponent.h"
+#include "Components/InventoryComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "Framework/MeshMergeSubsystem.h"
+#include "GameFramework/PlayerController.h"
+#include "Player/ShooterProjectCharacter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Character Significance"), STAT_CharacterSignificance, STATGROUP_Characters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Critical Significance Characters"), STAT_CriticalSignificanceCharacters, STATGROUP_Characters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("High Significance Characters"), STAT_HighSignificanceCharacters, STATGROUP_Characters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Medium Significance Characters"), STAT_MediumSignificanceCharacters, STATGROUP_Characters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Low Significance Characters"), STAT_LowSignificanceCharacters, STATGROUP_Characters);
+
+UCharacterSignificanceSubsystem::UCharacterSignificanceSubsystem()
+{
+	CriticalDistance = 1000.f;
+	HighScreenSize = 0.3f;
+	MediumScreenSize = 0.1f;
+	UpdateInterval = 0.2f;
+	TimeSinceUpdate = 0.f;
+
+	CriticalUpdateRate.NonRenderedUpdateRate = 1;
+
+	HighUpdateRate.VisibleScreenSizeThresholds = { 0.24f, 0.12f };
+	HighUpdateRate.NonRenderedUpdateRate = 4;
+
+	MediumUpdateRate.VisibleScreenSizeThresholds = { 1.f, 0.24f, 0.12f };
+	MediumUpdateRate.NonRenderedUpdateRate = 8;
+
+	LowUpdateRate.VisibleScreenSizeThresholds = { 1.f, 0.5f, 0.24f, 0.12f };
+	LowUpdateRate.NonRenderedUpdateRate = 16;
+}
+
+
+bool UCharacterSignificanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	//Dedicated servers have no local player for anything to be significant to
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && !IsRunningDedicatedServer();
+}
+
+
+void UCharacterSignificanceSubsystem::Deinitialize()
+{
+	Characters.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UCharacterSignificanceSubsystem::RegisterCharacter(AShooterProjectCharacter* Character)
+{
+	if (Character)
+	{
+		Characters.AddUnique(Character);
+	}
+}
+
+
+void UCharacterSignificanceSubsystem::UnregisterCharacter(AShooterProjectCharacter* Character)
+{
+	Characters.RemoveSwap(Character);
+}
+
+
+const FSignificanceUpdateRate& UCharacterSignificanceSubsystem::GetUpdateRate(const ECharacterSignificance Significance) const
+{
+	switch (Significance)
+	{
+	case ECharacterSignificance::High:
+		return HighUpdateRate;
+	case ECharacterSignificance::Medium:
+		return MediumUpdateRate;
+	case ECharacterSignificance::Low:
+		return LowUpdateRate;
+	default:
+		return CriticalUpdateRate;
+	}
+}
+
+
+ECharacterSignificance UCharacterSignificanceSubsystem::CalculateSignificance(const AShooterProjectCharacter* Character, const FVector& ViewLocation, const float ScreenSizeScale, const AShooterProjectCharacter* LocalCharacter) const
+{
+	if (Character->IsLocallyControlled())
+	{
+		return ECharacterSignificance::Critical;
+	}
+
+	//Whoever we are looting or looking at gets our full attention
+	if (LocalCharacter)
+	{
+		const UInventoryComponent* LootSource = LocalCharacter->GetLootSource();
+		const UInteractionComponent* Interactable = LocalCharacter->GetInteractable();
+
+		if ((LootSource && LootSource->GetOwner() == Character) || (Interactable && Interactable->GetOwner() == Character))
+		{
+			return ECharacterSignificance::Critical;
+		}
+	}
+
+	const USkeletalMeshComponent* Mesh = Character->GetMesh();
+	const float Distance = FVector::Dist(ViewLocation, Mesh->Bounds.Origin);
+
+	if (Distance < CriticalDistance)
+	{
+		return ECharacterSignificance::Critical;
+	}
+
+	if (!Mesh->WasRecentlyRendered(0.5f))
+	{
+		return ECharacterSignificance::Low;
+	}
+
+	//Roughly how much of the screen's height the character covers
+	const float ScreenSize = (Mesh->Bounds.SphereRadius * ScreenSizeScale) / Distance;
+
+	if (ScreenSize >= HighScreenSize)
+	{
+		return ECharacterSignificance::High;
+	}
+
+	return ScreenSize >= MediumScreenSize ? ECharacterSignificance::Medium : ECharacterSignificance::Low;
+}
+
+
+void UCharacterSignificanceSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate < UpdateInterval)
+	{
+		return;
+	}
+
+	TimeSinceUpdate = 0.f;
+
+	SCOPE_CYCLE_COUNTER(STAT_CharacterSignificance);
+
+	const APlayerController* PC = GetWorld()->GetFirstPlayerController();
+
+	if (!PC || !PC->PlayerCameraManager)
+	{
+		return;
+	}
+
+	const FVector ViewLocation = PC->PlayerCameraManager->GetCameraLocation();
+	const float ScreenSizeScale = 1.f / FMath::Tan(FMath::DegreesToRadians(PC->PlayerCameraManager->GetFOVAngle() * 0.5f));
+	const AShooterProjectCharacter* LocalCharacter = Cast<AShooterProjectCharacter>(PC->GetPawn());
+
+	int32 NumCharacters[(uint8)ECharacterSignificance::MAX] = {};
+
+	for (int32 i = Characters.Num() - 1; i >= 0; --i)
+	{
+		if (AShooterProjectCharacter* Character = Characters[i].Get())
+		{
+			const ECharacterSignificance Significance = CalculateSignificance(Character, ViewLocation, ScreenSizeScale, LocalCharacter);
+			Character->SetSignificance(Significance, GetUpdateRate(Significance));
+			++NumCharacters[(uint8)Significance];
+		}
+		else
+		{
+			Characters.RemoveAtSwap(i, 1, false);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_CriticalSignificanceCharacters, NumCharacters[(uint8)ECharacterSignificance::Critical]);
+	SET_DWORD_STAT(STAT_HighSignificanceCharacters, NumCharacters[(uint8)ECharacterSignificance::High]);
+	SET_DWORD_STAT(STAT_MediumSignificanceCharacters, NumCharacters[(uint8)ECharacterSignificance::Medium]);
+	SET_DWORD_STAT(STAT_LowSignificanceCharacters, NumCharacters[(uint8)ECharacterSignificance::Low]);
+}
+
+
+bool UCharacterSignificanceSubsystem::IsTickable() const
+{
+	return Characters.Num() > 0;
+}
+
+
+ETickableTickType UCharacterSignificanceSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+UWorld* UCharacterSignificanceSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+
+TStatId UCharacterSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCharacterSignificanceSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/DamageQueueSubsystem.h"
+#include "Engine/World.h"
+#include "Framework/LagCompensationSubsystem.h"
+#include "GameFramework/DamageType.h"
+#include "Player/ShooterProjectCharacter.h"
+#include "Player/ShooterProjectPlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Damage Queue"), STAT_DamageQueue, STATGROUP_Combat);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events This Frame"), STAT_DamageEventsThisFrame, STATGROUP_Combat);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damaged Characters This Frame"), STAT_DamagedCharactersThisFrame, STATGROUP_Combat);
+
+bool UDamageQueueSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UDamageQueueSubsystem::Deinitialize()
+{
+	PendingDamage.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UDamageQueueSubsystem::QueueDamage(AShooterProjectCharacter* Victim, const float Damage, const FDamageEvent& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	if (Victim && Victim->HasAuthority() && Damage > 0.f)
+	{
+		FPendingDamage& Pending = PendingDamage.AddDefaulted_GetRef();
+		Pending.Victim = Victim;
+		Pending.EventInstigator = EventInstigator;
+		Pending.DamageCauser = DamageCauser;
+		Pending.DamageTypeClass = DamageEvent.DamageTypeClass;
+		Pending.Damage = Damage;
+
+		if (DamageEvent.IsOfType(FPointDamageEvent::ClassID))
+		{
+			Pending.HitBone = static_cast<const FPointDamageEvent&>(DamageEvent).HitInfo.BoneName;
+		}
+	}
+}
+
+
+void UDamageQueueSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DamageQueue);
+
+	INC_DWORD_STAT_BY(STAT_DamageEventsThisFrame, PendingDamage.Num());
+
+	//Group damage by victim. Each victim's damage keeps the order it happened in, so the killing blow is the right one.
+	PendingDamage.StableSort([](const FPendingDamage& A, const FPendingDamage& B)
+	{
+		return A.Victim.Get() < B.Victim.Get();
+	});
+
+	int32 First = 0;
+
+	while (First < PendingDamage.Num())
+	{
+		AShooterProjectCharacter* Victim = PendingDamage[First].Victim.Get();
+
+		int32 Last = First + 1;
+
+		while (Last < PendingDamage.Num() && PendingDamage[Last].Victim.Get() == Victim)
+		{
+			++Last;
+		}
+
+		if (Victim)
+		{
+			ApplyVictimDamage(Victim, First, Last);
+			INC_DWORD_STAT(STAT_DamagedCharactersThisFrame);
+		}
+
+		First = Last;
+	}
+
+	PendingDamage.Reset();
+}
+
+
+void UDamageQueueSubsystem::ApplyVictimDamage(AShooterProjectCharacter* Victim, const int32 First, const int32 Last)
+{
+	//Someone may have killed them earlier this frame, they don't die twice
+	if (!Victim->IsAlive())
+	{
+		return;
+	}
+
+	float RemainingHealth = Victim->GetHealth();
+	float TotalDamage = 0.f;
+	int32 KillingBlow = INDEX_NONE;
+
+	InstigatorDamage.Reset();
+
+	for (int32 i = First; i < Last; ++i)
+	{
+		const FPendingDamage& Pending = PendingDamage[i];
+
+		//Damage past zero health doesn't count, so hit markers only show what was actually dealt
+		const float Damage = FMath::Min(Pending.Damage * Victim->GetDamageTakenMultiplier(Pending.HitBone), FMath::Max(RemainingHealth, 0.f));
+
+		RemainingHealth -= Damage;
+		TotalDamage += Damage;
+
+		if (KillingBlow == INDEX_NONE && RemainingHealth <= 0.f)
+		{
+			KillingBlow = i;
+		}
+
+		if (AController* EventInstigator = Pending.EventInstigator.Get())
+		{
+			if (TPair<AController*, float>* Existing = InstigatorDamage.FindByPredicate([EventInstigator](const TPair<AController*, float>& Pair) { return Pair.Key == EventInstigator; }))
+			{
+				Existing->Value += Damage;
+			}
+			else
+			{
+				InstigatorDamage.Emplace(EventInstigator, Damage);
+			}
+		}
+	}
+
+	const FPendingDamage& LastDamage = PendingDamage[KillingBlow != INDEX_NONE ? KillingBlow : Last - 1];
+	const FDamageEvent DamageEvent(LastDamage.DamageTypeClass);
+
+	const bool bKilled = Victim->ApplyQueuedDamage(TotalDamage, DamageEvent, LastDamage.EventInstigator.Get(), LastDamage.DamageCauser.Get());
+
+	for (const TPair<AController*, float>& Pair : InstigatorDamage)
+	{
+		//Only the player that landed the killing blow gets a kill marker
+		const bool bKillingBlow = bKilled && Pair.Key == LastDamage.EventInstigator.Get();
+
+		if (AShooterProjectPlayerController* PC = Cast<AShooterProjectPlayerController>(Pair.Key))
+		{
+			if (Pair.Key != Victim->GetController() && (Pair.Value > 0.f || bKillingBlow))
+			{
+				PC->ClientHitMarker(Victim, (uint16)FMath::Clamp(FMath::RoundToInt(Pair.Value), 0, (int32)MAX_uint16), bKillingBlow);
+			}
+		}
+	}
+}
+
+
+bool UDamageQueueSubsystem::IsTickable() const
+{
+	return PendingDamage.Num() > 0;
+}
+
+
+ETickableTickType UDamageQueueSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+UWorld* UDamageQueueSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+
+TStatId UDamageQueueSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDamageQueueSubsystem, STATGROUP_Tickables);
+}
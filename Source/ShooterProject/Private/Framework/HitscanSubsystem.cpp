@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/HitscanSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Items/WeaponClass.h"
+#include "Kismet/GameplayStatics.h"
+#include "ShooterProject/ShooterProject.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hitscan Traces"), STAT_HitscanTraces, STATGROUP_Combat);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Shots This Frame"), STAT_HitscanShotsThisFrame, STATGROUP_Combat);
+
+bool UHitscanSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UHitscanSubsystem::Deinitialize()
+{
+	PendingShots.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UHitscanSubsystem::QueueShot(AWeaponClass* Weapon, const FVector& Start, const FVector& End)
+{
+	if (Weapon && Weapon->HasAuthority())
+	{
+		FPendingShot& PendingShot = PendingShots.AddDefaulted_GetRef();
+		PendingShot.Weapon = Weapon;
+		PendingShot.Start = Start;
+		PendingShot.End = End;
+	}
+}
+
+
+void UHitscanSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HitscanTraces);
+
+	INC_DWORD_STAT_BY(STAT_HitscanShotsThisFrame, PendingShots.Num());
+
+	//Group shots by weapon so every weapon gets one batch of results. Shots from the same weapon stay in the order they were fired.
+	PendingShots.StableSort([](const FPendingShot& A, const FPendingShot& B)
+	{
+		return A.Weapon.Get() < B.Weapon.Get();
+	});
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitscanShot), false);
+	FHitscanShotsFired ShotsFired;
+
+	int32 ShotIndex = 0;
+
+	while (ShotIndex < PendingShots.Num())
+	{
+		AWeaponClass* Weapon = PendingShots[ShotIndex].Weapon.Get();
+
+		QueryParams.ClearIgnoredActors();
+		QueryParams.AddIgnoredActor(Weapon);
+		QueryParams.AddIgnoredActor(Weapon ? Weapon->GetOwner() : nullptr);
+
+		ShotsFired.Origin = PendingShots[ShotIndex].Start;
+		ShotsFired.Impacts.Reset();
+
+		APawn* PawnOwner = Weapon ? Cast<APawn>(Weapon->GetOwner()) : nullptr;
+		AController* InstigatorController = PawnOwner ? PawnOwner->GetController() : nullptr;
+
+		for (; ShotIndex < PendingShots.Num() && PendingShots[ShotIndex].Weapon.Get() == Weapon; ++ShotIndex)
+		{
+			//The weapon went away before we got to its shots
+			if (!Weapon)
+			{
+				continue;
+			}
+
+			const FPendingShot& PendingShot = PendingShots[ShotIndex];
+
+			FHitResult Hit;
+			FHitscanImpact& Impact = ShotsFired.Impacts.AddDefaulted_GetRef();
+
+			if (GetWorld()->LineTraceSingleByChannel(Hit, PendingShot.Start, PendingShot.End, COLLISION_WEAPON, QueryParams))
+			{
+				Impact.Location = Hit.ImpactPoint;
+				Impact.Normal = Hit.ImpactNormal;
+				Impact.bBlockingHit = true;
+
+				UGameplayStatics::ApplyPointDamage(Hit.GetActor(), Weapon->ShotDamage, (PendingShot.End - PendingShot.Start).GetSafeNormal(), Hit, InstigatorController, Weapon, Weapon->ShotDamageType);
+			}
+			else
+			{
+				Impact.Location = PendingShot.End;
+			}
+		}
+
+		if (Weapon && ShotsFired.Impacts.Num() > 0)
+		{
+			Weapon->OnHitscanShotsResolved(ShotsFired);
+		}
+	}
+
+	PendingShots.Reset();
+}
+
+
+bool UHitscanSubsystem::IsTickable() const
+{
+	return PendingShots.Num() > 0;
+}
+
+
+ETickableTickType UHitscanSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+UWorld* UHitscanSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+
+TStatId UHitscanSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitscanSubsystem, STATGROUP_Tickables);
+}
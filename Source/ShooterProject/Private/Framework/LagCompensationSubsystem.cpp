@@ -0,0 +1,488 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/LagCompensationSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "Player/ShooterProjectCharacter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_LagCompensationRecord, STATGROUP_Combat);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Rewind"), STAT_LagCompensationRewind, STATGROUP_Combat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Lag Compensated Characters"), STAT_LagCompensatedCharacters, STATGROUP_Combat);
+
+ULagCompensationSubsystem::ULagCompensationSubsystem()
+{
+	HistoryFrames = 64;
+	MaxRewindTime = 0.5f;
+	HitTolerance = 10.f;
+	bRecordHitboxes = true;
+	HitboxRecordRadius = 1500.f;
+}
+
+
+bool ULagCompensationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void ULagCompensationSubsystem::Deinitialize()
+{
+	Histories.Empty();
+	HistoryIndices.Empty();
+	SET_DWORD_STAT(STAT_LagCompensatedCharacters, 0);
+
+	Super::Deinitialize();
+}
+
+
+void ULagCompensationSubsystem::RegisterCharacter(AShooterProjectCharacter* Character)
+{
+	if (Character && Character->HasAuthority() && !HistoryIndices.Contains(Character))
+	{
+		HistoryIndices.Add(Character, Histories.Num());
+		InitializeHistory(Histories.AddDefaulted_GetRef(), Character);
+
+		SET_DWORD_STAT(STAT_LagCompensatedCharacters, Histories.Num());
+	}
+}
+
+
+void ULagCompensationSubsystem::UnregisterCharacter(AShooterProjectCharacter* Character)
+{
+	int32 HistoryIndex;
+
+	if (HistoryIndices.RemoveAndCopyValue(Character, HistoryIndex))
+	{
+		Histories.RemoveAtSwap(HistoryIndex, 1, false);
+
+		//The last history was moved into the removed slot, so point its character at the new index
+		if (Histories.IsValidIndex(HistoryIndex))
+		{
+			HistoryIndices.Add(Histories[HistoryIndex].Character.Get(), HistoryIndex);
+		}
+
+		SET_DWORD_STAT(STAT_LagCompensatedCharacters, Histories.Num());
+	}
+}
+
+
+void ULagCompensationSubsystem::InitializeHistory(FPoseHistory& History, AShooterProjectCharacter* Character) const
+{
+	History.Character = Character;
+
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	History.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	History.CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+	//Build a capsule for each body in the physics asset. Spheres are capsules with no length, and boxes get the capsule around their longest side.
+	const USkeletalMeshComponent* Mesh = Character->GetMesh();
+	const UPhysicsAsset* PhysicsAsset = bRecordHitboxes && Mesh ? Mesh->GetPhysicsAsset() : nullptr;
+
+	if (PhysicsAsset)
+	{
+		for (const USkeletalBodySetup* BodySetup : PhysicsAsset->SkeletalBodySetups)
+		{
+			const int32 BoneIndex = BodySetup ? Mesh->GetBoneIndex(BodySetup->BoneName) : INDEX_NONE;
+
+			if (BoneIndex == INDEX_NONE)
+			{
+				continue;
+			}
+
+			const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+
+			FVector Center;
+			FVector Axis;
+			float Radius;
+			float HalfLength;
+
+			if (AggGeom.SphylElems.Num() > 0)
+			{
+				const FKSphylElem& Sphyl = AggGeom.SphylElems[0];
+				Center = Sphyl.Center;
+				Axis = Sphyl.Rotation.Quaternion().GetAxisZ();
+				Radius = Sphyl.Radius;
+				HalfLength = Sphyl.Length * 0.5f;
+			}
+			else if (AggGeom.SphereElems.Num() > 0)
+			{
+				const FKSphereElem& Sphere = AggGeom.SphereElems[0];
+				Center = Sphere.Center;
+				Axis = FVector::UpVector;
+				Radius = Sphere.Radius;
+				HalfLength = 0.f;
+			}
+			else if (AggGeom.BoxElems.Num() > 0)
+			{
+				const FKBoxElem& Box = AggGeom.BoxElems[0];
+				const FVector HalfExtents = FVector(Box.X, Box.Y, Box.Z) * 0.5f;
+				const FQuat BoxRotation = Box.Rotation.Quaternion();
+
+				Center = Box.Center;
+
+				if (HalfExtents.X >= HalfExtents.Y && HalfExtents.X >= HalfExtents.Z)
+				{
+					Axis = BoxRotation.GetAxisX();
+					Radius = FMath::Max(HalfExtents.Y, HalfExtents.Z);
+					HalfLength = HalfExtents.X;
+				}
+				else if (HalfExtents.Y >= HalfExtents.Z)
+				{
+					Axis = BoxRotation.GetAxisY();
+					Radius = FMath::Max(HalfExtents.X, HalfExtents.Z);
+					HalfLength = HalfExtents.Y;
+				}
+				else
+				{
+					Axis = BoxRotation.GetAxisZ();
+					Radius = FMath::Max(HalfExtents.X, HalfExtents.Y);
+					HalfLength = HalfExtents.Z;
+				}
+
+				HalfLength = FMath::Max(HalfLength - Radius, 0.f);
+			}
+			else
+			{
+				continue;
+			}
+
+			History.HitboxBoneIndices.Add(BoneIndex);
+			History.HitboxBoneNames.Add(BodySetup->BoneName);
+			History.HitboxLocalCenters.Add(Center);
+			History.HitboxLocalAxes.Add(Axis);
+			History.HitboxRadii.Add(Radius);
+			History.HitboxHalfLengths.Add(HalfLength);
+		}
+	}
+
+	const int32 NumFrames = FMath::Max(HistoryFrames, 2);
+
+	History.Timestamps.SetNumZeroed(NumFrames);
+	History.HitboxesRecorded.SetNumZeroed(NumFrames);
+	History.CapsuleLocations.SetNumZeroed(NumFrames);
+	History.CapsuleAxes.SetNumZeroed(NumFrames);
+	History.HitboxCenters.SetNumZeroed(NumFrames * History.NumHitboxes());
+	History.HitboxAxes.SetNumZeroed(NumFrames * History.NumHitboxes());
+}
+
+
+void ULagCompensationSubsystem::RecordPose(FPoseHistory& History, const float Timestamp) const
+{
+	const AShooterProjectCharacter* Character = History.Character.Get();
+
+	if (!Character)
+	{
+		return;
+	}
+
+	const int32 Slot = (History.Head + 1) % History.Timestamps.Num();
+
+	History.Head = Slot;
+	History.NumFrames = FMath::Min(History.NumFrames + 1, History.Timestamps.Num());
+
+	const FTransform CapsuleTransform = Character->GetCapsuleComponent()->GetComponentTransform();
+
+	History.Timestamps[Slot] = Timestamp;
+	History.CapsuleLocations[Slot] = CapsuleTransform.GetLocation();
+	History.CapsuleAxes[Slot] = CapsuleTransform.GetUnitAxis(EAxis::Z);
+
+	//The bones are only up to date if the character was told to refresh them before its mesh ticked this frame
+	const int32 NumHitboxes = History.bRefreshingPose ? History.NumHitboxes() : 0;
+
+	History.HitboxesRecorded[Slot] = NumHitboxes > 0;
+
+	if (NumHitboxes > 0)
+	{
+		const USkeletalMeshComponent* Mesh = Character->GetMesh();
+		const TArray<FTransform>& BoneTransforms = Mesh->GetComponentSpaceTransforms();
+		const FTransform& ComponentTransform = Mesh->GetComponentTransform();
+
+		FVector* Centers = History.HitboxCenters.GetData() + (Slot * NumHitboxes);
+		FVector* Axes = History.HitboxAxes.GetData() + (Slot * NumHitboxes);
+
+		for (int32 i = 0; i < NumHitboxes; ++i)
+		{
+			const int32 BoneIndex = History.HitboxBoneIndices[i];
+
+			//The mesh may have been swapped to one with fewer bones, fall back to the component so we never read junk
+			const FTransform BoneTransform = BoneTransforms.IsValidIndex(BoneIndex) ? BoneTransforms[BoneIndex] * ComponentTransform : ComponentTransform;
+
+			Centers[i] = BoneTransform.TransformPosition(History.HitboxLocalCenters[i]);
+			Axes[i] = BoneTransform.TransformVectorNoScale(History.HitboxLocalAxes[i]);
+		}
+	}
+}
+
+
+bool ULagCompensationSubsystem::FindFrames(const FPoseHistory& History, const float Timestamp, int32& OutOlder, int32& OutNewer, float& OutAlpha) const
+{
+	if (History.NumFrames == 0)
+	{
+		return false;
+	}
+
+	const int32 Capacity = History.Timestamps.Num();
+
+	auto GetSlot = [&History, Capacity](const int32 Age)
+	{
+		return (History.Head - Age + Capacity) % Capacity;
+	};
+
+	OutAlpha = 0.f;
+
+	//Timestamps get older as age goes up, so binary search for the newest frame that isn't after the timestamp
+	int32 Low = 0;
+	int32 High = History.NumFrames - 1;
+
+	if (Timestamp >= History.Timestamps[GetSlot(0)])
+	{
+		OutOlder = OutNewer = GetSlot(0);
+		return true;
+	}
+
+	if (Timestamp <= History.Timestamps[GetSlot(High)])
+	{
+		OutOlder = OutNewer = GetSlot(High);
+		return true;
+	}
+
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+
+		if (History.Timestamps[GetSlot(Mid)] <= Timestamp)
+		{
+			High = Mid;
+		}
+		else
+		{
+			Low = Mid + 1;
+		}
+	}
+
+	OutOlder = GetSlot(Low);
+	OutNewer = GetSlot(Low - 1);
+
+	const float FrameTime = History.Timestamps[OutNewer] - History.Timestamps[OutOlder];
+	OutAlpha = FrameTime > KINDA_SMALL_NUMBER ? (Timestamp - History.Timestamps[OutOlder]) / FrameTime : 0.f;
+
+	return true;
+}
+
+
+bool ULagCompensationSubsystem::ValidateSweep(const AShooterProjectCharacter* Target, const FVector& TraceStart, const FVector& TraceEnd, const float SweepRadius, const float Timestamp, const FName HitBone) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRewind);
+
+	const int32* HistoryIndex = HistoryIndices.Find(Target);
+
+	if (!HistoryIndex)
+	{
+		return false;
+	}
+
+	const FPoseHistory& History = Histories[*HistoryIndex];
+
+	//Don't let clients rewind further than we allow or into the future
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float RewindTime = FMath::Clamp(Timestamp, Now - MaxRewindTime, Now);
+
+	int32 Older;
+	int32 Newer;
+	float Alpha;
+
+	if (!FindFrames(History, RewindTime, Older, Newer, Alpha))
+	{
+		return false;
+	}
+
+	//Tests a capsule in the rewound pose against the sweep. Both are segments with a radius, so this is just the distance between two segments.
+	auto SweepHitsCapsule = [&](const FVector& Center, const FVector& Axis, const float Radius, const float HalfLength)
+	{
+		const FVector HalfSegment = Axis.GetSafeNormal() * HalfLength;
+
+		FVector OnSweep;
+		FVector OnCapsule;
+		FMath::SegmentDistToSegmentSafe(TraceStart, TraceEnd, Center - HalfSegment, Center + HalfSegment, OnSweep, OnCapsule);
+
+		return FVector::DistSquared(OnSweep, OnCapsule) <= FMath::Square(Radius + SweepRadius + HitTolerance);
+	};
+
+	const int32 NumHitboxes = History.NumHitboxes();
+
+	//Nobody was near enough to hit the character at the time, so we only have its capsule
+	if (NumHitboxes == 0 || !History.HitboxesRecorded[Older] || !History.HitboxesRecorded[Newer])
+	{
+		const FVector Center = FMath::Lerp(History.CapsuleLocations[Older], History.CapsuleLocations[Newer], Alpha);
+		const FVector Axis = FMath::Lerp(History.CapsuleAxes[Older], History.CapsuleAxes[Newer], Alpha);
+
+		return SweepHitsCapsule(Center, Axis, History.CapsuleRadius, History.CapsuleHalfHeight - History.CapsuleRadius);
+	}
+
+	const FVector* OlderCenters = History.HitboxCenters.GetData() + (Older * NumHitboxes);
+	const FVector* NewerCenters = History.HitboxCenters.GetData() + (Newer * NumHitboxes);
+	const FVector* OlderAxes = History.HitboxAxes.GetData() + (Older * NumHitboxes);
+	const FVector* NewerAxes = History.HitboxAxes.GetData() + (Newer * NumHitboxes);
+
+	auto SweepHitsHitbox = [&](const int32 i)
+	{
+		return SweepHitsCapsule(FMath::Lerp(OlderCenters[i], NewerCenters[i], Alpha), FMath::Lerp(OlderAxes[i], NewerAxes[i], Alpha), History.HitboxRadii[i], History.HitboxHalfLengths[i]);
+	};
+
+	//If the client told us which bone it hit, only that bone counts
+	const int32 HitBoneIndex = HitBone.IsNone() ? INDEX_NONE : History.HitboxBoneNames.IndexOfByKey(HitBone);
+
+	if (HitBoneIndex != INDEX_NONE)
+	{
+		return SweepHitsHitbox(HitBoneIndex);
+	}
+
+	for (int32 i = 0; i < NumHitboxes; ++i)
+	{
+		if (SweepHitsHitbox(i))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void ULagCompensationSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRecord);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (FPoseHistory& History : Histories)
+	{
+		RecordPose(History, Now);
+	}
+
+	UpdatePoseRefresh();
+}
+
+
+void ULagCompensationSubsystem::UpdatePoseRefresh()
+{
+	const float RecordRadiusSquared = FMath::Square(HitboxRecordRadius);
+
+	TArray<FVector, TInlineAllocator<64>> Locations;
+
+	for (const FPoseHistory& History : Histories)
+	{
+		Locations.Add(History.Head != INDEX_NONE ? History.CapsuleLocations[History.Head] : FVector::ZeroVector);
+	}
+
+	for (int32 i = 0; i < Histories.Num(); ++i)
+	{
+		FPoseHistory& History = Histories[i];
+		AShooterProjectCharacter* Character = History.Character.Get();
+
+		if (!Character || History.NumHitboxes() == 0)
+		{
+			continue;
+		}
+
+		bool bNeedsPose = HitboxRecordRadius <= 0.f;
+
+		for (int32 j = 0; j < Locations.Num() && !bNeedsPose; ++j)
+		{
+			bNeedsPose = j != i && Histories[j].Character.IsValid() && FVector::DistSquared(Locations[i], Locations[j]) <= RecordRadiusSquared;
+		}
+
+		if (History.bRefreshingPose != bNeedsPose)
+		{
+			History.bRefreshingPose = bNeedsPose;
+			Character->SetRecordingHitboxes(bNeedsPose);
+		}
+	}
+}
+
+
+bool ULagCompensationSubsystem::IsTickable() const
+{
+	return Histories.Num() > 0;
+}
+
+
+ETickableTickType ULagCompensationSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+UWorld* ULagCompensationSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkLagCompensationCommand(
+	TEXT("lagcomp.Benchmark"),
+	TEXT("[Server] Validate N sweeps against the recorded poses of every character in the world and print the average cost per shot. Usage: lagcomp.Benchmark [Shots]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const ULagCompensationSubsystem* LagCompensation = World ? World->GetSubsystem<ULagCompensationSubsystem>() : nullptr;
+
+		if (!LagCompensation)
+		{
+			return;
+		}
+
+		TArray<const AShooterProjectCharacter*> Characters;
+
+		for (TActorIterator<AShooterProjectCharacter> It(World); It; ++It)
+		{
+			if (It->HasAuthority())
+			{
+				Characters.Add(*It);
+			}
+		}
+
+		if (Characters.Num() == 0)
+		{
+			UE_LOG(LogTemp, Log, TEXT("lagcomp.Benchmark: no characters to rewind, run this on the server with characters spawned"));
+			return;
+		}
+
+		const int32 NumShots = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+		const float Now = World->GetTimeSeconds();
+
+		FRandomStream RandomStream(NumShots);
+		int32 NumHits = 0;
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		//Swing at each target from a random side at a random time in the rewind window, like a melee hit from a laggy client
+		for (int32 i = 0; i < NumShots; ++i)
+		{
+			const AShooterProjectCharacter* Target = Characters[i % Characters.Num()];
+			const FVector TargetLocation = Target->GetActorLocation();
+			const FVector TraceStart = TargetLocation + RandomStream.GetUnitVector() * 150.f;
+
+			if (LagCompensation->ValidateSweep(Target, TraceStart, TargetLocation, 10.f, Now - RandomStream.FRandRange(0.f, 0.5f)))
+			{
+				++NumHits;
+			}
+		}
+
+		const double TotalTime = FPlatformTime::Seconds() - StartTime;
+
+		UE_LOG(LogTemp, Log, TEXT("lagcomp.Benchmark: %d shots against %d characters, %d hit, hitboxes %s"), NumShots, Characters.Num(), NumHits, LagCompensation->IsRecordingHitboxes() ? TEXT("on") : TEXT("off"));
+		UE_LOG(LogTemp, Log, TEXT("  %.3fus per shot"), (TotalTime / NumShots) * 1000000.0);
+	}));
@@ -0,0 +1,321 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/LocomotionSubsystem.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Framework/MeshMergeSubsystem.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Player/PlayerAnimInstance.h"
+#include "Player/ShooterProjectCharacter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Locomotion Kernel"), STAT_LocomotionKernel, STATGROUP_Characters);
+
+void FLocomotionBuffer::SetNum(const int32 NewNum)
+{
+	NumCharacters = NewNum;
+
+	const int32 NumPadded = Align(NewNum, 4);
+
+	for (TArray<float>* Field : { &VelocityX, &VelocityY, &VelocityZ, &Yaw, &MovementMode, &Speed, &Direction, &InAir })
+	{
+		Field->Reset(NumPadded);
+		Field->AddZeroed(NumPadded);
+	}
+}
+
+
+void FLocomotionBuffer::Set(const int32 Index, const FVector& Velocity, const float InYaw, const uint8 InMovementMode)
+{
+	VelocityX[Index] = Velocity.X;
+	VelocityY[Index] = Velocity.Y;
+	VelocityZ[Index] = Velocity.Z;
+	Yaw[Index] = InYaw;
+	MovementMode[Index] = (float)InMovementMode;
+}
+
+
+/** Four atan2s at once, from a polynomial fit of atan on [0, 1] that is then mirrored into the right octant.
+Max error is about 0.012 degrees, far below anything an animation blend can show. */
+static FORCEINLINE VectorRegister VectorATan2Approx(const VectorRegister& Y, const VectorRegister& X)
+{
+	const VectorRegister AbsX = VectorAbs(X);
+	const VectorRegister AbsY = VectorAbs(Y);
+
+	//The epsilon keeps 0/0 from giving us NaNs, standing still comes out as zero
+	const VectorRegister MaxAbs = VectorMax(VectorMax(AbsX, AbsY), VectorSetFloat1(SMALL_NUMBER));
+	const VectorRegister A = VectorDivide(VectorMin(AbsX, AbsY), MaxAbs);
+	const VectorRegister S = VectorMultiply(A, A);
+
+	VectorRegister Angle = VectorMultiplyAdd(S, VectorSetFloat1(-0.0464964749f), VectorSetFloat1(0.15931422f));
+	Angle = VectorMultiplyAdd(Angle, S, VectorSetFloat1(-0.327622764f));
+	Angle = VectorMultiplyAdd(VectorMultiply(Angle, S), A, A);
+
+	Angle = VectorSelect(VectorCompareGT(AbsY, AbsX), VectorSubtract(VectorSetFloat1(HALF_PI), Angle), Angle);
+	Angle = VectorSelect(VectorCompareGT(GlobalVectorConstants::FloatZero, X), VectorSubtract(VectorSetFloat1(PI), Angle), Angle);
+	Angle = VectorSelect(VectorCompareGT(GlobalVectorConstants::FloatZero, Y), VectorNegate(Angle), Angle);
+
+	return Angle;
+}
+
+
+void FLocomotionBuffer::Compute()
+{
+	const VectorRegister DegreesToRadians = VectorSetFloat1(PI / 180.f);
+	const VectorRegister RadiansToDegrees = VectorSetFloat1(180.f / PI);
+	const VectorRegister Epsilon = VectorSetFloat1(SMALL_NUMBER);
+	const VectorRegister MinMovingSpeedSq = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	const VectorRegister Falling = VectorSetFloat1((float)MOVE_Falling);
+
+	const float* RESTRICT VX = VelocityX.GetData();
+	const float* RESTRICT VY = VelocityY.GetData();
+	const float* RESTRICT VZ = VelocityZ.GetData();
+	const float* RESTRICT YW = Yaw.GetData();
+	const float* RESTRICT MM = MovementMode.GetData();
+	float* RESTRICT SP = Speed.GetData();
+	float* RESTRICT DR = Direction.GetData();
+	float* RESTRICT IA = InAir.GetData();
+
+	//SetNum zeroes the padding every frame and GetLocomotion never reads past NumCharacters, so the last vector can run over it
+	const int32 NumPadded = Align(NumCharacters, 4);
+
+	for (int32 i = 0; i < NumPadded; i += 4)
+	{
+		const VectorRegister VelX = VectorLoad(VX + i);
+		const VectorRegister VelY = VectorLoad(VY + i);
+		const VectorRegister VelZ = VectorLoad(VZ + i);
+
+		//Speed is SpeedSq * 1/sqrt(SpeedSq), the epsilon keeps characters standing still from giving us NaNs
+		const VectorRegister SpeedSq2D = VectorMultiplyAdd(VelX, VelX, VectorMultiply(VelY, VelY));
+		const VectorRegister SpeedSq = VectorMultiplyAdd(VelZ, VelZ, SpeedSq2D);
+		VectorStore(VectorMultiply(SpeedSq, VectorReciprocalSqrt(VectorAdd(SpeedSq, Epsilon))), SP + i);
+
+		//Turn the velocity into the character's yaw space, then the direction is just the angle of that
+		const VectorRegister YawRadians = VectorMultiply(VectorLoad(YW + i), DegreesToRadians);
+		VectorRegister SinYaw;
+		VectorRegister CosYaw;
+		VectorSinCos(&SinYaw, &CosYaw, &YawRadians);
+
+		const VectorRegister Forward = VectorMultiplyAdd(VelX, CosYaw, VectorMultiply(VelY, SinYaw));
+		const VectorRegister Right = VectorSubtract(VectorMultiply(VelY, CosYaw), VectorMultiply(VelX, SinYaw));
+
+		const VectorRegister Angle = VectorMultiply(VectorATan2Approx(Right, Forward), RadiansToDegrees);
+		VectorStore(VectorSelect(VectorCompareGT(SpeedSq2D, MinMovingSpeedSq), Angle, GlobalVectorConstants::FloatZero), DR + i);
+
+		VectorStore(VectorSelect(VectorCompareEQ(VectorLoad(MM + i), Falling), GlobalVectorConstants::FloatOne, GlobalVectorConstants::FloatZero), IA + i);
+	}
+}
+
+
+FCharacterLocomotion FLocomotionBuffer::GetLocomotion(const int32 Index) const
+{
+	FCharacterLocomotion Locomotion;
+	Locomotion.Speed = Speed[Index];
+	Locomotion.Direction = Direction[Index];
+	Locomotion.bIsInAir = InAir[Index] != 0.f;
+	Locomotion.bValid = true;
+	return Locomotion;
+}
+
+
+void FLocomotionTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRefOrdered& MyCompletionGraphEvent)
+{
+	if (Subsystem && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Subsystem->UpdateLocomotion();
+	}
+}
+
+
+FString FLocomotionTickFunction::DiagnosticMessage()
+{
+	return TEXT("ULocomotionSubsystem");
+}
+
+
+bool ULocomotionSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void ULocomotionSubsystem::Deinitialize()
+{
+	if (LocomotionTick.IsTickFunctionRegistered())
+	{
+		LocomotionTick.UnRegisterTickFunction();
+	}
+
+	Characters.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void ULocomotionSubsystem::RegisterCharacter(AShooterProjectCharacter* Character)
+{
+	if (!Character || Characters.Contains(Character))
+	{
+		return;
+	}
+
+	if (!LocomotionTick.IsTickFunctionRegistered())
+	{
+		ULevel* Level = GetWorld() ? GetWorld()->PersistentLevel : nullptr;
+
+		if (!Level)
+		{
+			return;
+		}
+
+		LocomotionTick.Subsystem = this;
+		LocomotionTick.bCanEverTick = true;
+		LocomotionTick.bStartWithTickEnabled = true;
+		LocomotionTick.TickGroup = TG_PrePhysics;
+		LocomotionTick.RegisterTickFunction(Level);
+	}
+
+	Characters.Add(Character);
+
+	//Read the velocity and movement mode after movement has run this frame, and have the mesh wait for us before it updates its animation
+	if (UCharacterMovementComponent* Movement = Character->GetCharacterMovement())
+	{
+		LocomotionTick.AddPrerequisite(Movement, Movement->PrimaryComponentTick);
+	}
+
+	if (USkeletalMeshComponent* Mesh = Character->GetMesh())
+	{
+		Mesh->PrimaryComponentTick.AddPrerequisite(this, LocomotionTick);
+	}
+}
+
+
+void ULocomotionSubsystem::UnregisterCharacter(AShooterProjectCharacter* Character)
+{
+	if (!Character || Characters.RemoveSwap(Character) == 0)
+	{
+		return;
+	}
+
+	if (UCharacterMovementComponent* Movement = Character->GetCharacterMovement())
+	{
+		LocomotionTick.RemovePrerequisite(Movement, Movement->PrimaryComponentTick);
+	}
+
+	if (USkeletalMeshComponent* Mesh = Character->GetMesh())
+	{
+		Mesh->PrimaryComponentTick.RemovePrerequisite(this, LocomotionTick);
+	}
+}
+
+
+void ULocomotionSubsystem::UpdateLocomotion()
+{
+	if (Characters.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_LocomotionKernel);
+
+	for (int32 i = Characters.Num() - 1; i >= 0; --i)
+	{
+		if (!Characters[i].IsValid())
+		{
+			Characters.RemoveAtSwap(i, 1, false);
+		}
+	}
+
+	Buffer.SetNum(Characters.Num());
+
+	for (int32 i = 0; i < Characters.Num(); ++i)
+	{
+		const AShooterProjectCharacter* Character = Characters[i].Get();
+		Buffer.Set(i, Character->GetVelocity(), Character->GetActorRotation().Yaw, Character->GetCharacterMovement()->MovementMode);
+	}
+
+	Buffer.Compute();
+
+	for (int32 i = 0; i < Characters.Num(); ++i)
+	{
+		Characters[i]->SetLocomotion(Buffer.GetLocomotion(i));
+	}
+}
+
+
+static FAutoConsoleCommand BenchmarkLocomotionCommand(
+	TEXT("anim.LocomotionBenchmark"),
+	TEXT("Time working out locomotion for N random characters with the batch kernel and with the scalar path. Usage: anim.LocomotionBenchmark [Characters] [Iterations]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		const int32 NumIterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+
+		FRandomStream RandomStream(NumCharacters);
+
+		TArray<FVector> Velocities;
+		TArray<float> Yaws;
+
+		for (int32 i = 0; i < NumCharacters; ++i)
+		{
+			Velocities.Add(FVector(RandomStream.FRandRange(-600.f, 600.f), RandomStream.FRandRange(-600.f, 600.f), RandomStream.FRandRange(-100.f, 100.f)));
+			Yaws.Add(RandomStream.FRandRange(-180.f, 180.f));
+		}
+
+		TArray<float> ScalarSpeeds;
+		TArray<float> ScalarDirections;
+		ScalarSpeeds.SetNumUninitialized(NumCharacters);
+		ScalarDirections.SetNumUninitialized(NumCharacters);
+
+		const double ScalarStartTime = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			for (int32 i = 0; i < NumCharacters; ++i)
+			{
+				ScalarSpeeds[i] = Velocities[i].Size();
+				ScalarDirections[i] = UPlayerAnimInstance::CalculateDirection(Velocities[i], FRotator(0.f, Yaws[i], 0.f));
+			}
+		}
+
+		const double ScalarTime = FPlatformTime::Seconds() - ScalarStartTime;
+
+		FLocomotionBuffer Buffer;
+		double GatherTime = 0.0;
+		double KernelTime = 0.0;
+
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			Buffer.SetNum(NumCharacters);
+
+			for (int32 i = 0; i < NumCharacters; ++i)
+			{
+				Buffer.Set(i, Velocities[i], Yaws[i], MOVE_Walking);
+			}
+
+			const double GatheredTime = FPlatformTime::Seconds();
+			Buffer.Compute();
+
+			GatherTime += GatheredTime - StartTime;
+			KernelTime += FPlatformTime::Seconds() - GatheredTime;
+		}
+
+		//The scalar path wraps to 180 where the kernel can give -180, so compare the shortest way round
+		float MaxDirectionError = 0.f;
+		float MaxSpeedError = 0.f;
+
+		for (int32 i = 0; i < NumCharacters; ++i)
+		{
+			MaxDirectionError = FMath::Max(MaxDirectionError, FMath::Abs(FMath::FindDeltaAngleDegrees(ScalarDirections[i], Buffer.Direction[i])));
+			MaxSpeedError = FMath::Max(MaxSpeedError, FMath::Abs(ScalarSpeeds[i] - Buffer.Speed[i]));
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("anim.LocomotionBenchmark: %d characters, %d iterations"), NumCharacters, NumIterations);
+		UE_LOG(LogTemp, Log, TEXT("  Scalar %.4fms per pass"), (ScalarTime / NumIterations) * 1000.0);
+		UE_LOG(LogTemp, Log, TEXT("  Batch %.4fms per pass (gather %.4fms, kernel %.4fms)"), ((GatherTime + KernelTime) / NumIterations) * 1000.0, (GatherTime / NumIterations) * 1000.0, (KernelTime / NumIterations) * 1000.0);
+		UE_LOG(LogTemp, Log, TEXT("  Max error %.5f degrees, %.5f speed"), MaxDirectionError, MaxSpeedError);
+	}));
@@ -0,0 +1,392 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/MeshMergeSubsystem.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "Player/ShooterProjectCharacter.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+#include "SkeletalMeshMerge.h"
+
+DECLARE_CYCLE_STAT(TEXT("Mesh Merge"), STAT_MeshMerge, STATGROUP_Characters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Merged Meshes"), STAT_CachedMergedMeshes, STATGROUP_Characters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Characters Using Merged Mesh"), STAT_CharactersUsingMergedMesh, STATGROUP_Characters);
+
+UMeshMergeSubsystem::UMeshMergeSubsystem()
+{
+	bMergeCharacterMeshes = false;
+	MergeDistance = 3000.f;
+	MaxMergesPerFrame = 1;
+	DistanceCheckInterval = 0.25f;
+	UnusedMergedMeshLifetime = 30.f;
+	TimeSinceDistanceCheck = 0.f;
+}
+
+
+bool UMeshMergeSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	//Dedicated servers don't render anything, so there is nothing to merge
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && !IsRunningDedicatedServer();
+}
+
+
+void UMeshMergeSubsystem::Deinitialize()
+{
+	PendingMerges.Empty();
+	MergedCharacters.Empty();
+	MergedMeshes.Empty();
+	SET_DWORD_STAT(STAT_CachedMergedMeshes, 0);
+	SET_DWORD_STAT(STAT_CharactersUsingMergedMesh, 0);
+
+	Super::Deinitialize();
+}
+
+
+void UMeshMergeSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	UMeshMergeSubsystem* This = CastChecked<UMeshMergeSubsystem>(InThis);
+
+	//Keep the parts of pending merges around until we've merged them, the character may have swapped gear since
+	for (FMergeRequest& Request : This->PendingMerges)
+	{
+		Collector.AddReferencedObjects(Request.SourceMeshes, This);
+
+		for (TPair<UMaterialInterface*, UMaterialInterface*>& MaterialOverride : Request.MaterialOverrides)
+		{
+			Collector.AddReferencedObject(MaterialOverride.Key, This);
+			Collector.AddReferencedObject(MaterialOverride.Value, This);
+		}
+	}
+
+	for (TPair<FMeshMergeKey, FCachedMergedMesh>& MergedMesh : This->MergedMeshes)
+	{
+		Collector.AddReferencedObject(MergedMesh.Value.Mesh, This);
+	}
+
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
+
+USkeletalMesh* UMeshMergeSubsystem::RequestMergedMesh(AShooterProjectCharacter* Character, const TArray<USkeletalMeshComponent*>& Parts, uint32& OutHash)
+{
+	FMergeRequest Request;
+	bool bCanMerge = true;
+
+	for (const USkeletalMeshComponent* Part : Parts)
+	{
+		if (!Part || !Part->SkeletalMesh)
+		{
+			continue;
+		}
+
+		Request.SourceMeshes.Add(Part->SkeletalMesh);
+		Request.Key.Objects.Add(FObjectKey(Part->SkeletalMesh));
+
+		const TArray<FSkeletalMaterial>& MeshMaterials = Part->SkeletalMesh->Materials;
+
+		for (int32 i = 0; i < MeshMaterials.Num(); ++i)
+		{
+			UMaterialInterface* BaseMaterial = MeshMaterials[i].MaterialInterface;
+			UMaterialInterface* OverrideMaterial = Part->OverrideMaterials.IsValidIndex(i) ? Part->OverrideMaterials[i] : nullptr;
+			UMaterialInterface* Material = OverrideMaterial ? OverrideMaterial : BaseMaterial;
+
+			Request.Key.Objects.Add(FObjectKey(Material));
+
+			//Sections are merged by base material, so parts can only share a base material if they show it the same way
+			if (const TPair<UMaterialInterface*, UMaterialInterface*>* MaterialOverride = Request.MaterialOverrides.FindByPredicate([BaseMaterial](const TPair<UMaterialInterface*, UMaterialInterface*>& Pair) { return Pair.Key == BaseMaterial; }))
+			{
+				bCanMerge &= MaterialOverride->Value == Material;
+			}
+			else
+			{
+				Request.MaterialOverrides.Emplace(BaseMaterial, Material);
+			}
+		}
+	}
+
+	Request.Hash = GetTypeHash(Request.Key);
+	OutHash = Request.Hash;
+
+	if (!Character)
+	{
+		return nullptr;
+	}
+
+	//Whatever the character asked for before is out of date now
+	for (FMergeRequest& PendingMerge : PendingMerges)
+	{
+		PendingMerge.Characters.RemoveSwap(Character);
+	}
+
+	if (!bCanMerge || Request.SourceMeshes.Num() == 0)
+	{
+		UnregisterCharacter(Character);
+		return nullptr;
+	}
+
+	if (FMergedCharacter* MergedCharacter = MergedCharacters.FindByPredicate([Character](const FMergedCharacter& Merged) { return Merged.Character == Character; }))
+	{
+		MergedCharacter->Key = Request.Key;
+	}
+	else
+	{
+		MergedCharacters.Add({ Character, Request.Key });
+	}
+
+	if (FCachedMergedMesh* MergedMesh = MergedMeshes.Find(Request.Key))
+	{
+		MergedMesh->LastUsedTime = GetWorld()->GetTimeSeconds();
+		return MergedMesh->Mesh;
+	}
+
+	//Someone else may already be waiting on the same gear
+	if (FMergeRequest* PendingMerge = PendingMerges.FindByPredicate([&Request](const FMergeRequest& Pending) { return Pending.Key == Request.Key; }))
+	{
+		PendingMerge->Characters.AddUnique(Character);
+	}
+	else
+	{
+		Request.Characters.Add(Character);
+		PendingMerges.Add(MoveTemp(Request));
+	}
+
+	return nullptr;
+}
+
+
+void UMeshMergeSubsystem::UnregisterCharacter(AShooterProjectCharacter* Character)
+{
+	MergedCharacters.RemoveAllSwap([Character](const FMergedCharacter& Merged) { return Merged.Character == Character; });
+}
+
+
+USkeletalMesh* UMeshMergeSubsystem::MergeMeshes(const FMergeRequest& Request) const
+{
+	USkeletalMesh* MergedMesh = NewObject<USkeletalMesh>(GetTransientPackage(), NAME_None, RF_Transient);
+	MergedMesh->Skeleton = Request.SourceMeshes[0]->Skeleton;
+
+	const TArray<FSkelMeshMergeSectionMapping> SectionMappings;
+	FSkeletalMeshMerge Merger(MergedMesh, Request.SourceMeshes, SectionMappings, 0);
+
+	if (!Merger.DoMerge())
+	{
+		return nullptr;
+	}
+
+	//Sections are merged by material and RequestMergedMesh made sure each base material only shows one way, so swapping
+	//the materials on the merged mesh gives the same look as the parts
+	for (FSkeletalMaterial& Material : MergedMesh->Materials)
+	{
+		for (const TPair<UMaterialInterface*, UMaterialInterface*>& MaterialOverride : Request.MaterialOverrides)
+		{
+			if (Material.MaterialInterface == MaterialOverride.Key)
+			{
+				Material.MaterialInterface = MaterialOverride.Value;
+			}
+		}
+	}
+
+	return MergedMesh;
+}
+
+
+void UMeshMergeSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeshMerge);
+
+	const int32 NumMerges = FMath::Min(MaxMergesPerFrame, PendingMerges.Num());
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (int32 i = 0; i < NumMerges; ++i)
+	{
+		const FMergeRequest& Request = PendingMerges[i];
+
+		//Failed merges are cached too, so we don't keep retrying the same gear while someone is wearing it
+		USkeletalMesh* MergedMesh = MergeMeshes(Request);
+
+		if (!MergedMesh)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Couldn't merge %d character parts, characters wearing them will keep their separate meshes."), Request.SourceMeshes.Num());
+		}
+
+		FCachedMergedMesh& CachedMesh = MergedMeshes.Add(Request.Key);
+		CachedMesh.Mesh = MergedMesh;
+		CachedMesh.LastUsedTime = Now;
+
+		for (const TWeakObjectPtr<AShooterProjectCharacter>& Character : Request.Characters)
+		{
+			if (Character.IsValid())
+			{
+				Character->SetMergedMesh(MergedMesh, Request.Hash);
+			}
+		}
+	}
+
+	PendingMerges.RemoveAt(0, NumMerges, false);
+	SET_DWORD_STAT(STAT_CachedMergedMeshes, MergedMeshes.Num());
+
+	TimeSinceDistanceCheck += DeltaTime;
+
+	if (TimeSinceDistanceCheck >= DistanceCheckInterval)
+	{
+		TimeSinceDistanceCheck = 0.f;
+		UpdateMergedCharacters();
+		ReleaseUnusedMergedMeshes();
+	}
+}
+
+
+void UMeshMergeSubsystem::UpdateMergedCharacters()
+{
+	const APlayerController* PC = GetWorld()->GetFirstPlayerController();
+
+	if (!PC || !PC->PlayerCameraManager)
+	{
+		return;
+	}
+
+	const FVector ViewLocation = PC->PlayerCameraManager->GetCameraLocation();
+	const float MergeDistanceSquared = FMath::Square(MergeDistance);
+
+	int32 NumUsingMergedMesh = 0;
+
+	for (int32 i = MergedCharacters.Num() - 1; i >= 0; --i)
+	{
+		if (AShooterProjectCharacter* Character = MergedCharacters[i].Character.Get())
+		{
+			Character->SetUseMergedMesh(FVector::DistSquared(ViewLocation, Character->GetActorLocation()) > MergeDistanceSquared);
+			NumUsingMergedMesh += Character->IsUsingMergedMesh() ? 1 : 0;
+		}
+		else
+		{
+			MergedCharacters.RemoveAtSwap(i, 1, false);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_CharactersUsingMergedMesh, NumUsingMergedMesh);
+}
+
+
+void UMeshMergeSubsystem::ReleaseUnusedMergedMeshes()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (const FMergedCharacter& MergedCharacter : MergedCharacters)
+	{
+		if (MergedCharacter.Character.IsValid())
+		{
+			if (FCachedMergedMesh* MergedMesh = MergedMeshes.Find(MergedCharacter.Key))
+			{
+				MergedMesh->LastUsedTime = Now;
+			}
+		}
+	}
+
+	//Characters still showing a released mesh keep it alive through their merged mesh component until they swap it out
+	for (auto It = MergedMeshes.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().LastUsedTime > UnusedMergedMeshLifetime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_CachedMergedMeshes, MergedMeshes.Num());
+}
+
+
+bool UMeshMergeSubsystem::IsTickable() const
+{
+	return PendingMerges.Num() > 0 || MergedCharacters.Num() > 0 || MergedMeshes.Num() > 0;
+}
+
+
+ETickableTickType UMeshMergeSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+UWorld* UMeshMergeSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+
+TStatId UMeshMergeSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMeshMergeSubsystem, STATGROUP_Tickables);
+}
+
+
+static FAutoConsoleCommandWithWorldAndArgs MeshMergeStatsCommand(
+	TEXT("character.MeshMergeStats"),
+	TEXT("Count the visible skinned components on every character and time CPU skinning them. Works with -nullrhi. Usage: character.MeshMergeStats [merged|separate]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		int32 NumCharacters = 0;
+		int32 NumSkinnedComponents = 0;
+		int32 NumSkippedComponents = 0;
+		int32 NumVertices = 0;
+		double SkinningTime = 0.0;
+
+		TArray<USkinnedMeshComponent*> SkinnedComponents;
+		TArray<FMatrix> RefToLocals;
+		TArray<FVector> SkinnedPositions;
+
+		for (TActorIterator<AShooterProjectCharacter> It(World); It; ++It)
+		{
+			AShooterProjectCharacter* Character = *It;
+			++NumCharacters;
+
+			//Let the same characters be measured both ways
+			if (Args.Num() > 0)
+			{
+				Character->SetUseMergedMesh(Args[0] == TEXT("merged"));
+			}
+
+			Character->GetComponents<USkinnedMeshComponent>(SkinnedComponents);
+
+			for (USkinnedMeshComponent* SkinnedComponent : SkinnedComponents)
+			{
+				if (!SkinnedComponent->IsVisible() || !SkinnedComponent->SkeletalMesh)
+				{
+					continue;
+				}
+
+				++NumSkinnedComponents;
+
+				const int32 LODIndex = SkinnedComponent->GetPredictedLODLevel();
+				const FSkeletalMeshRenderData* RenderData = SkinnedComponent->GetSkeletalMeshRenderData();
+				const FSkinWeightVertexBuffer* SkinWeightBuffer = SkinnedComponent->GetSkinWeightBuffer(LODIndex);
+
+				//Positions can only be read back on the CPU if the mesh was imported with CPU access
+				if (!RenderData || !RenderData->LODRenderData.IsValidIndex(LODIndex) || !SkinWeightBuffer || !RenderData->LODRenderData[LODIndex].StaticVertexBuffers.PositionVertexBuffer.GetAllowCPUAccess())
+				{
+					++NumSkippedComponents;
+					continue;
+				}
+
+				const double StartTime = FPlatformTime::Seconds();
+
+				SkinnedComponent->CacheRefToLocalMatrices(RefToLocals);
+				USkinnedMeshComponent::ComputeSkinnedPositions(SkinnedComponent, SkinnedPositions, RefToLocals, RenderData->LODRenderData[LODIndex], *SkinWeightBuffer);
+
+				SkinningTime += FPlatformTime::Seconds() - StartTime;
+				NumVertices += SkinnedPositions.Num();
+			}
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("character.MeshMergeStats: %d characters, %d visible skinned components (%.2f per character)"), NumCharacters, NumSkinnedComponents, NumCharacters > 0 ? (float)NumSkinnedComponents / NumCharacters : 0.f);
+		UE_LOG(LogTemp, Log, TEXT("  CPU skinning %d vertices took %.3fms, %d components skipped without CPU access"), NumVertices, SkinningTime * 1000.0, NumSkippedComponents);
+	}));
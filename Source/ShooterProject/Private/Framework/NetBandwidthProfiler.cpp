@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/NetBandwidthProfiler.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static const TCHAR* GetCategoryName(const ENetBandwidthCategory Category)
+{
+	switch (Category)
+	{
+	case ENetBandwidthCategory::ActorClass:
+		return TEXT("ActorClass");
+	case ENetBandwidthCategory::Subobject:
+		return TEXT("Subobject");
+	case ENetBandwidthCategory::RPC:
+		return TEXT("RPC");
+	case ENetBandwidthCategory::Received:
+		return TEXT("Received");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+
+FNetBandwidthProfiler& FNetBandwidthProfiler::Get()
+{
+	static FNetBandwidthProfiler Profiler;
+	return Profiler;
+}
+
+
+void FNetBandwidthProfiler::Start()
+{
+	if (!bEnabled)
+	{
+		bEnabled = true;
+		StartTime = FPlatformTime::Seconds();
+	}
+}
+
+
+void FNetBandwidthProfiler::Stop()
+{
+	if (bEnabled)
+	{
+		ElapsedSecondsBeforeStart += FPlatformTime::Seconds() - StartTime;
+		bEnabled = false;
+	}
+}
+
+
+void FNetBandwidthProfiler::Reset()
+{
+	for (TMap<FName, FNetBandwidthStat>& CategoryStats : Stats)
+	{
+		CategoryStats.Reset();
+	}
+
+	StartTime = FPlatformTime::Seconds();
+	ElapsedSecondsBeforeStart = 0.0;
+}
+
+
+double FNetBandwidthProfiler::GetElapsedSeconds() const
+{
+	return ElapsedSecondsBeforeStart + (bEnabled ? FPlatformTime::Seconds() - StartTime : 0.0);
+}
+
+
+bool FNetBandwidthProfiler::WriteCSV(const FString& Filename) const
+{
+	const double Seconds = FMath::Max(GetElapsedSeconds(), SMALL_NUMBER);
+
+	FString CSV = TEXT("Category,Name,Bytes,Count,BytesPerSecond,CountPerSecond,AverageBytes\n");
+
+	for (uint8 Category = 0; Category < (uint8)ENetBandwidthCategory::MAX; ++Category)
+	{
+		for (const TPair<FName, FNetBandwidthStat>& Stat : Stats[Category])
+		{
+			const double Bytes = Stat.Value.Bits / 8.0;
+
+			CSV += FString::Printf(TEXT("%s,%s,%.0f,%d,%.2f,%.2f,%.2f\n"), GetCategoryName((ENetBandwidthCategory)Category), *Stat.Key.ToString(), Bytes, Stat.Value.Count,
+				Bytes / Seconds, Stat.Value.Count / Seconds, Stat.Value.Count > 0 ? Bytes / Stat.Value.Count : 0.0);
+		}
+	}
+
+	return FFileHelper::SaveStringToFile(CSV, *Filename);
+}
+
+
+void FNetBandwidthProfiler::LogTopOffenders(const int32 NumPerCategory) const
+{
+	const double Seconds = FMath::Max(GetElapsedSeconds(), SMALL_NUMBER);
+
+	UE_LOG(LogTemp, Log, TEXT("net.BandwidthProfile: top %d of each category over %.1f seconds"), NumPerCategory, Seconds);
+
+	for (uint8 Category = 0; Category < (uint8)ENetBandwidthCategory::MAX; ++Category)
+	{
+		TArray<TPair<FName, FNetBandwidthStat>> Sorted = Stats[Category].Array();
+		Sorted.Sort([](const TPair<FName, FNetBandwidthStat>& A, const TPair<FName, FNetBandwidthStat>& B) { return A.Value.Bits > B.Value.Bits; });
+
+		int64 TotalBits = 0;
+
+		for (const TPair<FName, FNetBandwidthStat>& Stat : Sorted)
+		{
+			TotalBits += Stat.Value.Bits;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("  %s: %.2f bytes/s total"), GetCategoryName((ENetBandwidthCategory)Category), (TotalBits / 8.0) / Seconds);
+
+		for (int32 i = 0; i < FMath::Min(NumPerCategory, Sorted.Num()); ++i)
+		{
+			const FNetBandwidthStat& Stat = Sorted[i].Value;
+
+			UE_LOG(LogTemp, Log, TEXT("    %-48s %10.2f bytes/s %8.2f/s %5.1f%%"), *Sorted[i].Key.ToString(), (Stat.Bits / 8.0) / Seconds, Stat.Count / Seconds,
+				TotalBits > 0 ? (100.0 * Stat.Bits) / TotalBits : 0.0);
+		}
+	}
+}
+
+
+static FAutoConsoleCommand BandwidthProfileCommand(
+	TEXT("net.BandwidthProfile"),
+	TEXT("Count the bandwidth used by each actor class, subobject class and RPC. Usage: net.BandwidthProfile [start|stop|reset|top [N]|dump [Filename]]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		FNetBandwidthProfiler& Profiler = FNetBandwidthProfiler::Get();
+		const FString Command = Args.Num() > 0 ? Args[0] : TEXT("top");
+
+		if (Command == TEXT("start"))
+		{
+			Profiler.Start();
+		}
+		else if (Command == TEXT("stop"))
+		{
+			Profiler.Stop();
+		}
+		else if (Command == TEXT("reset"))
+		{
+			Profiler.Reset();
+		}
+		else if (Command == TEXT("top"))
+		{
+			Profiler.LogTopOffenders(Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 5);
+		}
+		else if (Command == TEXT("dump"))
+		{
+			const FString Filename = Args.Num() > 1 ? Args[1] : FPaths::ProfilingDir() / TEXT("Bandwidth") / FString::Printf(TEXT("Bandwidth-%s.csv"), *FDateTime::Now().ToString());
+
+			if (Profiler.WriteCSV(Filename))
+			{
+				UE_LOG(LogTemp, Log, TEXT("net.BandwidthProfile: wrote %s"), *IFileManager::Get().ConvertToAbsolutePathForExternalAppForWrite(*Filename));
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("net.BandwidthProfile: couldn't write %s"), *Filename);
+			}
+		}
+	}));
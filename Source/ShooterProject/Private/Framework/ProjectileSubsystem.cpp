@@ -0,0 +1,345 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/ProjectileSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Items/WeaponClass.h"
+#include "Kismet/GameplayStatics.h"
+#include "ShooterProject/ShooterProject.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Integrate"), STAT_ProjectileIntegrate, STATGROUP_Combat);
+DECLARE_CYCLE_STAT(TEXT("Projectile Traces"), STAT_ProjectileTraces, STATGROUP_Combat);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectiles In Flight"), STAT_ProjectilesInFlight, STATGROUP_Combat);
+
+int32 FProjectileBuffer::Add(AWeaponClass* Weapon, const FVector& Origin, const FVector& Velocity, const float InDrag, const float InLifetime)
+{
+	//Grow by a whole vector at a time so the arrays stay padded to a multiple of four
+	if (NumProjectiles == PositionX.Num())
+	{
+		for (TArray<float>* Field : { &PositionX, &PositionY, &PositionZ, &StartX, &StartY, &StartZ, &VelocityX, &VelocityY, &VelocityZ, &Drag, &Lifetime })
+		{
+			Field->AddZeroed(4);
+		}
+
+		Weapons.AddDefaulted(4);
+	}
+
+	const int32 Index = NumProjectiles++;
+
+	PositionX[Index] = StartX[Index] = Origin.X;
+	PositionY[Index] = StartY[Index] = Origin.Y;
+	PositionZ[Index] = StartZ[Index] = Origin.Z;
+	VelocityX[Index] = Velocity.X;
+	VelocityY[Index] = Velocity.Y;
+	VelocityZ[Index] = Velocity.Z;
+	Drag[Index] = InDrag;
+	Lifetime[Index] = InLifetime;
+	Weapons[Index] = Weapon;
+
+	return Index;
+}
+
+
+void FProjectileBuffer::RemoveAtSwap(const int32 Index)
+{
+	check(Index >= 0 && Index < NumProjectiles);
+
+	const int32 LastIndex = --NumProjectiles;
+
+	//Move the last projectile into the gap, then zero the old last slot so it becomes padding again
+	for (TArray<float>* Field : { &PositionX, &PositionY, &PositionZ, &StartX, &StartY, &StartZ, &VelocityX, &VelocityY, &VelocityZ, &Drag, &Lifetime })
+	{
+		(*Field)[Index] = (*Field)[LastIndex];
+		(*Field)[LastIndex] = 0.f;
+	}
+
+	Weapons[Index] = Weapons[LastIndex];
+	Weapons[LastIndex].Reset();
+}
+
+
+void FProjectileBuffer::Empty()
+{
+	for (TArray<float>* Field : { &PositionX, &PositionY, &PositionZ, &StartX, &StartY, &StartZ, &VelocityX, &VelocityY, &VelocityZ, &Drag, &Lifetime })
+	{
+		Field->Empty();
+	}
+
+	Weapons.Empty();
+	NumProjectiles = 0;
+}
+
+
+void FProjectileBuffer::Integrate(const float DeltaTime, const float GravityZ)
+{
+	const VectorRegister Dt = VectorSetFloat1(DeltaTime);
+	const VectorRegister GravityDt = VectorSetFloat1(GravityZ * DeltaTime);
+	const VectorRegister Epsilon = VectorSetFloat1(SMALL_NUMBER);
+
+	float* RESTRICT PX = PositionX.GetData();
+	float* RESTRICT PY = PositionY.GetData();
+	float* RESTRICT PZ = PositionZ.GetData();
+	float* RESTRICT SX = StartX.GetData();
+	float* RESTRICT SY = StartY.GetData();
+	float* RESTRICT SZ = StartZ.GetData();
+	float* RESTRICT VX = VelocityX.GetData();
+	float* RESTRICT VY = VelocityY.GetData();
+	float* RESTRICT VZ = VelocityZ.GetData();
+	const float* RESTRICT D = Drag.GetData();
+	float* RESTRICT L = Lifetime.GetData();
+
+	//The last vector runs over the padding too, which gravity and lifetime then move away from zero. Those lanes are re-zeroed below.
+	const int32 NumPadded = Align(NumProjectiles, 4);
+
+	for (int32 i = 0; i < NumPadded; i += 4)
+	{
+		VectorRegister PosX = VectorLoad(PX + i);
+		VectorRegister PosY = VectorLoad(PY + i);
+		VectorRegister PosZ = VectorLoad(PZ + i);
+
+		VectorStore(PosX, SX + i);
+		VectorStore(PosY, SY + i);
+		VectorStore(PosZ, SZ + i);
+
+		VectorRegister VelX = VectorLoad(VX + i);
+		VectorRegister VelY = VectorLoad(VY + i);
+		VectorRegister VelZ = VectorLoad(VZ + i);
+
+		//Speed is SpeedSq * 1/sqrt(SpeedSq). The epsilon keeps projectiles that have stopped from giving us NaNs.
+		const VectorRegister SpeedSq = VectorMultiplyAdd(VelX, VelX, VectorMultiplyAdd(VelY, VelY, VectorMultiply(VelZ, VelZ)));
+		const VectorRegister Speed = VectorMultiply(SpeedSq, VectorReciprocalSqrt(VectorAdd(SpeedSq, Epsilon)));
+
+		//Drag never takes away more speed than the projectile has, even on a long frame
+		const VectorRegister DragLoss = VectorMultiply(VectorMultiply(VectorLoad(D + i), Speed), Dt);
+		const VectorRegister DragScale = VectorMax(VectorSubtract(GlobalVectorConstants::FloatOne, DragLoss), GlobalVectorConstants::FloatZero);
+
+		VelX = VectorMultiply(VelX, DragScale);
+		VelY = VectorMultiply(VelY, DragScale);
+		VelZ = VectorMultiplyAdd(VelZ, DragScale, GravityDt);
+
+		VectorStore(VelX, VX + i);
+		VectorStore(VelY, VY + i);
+		VectorStore(VelZ, VZ + i);
+
+		VectorStore(VectorMultiplyAdd(VelX, Dt, PosX), PX + i);
+		VectorStore(VectorMultiplyAdd(VelY, Dt, PosY), PY + i);
+		VectorStore(VectorMultiplyAdd(VelZ, Dt, PosZ), PZ + i);
+
+		VectorStore(VectorSubtract(VectorLoad(L + i), Dt), L + i);
+	}
+
+	//Keep the padding zeroed, so it never reads as a projectile that is flying or has a lifetime
+	for (int32 i = NumProjectiles; i < NumPadded; ++i)
+	{
+		PX[i] = PY[i] = PZ[i] = 0.f;
+		SX[i] = SY[i] = SZ[i] = 0.f;
+		VX[i] = VY[i] = VZ[i] = 0.f;
+		L[i] = 0.f;
+	}
+}
+
+
+bool UProjectileSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void UProjectileSubsystem::Deinitialize()
+{
+	Projectiles.Empty();
+	FiredProjectiles.Empty();
+	SET_DWORD_STAT(STAT_ProjectilesInFlight, 0);
+
+	Super::Deinitialize();
+}
+
+
+void UProjectileSubsystem::SpawnProjectile(AWeaponClass* Weapon, const FVector& Origin, const FVector& Velocity, const float Drag, const float Lifetime)
+{
+	if (Weapon && Weapon->HasAuthority())
+	{
+		Projectiles.Add(Weapon, Origin, Velocity, Drag, Lifetime);
+		SET_DWORD_STAT(STAT_ProjectilesInFlight, Projectiles.Num());
+
+		FFiredProjectile& FiredProjectile = FiredProjectiles.AddDefaulted_GetRef();
+		FiredProjectile.Weapon = Weapon;
+		FiredProjectile.Origin = Origin;
+		FiredProjectile.Velocity = Velocity;
+	}
+}
+
+
+void UProjectileSubsystem::TraceProjectiles(FProjectileBuffer& Buffer, const bool bApplyDamage) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileTraces);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileStep), false);
+
+	//Go backwards so removing a projectile only ever swaps in one we've already traced
+	for (int32 i = Buffer.Num() - 1; i >= 0; --i)
+	{
+		AWeaponClass* Weapon = Buffer.Weapons[i].Get();
+
+		QueryParams.ClearIgnoredActors();
+
+		if (Weapon)
+		{
+			QueryParams.AddIgnoredActor(Weapon);
+			QueryParams.AddIgnoredActor(Weapon->GetOwner());
+		}
+
+		FHitResult Hit;
+
+		if (GetWorld()->LineTraceSingleByChannel(Hit, Buffer.GetStart(i), Buffer.GetPosition(i), COLLISION_WEAPON, QueryParams))
+		{
+			if (bApplyDamage && Weapon)
+			{
+				const APawn* PawnOwner = Cast<APawn>(Weapon->GetOwner());
+				AController* InstigatorController = PawnOwner ? PawnOwner->GetController() : nullptr;
+
+				UGameplayStatics::ApplyPointDamage(Hit.GetActor(), Weapon->ShotDamage, Buffer.GetVelocity(i).GetSafeNormal(), Hit, InstigatorController, Weapon, Weapon->ShotDamageType);
+			}
+
+			Buffer.RemoveAtSwap(i);
+		}
+		else if (Buffer.Lifetime[i] <= 0.f)
+		{
+			Buffer.RemoveAtSwap(i);
+		}
+	}
+}
+
+
+void UProjectileSubsystem::Tick(float DeltaTime)
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ProjectileIntegrate);
+		Projectiles.Integrate(DeltaTime, GetWorld()->GetGravityZ());
+	}
+
+	TraceProjectiles(Projectiles, true);
+
+	SET_DWORD_STAT(STAT_ProjectilesInFlight, Projectiles.Num());
+
+	SendFiredProjectiles();
+}
+
+
+void UProjectileSubsystem::SendFiredProjectiles()
+{
+	//Shots from the same weapon stay in the order they were fired
+	FiredProjectiles.StableSort([](const FFiredProjectile& A, const FFiredProjectile& B)
+	{
+		return A.Weapon.Get() < B.Weapon.Get();
+	});
+
+	FBallisticShotsFired ShotsFired;
+
+	int32 ShotIndex = 0;
+
+	while (ShotIndex < FiredProjectiles.Num())
+	{
+		AWeaponClass* Weapon = FiredProjectiles[ShotIndex].Weapon.Get();
+
+		ShotsFired.Origin = FiredProjectiles[ShotIndex].Origin;
+		ShotsFired.Velocities.Reset();
+
+		for (; ShotIndex < FiredProjectiles.Num() && FiredProjectiles[ShotIndex].Weapon.Get() == Weapon; ++ShotIndex)
+		{
+			ShotsFired.Velocities.Add(FiredProjectiles[ShotIndex].Velocity);
+		}
+
+		//The weapon went away before we got to send its shots
+		if (Weapon)
+		{
+			Weapon->OnBallisticShotsFired(ShotsFired);
+		}
+	}
+
+	FiredProjectiles.Reset();
+}
+
+
+bool UProjectileSubsystem::IsTickable() const
+{
+	return Projectiles.Num() > 0 || FiredProjectiles.Num() > 0;
+}
+
+
+ETickableTickType UProjectileSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+UWorld* UProjectileSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+
+TStatId UProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSubsystem, STATGROUP_Tickables);
+}
+
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkProjectilesCommand(
+	TEXT("projectile.Benchmark"),
+	TEXT("Fly N projectiles for a number of 60hz frames in a scratch buffer and print the average cost. Usage: projectile.Benchmark [Projectiles] [Frames]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UProjectileSubsystem* ProjectileSubsystem = World ? World->GetSubsystem<UProjectileSubsystem>() : nullptr;
+
+		if (!ProjectileSubsystem)
+		{
+			return;
+		}
+
+		const int32 NumProjectiles = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+		const int32 NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 60;
+		const float DeltaTime = 1.f / 60.f;
+
+		//Fire everything upwards from above the first player, so most rounds fly for a while before they hit anything
+		FVector Origin = FVector(0.f, 0.f, 1000.f);
+
+		if (const APlayerController* PC = World->GetFirstPlayerController())
+		{
+			if (const APawn* Pawn = PC->GetPawn())
+			{
+				Origin = Pawn->GetActorLocation() + FVector(0.f, 0.f, 200.f);
+			}
+		}
+
+		FRandomStream RandomStream(NumProjectiles);
+		FProjectileBuffer Buffer;
+
+		for (int32 i = 0; i < NumProjectiles; ++i)
+		{
+			const FVector Direction = RandomStream.VRandCone(FVector::UpVector, FMath::DegreesToRadians(60.f));
+			Buffer.Add(nullptr, Origin, Direction * 80000.f, 0.000002f, 5.f);
+		}
+
+		double IntegrateTime = 0.0;
+		double TraceTime = 0.0;
+
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Buffer.Integrate(DeltaTime, World->GetGravityZ());
+
+			const double IntegratedTime = FPlatformTime::Seconds();
+			ProjectileSubsystem->TraceProjectiles(Buffer, false);
+
+			IntegrateTime += IntegratedTime - StartTime;
+			TraceTime += FPlatformTime::Seconds() - IntegratedTime;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("projectile.Benchmark: %d projectiles, %d frames, %d still flying"), NumProjectiles, NumFrames, Buffer.Num());
+		UE_LOG(LogTemp, Log, TEXT("  Integrate %.3fms per frame, traces %.3fms per frame"), (IntegrateTime / NumFrames) * 1000.0, (TraceTime / NumFrames) * 1000.0);
+	}));
@@ -0,0 +1,188 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/RagdollSubsystem.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "Framework/MeshMergeSubsystem.h"
+#include "GameFramework/PlayerController.h"
+#include "Player/ShooterProjectCharacter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ragdoll Budget"), STAT_RagdollBudget, STATGROUP_Characters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Simulating Ragdolls"), STAT_SimulatingRagdolls, STATGROUP_Characters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Simulating Ragdoll Bodies"), STAT_SimulatingRagdollBodies, STATGROUP_Characters);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ragdolls Frozen This Frame"), STAT_RagdollsFrozenThisFrame, STATGROUP_Characters);
+
+URagdollSubsystem::URagdollSubsystem()
+{
+	MaxSimulatingRagdolls = 8;
+	SettleSpeed = 5.f;
+	SettleTime = 0.5f;
+	MaxSimulationTime = 10.f;
+	FreezeDistance = 5000.f;
+}
+
+
+bool URagdollSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void URagdollSubsystem::Deinitialize()
+{
+	Ragdolls.Empty();
+	SET_DWORD_STAT(STAT_SimulatingRagdolls, 0);
+	SET_DWORD_STAT(STAT_SimulatingRagdollBodies, 0);
+
+	Super::Deinitialize();
+}
+
+
+void URagdollSubsystem::AddRagdoll(AShooterProjectCharacter* Character)
+{
+	if (!Character || Ragdolls.ContainsByPredicate([Character](const FRagdoll& Ragdoll) { return Ragdoll.Character == Character; }))
+	{
+		return;
+	}
+
+	//Bodies that die out of view would be frozen next tick anyway, so don't start them
+	FVector ViewLocation;
+
+	if (GetViewLocation(ViewLocation) && FVector::DistSquared(ViewLocation, Character->GetActorLocation()) > FMath::Square(FreezeDistance))
+	{
+		Character->FreezeRagdoll();
+		return;
+	}
+
+	//Make room by freezing whichever ragdoll is moving the least, it is the closest to settling anyway
+	if (MaxSimulatingRagdolls > 0 && Ragdolls.Num() >= MaxSimulatingRagdolls)
+	{
+		int32 SlowestIndex = 0;
+
+		for (int32 i = 1; i < Ragdolls.Num(); ++i)
+		{
+			if (Ragdolls[i].Speed < Ragdolls[SlowestIndex].Speed)
+			{
+				SlowestIndex = i;
+			}
+		}
+
+		FreezeRagdoll(SlowestIndex);
+	}
+
+	Character->StartRagdoll();
+
+	FRagdoll& Ragdoll = Ragdolls.AddDefaulted_GetRef();
+	Ragdoll.Character = Character;
+
+	//New ragdolls are always moving, so they don't get picked to make room before they've had a chance to fall
+	Ragdoll.Speed = MAX_flt;
+}
+
+
+void URagdollSubsystem::RemoveRagdoll(AShooterProjectCharacter* Character)
+{
+	const int32 Index = Ragdolls.IndexOfByPredicate([Character](const FRagdoll& Ragdoll) { return Ragdoll.Character == Character; });
+
+	if (Index != INDEX_NONE)
+	{
+		Ragdolls.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+
+bool URagdollSubsystem::GetViewLocation(FVector& OutViewLocation) const
+{
+	const APlayerController* PC = GetWorld()->GetFirstPlayerController();
+
+	if (PC && PC->IsLocalController() && PC->PlayerCameraManager)
+	{
+		OutViewLocation = PC->PlayerCameraManager->GetCameraLocation();
+		return true;
+	}
+
+	return false;
+}
+
+
+void URagdollSubsystem::FreezeRagdoll(const int32 Index)
+{
+	if (AShooterProjectCharacter* Character = Ragdolls[Index].Character.Get())
+	{
+		Character->FreezeRagdoll();
+		INC_DWORD_STAT(STAT_RagdollsFrozenThisFrame);
+	}
+
+	Ragdolls.RemoveAtSwap(Index, 1, false);
+}
+
+
+void URagdollSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RagdollBudget);
+
+	FVector ViewLocation;
+	const bool bHasView = GetViewLocation(ViewLocation);
+	const float FreezeDistanceSquared = FMath::Square(FreezeDistance);
+
+	int32 NumBodies = 0;
+
+	for (int32 i = Ragdolls.Num() - 1; i >= 0; --i)
+	{
+		FRagdoll& Ragdoll = Ragdolls[i];
+		AShooterProjectCharacter* Character = Ragdoll.Character.Get();
+
+		if (!Character)
+		{
+			Ragdolls.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+
+		const USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+		Ragdoll.SimulationTime += DeltaTime;
+		Ragdoll.Speed = Mesh->GetPhysicsLinearVelocity().Size();
+		Ragdoll.SettledTime = Ragdoll.Speed < SettleSpeed ? Ragdoll.SettledTime + DeltaTime : 0.f;
+
+		const bool bSettled = Ragdoll.SettledTime >= SettleTime || Ragdoll.SimulationTime >= MaxSimulationTime;
+		const bool bTooFar = bHasView && FVector::DistSquared(ViewLocation, Mesh->GetComponentLocation()) > FreezeDistanceSquared;
+
+		if (bSettled || bTooFar)
+		{
+			FreezeRagdoll(i);
+			continue;
+		}
+
+		NumBodies += Mesh->Bodies.Num();
+	}
+
+	SET_DWORD_STAT(STAT_SimulatingRagdolls, Ragdolls.Num());
+	SET_DWORD_STAT(STAT_SimulatingRagdollBodies, NumBodies);
+}
+
+
+bool URagdollSubsystem::IsTickable() const
+{
+	return Ragdolls.Num() > 0;
+}
+
+
+ETickableTickType URagdollSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+UWorld* URagdollSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+
+TStatId URagdollSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URagdollSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/ShooterActorChannel.h"
+#include "Framework/NetBandwidthProfiler.h"
+#include "GameFramework/Actor.h"
+#include "Net/DataBunch.h"
+
+FPacketIdRange UShooterActorChannel::SendBunch(FOutBunch* Bunch, bool Merge)
+{
+	FNetBandwidthProfiler& Profiler = FNetBandwidthProfiler::Get();
+
+	if (Profiler.IsEnabled() && Actor && Bunch)
+	{
+		if (Profiler.CurrentRPC.IsNone())
+		{
+			//Everything queued went out in this update or was dropped, either way none of it is waiting any more
+			const int64 RPCBits = FMath::Min<int64>(QueuedRPCBits, Bunch->GetNumBits());
+			QueuedRPCBits = 0;
+
+			Profiler.Track(ENetBandwidthCategory::ActorClass, Actor->GetClass()->GetFName(), Bunch->GetNumBits() - RPCBits);
+		}
+		else
+		{
+			Profiler.Track(ENetBandwidthCategory::RPC, Profiler.CurrentRPC, Bunch->GetNumBits());
+		}
+	}
+
+	return Super::SendBunch(Bunch, Merge);
+}
+
+
+void UShooterActorChannel::ReceivedBunch(FInBunch& Bunch)
+{
+	FNetBandwidthProfiler& Profiler = FNetBandwidthProfiler::Get();
+
+	//The first bunch spawns the actor, so we can only put it against the actor's class once it exists
+	if (Profiler.IsEnabled())
+	{
+		Profiler.Track(ENetBandwidthCategory::Received, Actor ? Actor->GetClass()->GetFName() : FName(TEXT("ActorSpawn")), Bunch.GetNumBits());
+	}
+
+	Super::ReceivedBunch(Bunch);
+}
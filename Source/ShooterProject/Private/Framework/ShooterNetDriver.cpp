@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Framework/ShooterNetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Framework/NetBandwidthProfiler.h"
+#include "Framework/ShooterActorChannel.h"
+#include "Net/DataBunch.h"
+#include "Net/DataReplication.h"
+
+//Bits of unreliable RPCs waiting on a channel to go out with the actor's next update
+static int64 GetQueuedRemoteFunctionBits(const UActorChannel* Channel, UObject* TargetObject)
+{
+	const TSharedRef<FObjectReplicator>* Replicator = Channel->ReplicationMap.Find(TargetObject);
+	return Replicator && (*Replicator)->RemoteFunctions ? (*Replicator)->RemoteFunctions->GetNumBits() : 0;
+}
+
+
+//Bits of unreliable RPCs waiting on a channel for the actor and all of its subobjects
+static int64 GetQueuedRemoteFunctionBits(const UActorChannel* Channel)
+{
+	int64 QueuedBits = 0;
+
+	for (const auto& Replicator : Channel->ReplicationMap)
+	{
+		if (Replicator.Value->RemoteFunctions)
+		{
+			QueuedBits += Replicator.Value->RemoteFunctions->GetNumBits();
+		}
+	}
+
+	return QueuedBits;
+}
+
+
+int32 UShooterNetDriver::ServerReplicateActors(float DeltaSeconds)
+{
+	//Queued RPCs can be dropped without ever being sent, so only keep taking off the actor class what is still queued
+	if (FNetBandwidthProfiler::Get().IsEnabled())
+	{
+		for (UNetConnection* Connection : ClientConnections)
+		{
+			if (!Connection)
+			{
+				continue;
+			}
+
+			for (const auto& ActorChannel : Connection->ActorChannelMap())
+			{
+				UShooterActorChannel* Channel = Cast<UShooterActorChannel>(ActorChannel.Value);
+
+				if (Channel && Channel->QueuedRPCBits > 0)
+				{
+					Channel->QueuedRPCBits = FMath::Min(Channel->QueuedRPCBits, GetQueuedRemoteFunctionBits(Channel));
+				}
+			}
+		}
+	}
+
+	return Super::ServerReplicateActors(DeltaSeconds);
+}
+
+
+void UShooterNetDriver::ProcessRemoteFunction(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject)
+{
+	FNetBandwidthProfiler& Profiler = FNetBandwidthProfiler::Get();
+
+	if (!Profiler.IsEnabled())
+	{
+		Super::ProcessRemoteFunction(Actor, Function, Parameters, OutParms, Stack, SubObject);
+		return;
+	}
+
+	//Qualified with the class, as components like the character movement send RPCs with very generic names
+	const FName RPCName(*FString::Printf(TEXT("%s::%s"), *Function->GetOuter()->GetName(), *Function->GetName()));
+
+	//Unreliable multicasts don't send a bunch straight away. They are queued on every connection's channel and go out
+	//inside the actor's next update, so see how much each connection's queue grew instead.
+	const bool bQueued = Function->HasAnyFunctionFlags(FUNC_NetMulticast) && !Function->HasAnyFunctionFlags(FUNC_NetReliable);
+	UObject* TargetObject = SubObject ? SubObject : Actor;
+
+	TArray<TPair<UShooterActorChannel*, int64>, TInlineAllocator<64>> QueuedBitsBefore;
+
+	if (bQueued)
+	{
+		for (UNetConnection* Connection : ClientConnections)
+		{
+			if (UShooterActorChannel* Channel = Connection ? Cast<UShooterActorChannel>(Connection->FindActorChannelRef(Actor)) : nullptr)
+			{
+				QueuedBitsBefore.Emplace(Channel, GetQueuedRemoteFunctionBits(Channel, TargetObject));
+			}
+		}
+	}
+
+	{
+		TGuardValue<FName> CurrentRPCGuard(Profiler.CurrentRPC, RPCName);
+		Super::ProcessRemoteFunction(Actor, Function, Parameters, OutParms, Stack, SubObject);
+	}
+
+	for (const TPair<UShooterActorChannel*, int64>& ChannelBits : QueuedBitsBefore)
+	{
+		const int64 QueuedBits = GetQueuedRemoteFunctionBits(ChannelBits.Key, TargetObject) - ChannelBits.Value;
+
+		//Nothing grew if the RPC was sent straight away or the queue was flushed, and then SendBunch already counted it
+		if (QueuedBits > 0)
+		{
+			Profiler.Track(ENetBandwidthCategory::RPC, RPCName, QueuedBits);
+			ChannelBits.Key->QueuedRPCBits += QueuedBits;
+		}
+	}
+}
@@ -2,6 +2,7 @@
 
 #include "Framework/ShooterProjectGameMode.h"
 #include "Player/ShooterProjectCharacter.h"
+#include "Kismet/GameplayStatics.h"
 #include "UObject/ConstructorHelpers.h"
 
 AShooterProjectGameMode::AShooterProjectGameMode()
@@ -12,4 +13,22 @@ AShooterProjectGameMode::AShooterProjectGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	LootSeed = 0;
+}
+
+
+void AShooterProjectGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	LootSeed = UGameplayStatics::GetIntOption(Options, TEXT("LootSeed"), LootSeed);
+
+	while (LootSeed == 0)
+	{
+		LootSeed = FMath::Rand();
+	}
+
+	//Logged so any match can be reproduced later
+	UE_LOG(LogTemp, Log, TEXT("Loot seed for %s is %d"), *MapName, LootSeed);
 }
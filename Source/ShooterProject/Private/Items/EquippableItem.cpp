@@ -27,9 +27,10 @@ void UEquippableItem::Use(class AShooterProjectCharacter* Character)
 {
 	if (Character && Character->HasAuthority())
 	{
-		if (Character->GetEquippedItems().Contains(Slot) && !bEquipped)
+		UEquippableItem* AlreadyEquippedItem = Character->GetEquippedItemSlots()[Slot];
+
+		if (AlreadyEquippedItem && !bEquipped)
 		{
-			UEquippableItem* AlreadyEquippedItem = *Character->GetEquippedItems().Find(Slot);
 			AlreadyEquippedItem->SetEquipped(false);
 		}
 
@@ -69,7 +70,10 @@ void UEquippableItem::SetEquipped(bool bNewEquipped)
 
 void UEquippableItem::EquipStatusChanged()
 {
-	if (AShooterProjectCharacter* Character = Cast<AShooterProjectCharacter>(GetOuter()))
+	//Clients get the characters equipped items replicated with the character, so only the server equips here
+	AShooterProjectCharacter* Character = Cast<AShooterProjectCharacter>(GetOuter());
+
+	if (Character && Character->HasAuthority())
 	{
 		if (bEquipped)
 		{
@@ -85,4 +89,40 @@ void UEquippableItem::EquipStatusChanged()
 	OnItemModified.Broadcast();
 }
 
+
+bool FEquippedItemSlots::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 OccupiedMask = Items.GetOccupiedMask();
+	Ar.SerializeBits(&OccupiedMask, TEquippableSlotArray<UEquippableItem*>::NumSlots);
+
+	if (Ar.IsLoading())
+	{
+		Items = TEquippableSlotArray<UEquippableItem*>();
+	}
+
+	bOutSuccess = true;
+
+	//Empty slots cost one bit each, only slots that have an item send it
+	for (uint32 Mask = OccupiedMask; Mask; Mask &= Mask - 1)
+	{
+		const EEquippableSlot Slot = (EEquippableSlot)FMath::CountTrailingZeros(Mask);
+
+		UObject* Item = Items[Slot];
+		bOutSuccess &= Map->SerializeObject(Ar, UEquippableItem::StaticClass(), Item);
+
+		if (Ar.IsLoading())
+		{
+			Items.Set(Slot, Cast<UEquippableItem>(Item));
+		}
+	}
+
+	return true;
+}
+
+
+void FEquippedItemSlots::AddStructReferencedObjects(FReferenceCollector& Collector) const
+{
+	const_cast<TEquippableSlotArray<UEquippableItem*>&>(Items).AddReferencedObjects(Collector);
+}
+
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Items/GearAppearanceCache.h"
+#include "Engine/SkeletalMesh.h"
+#include "Materials/MaterialInterface.h"
+
+FGearAppearanceCache& FGearAppearanceCache::Get()
+{
+	static FGearAppearanceCache Cache;
+	return Cache;
+}
+
+
+const FGearAppearance* FGearAppearanceCache::FindOrAdd(const EEquippableSlot Slot, USkeletalMesh* Mesh, UMaterialInterface* Material)
+{
+	const FAppearanceKey Key(Slot, Mesh, Material);
+
+	if (const TUniquePtr<FGearAppearance>* Appearance = Appearances.Find(Key))
+	{
+		return Appearance->Get();
+	}
+
+	TUniquePtr<FGearAppearance> Appearance = MakeUnique<FGearAppearance>();
+	Appearance->Slot = Slot;
+	Appearance->Mesh = Mesh;
+	Appearance->Material = Material;
+
+	//Only the last material is swapped, the rest are left to the mesh
+	if (Mesh && Material && Mesh->Materials.Num() > 0)
+	{
+		Appearance->OverrideMaterials.SetNum(Mesh->Materials.Num());
+		Appearance->OverrideMaterials.Last() = Material;
+	}
+
+	return Appearances.Add(Key, MoveTemp(Appearance)).Get();
+}
+
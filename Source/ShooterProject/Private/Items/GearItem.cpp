@@ -2,11 +2,14 @@
 
 
 #include "Items/GearItem.h"
+#include "Items/GearAppearanceCache.h"
 #include "Player/ShooterProjectCharacter.h"
+#include "Engine/SkeletalMesh.h"
 
 UGearItem::UGearItem()
 {
 	DamageDefenceMultiplier = 0.1f;
+	CachedAppearance = nullptr;
 }
 
 bool UGearItem::Equip(class AShooterProjectCharacter* Character)
@@ -32,3 +35,26 @@ bool UGearItem::Unequip(class AShooterProjectCharacter* Character)
 
 	return bUnEquipSuccessful;
 }
+
+const FGearAppearance* UGearItem::GetAppearance() const
+{
+	USkeletalMesh* LoadedMesh = Mesh.Get();
+
+	if (!LoadedMesh && !Mesh.IsNull())
+	{
+		return nullptr;
+	}
+
+	//Mesh and material can be changed from blueprints, so check they still match what we looked up
+	if (!CachedAppearance || CachedAppearance->Mesh.Get() != LoadedMesh || CachedAppearance->Material.Get() != MaterialInstance)
+	{
+		CachedAppearance = FGearAppearanceCache::Get().FindOrAdd(Slot, LoadedMesh, MaterialInstance);
+	}
+
+	return CachedAppearance;
+}
+
+USkeletalMesh* UGearItem::GetMesh() const
+{
+	return Mesh.Get();
+}
@@ -4,6 +4,10 @@
 #include "Items/Item.h"
 #include "Components/InventoryComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "Framework/AssetStreamingSubsystem.h"
+#include "Items/ItemTextCache.h"
 
 #define LOCTEXT_NAMESPACE "Item"
 
@@ -19,6 +23,22 @@ bool UItem::IsSupportedForNetworking() const
 	return true;
 }
 
+void UItem::PostLoad()
+{
+	Super::PostLoad();
+
+	//Saved when Thumbnail was the asset. Move it to ThumbnailAsset so once resaved or cooked, loading the item doesn't load its texture.
+	if (Thumbnail)
+	{
+		if (ThumbnailAsset.IsNull())
+		{
+			ThumbnailAsset = Thumbnail;
+		}
+
+		Thumbnail = nullptr;
+	}
+}
+
 #if WITH_EDITOR
 void UItem::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
 {
@@ -43,6 +63,7 @@ UItem::UItem()
 	Quantity = 1;
 	MaxStackSize = 2;
 	RepKey = 0;
+	Thumbnail = nullptr;
 }
 
 void UItem::OnRep_Quantity()
@@ -64,6 +85,47 @@ bool UItem::ShouldShowInInventory() const
 	return true;
 }
 
+UTexture2D* UItem::GetThumbnail() const
+{
+	return Thumbnail ? Thumbnail : ThumbnailAsset.Get();
+}
+
+void UItem::RequestThumbnail(const EAssetStreamPriority Priority, FSimpleDelegate OnLoaded /*= FSimpleDelegate()*/)
+{
+	if (Thumbnail)
+	{
+		OnLoaded.ExecuteIfBound();
+		return;
+	}
+
+	UWorld* World = GetWorld();
+
+	if (UAssetStreamingSubsystem* Streaming = World ? World->GetSubsystem<UAssetStreamingSubsystem>() : nullptr)
+	{
+		Streaming->RequestAsset(ThumbnailAsset.ToSoftObjectPath(), Priority, FSimpleDelegate::CreateUObject(this, &UItem::OnThumbnailLoaded, OnLoaded));
+	}
+}
+
+void UItem::OnThumbnailLoaded(FSimpleDelegate OnLoaded)
+{
+	Thumbnail = ThumbnailAsset.Get();
+
+	if (Thumbnail)
+	{
+		OnLoaded.ExecuteIfBound();
+	}
+}
+
+FText UItem::GetQuantityText() const
+{
+	return FItemTextCache::Get().GetQuantityText(this);
+}
+
+FText UItem::GetStackWeightText() const
+{
+	return FItemTextCache::Get().GetWeightText(this);
+}
+
 void UItem::Use(class AShooterProjectCharacter* Character)
 {
 
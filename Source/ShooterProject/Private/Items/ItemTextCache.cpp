@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Items/ItemTextCache.h"
+#include "Items/Item.h"
+#include "Internationalization/Internationalization.h"
+
+#define LOCTEXT_NAMESPACE "Inventory"
+
+//Each map is cleared once it reaches this many texts, so item classes and quantities that stop being shown don't build up
+static const int32 MaxCachedTexts = 1024;
+
+static FText FormatQuantityText(const FText& ItemName, const int32 Quantity)
+{
+	return FText::Format(LOCTEXT("ItemQuantityText", "{0} x{1}"), ItemName, FText::AsNumber(Quantity));
+}
+
+
+static FText FormatWeightText(const float Weight)
+{
+	FNumberFormattingOptions WeightFormat;
+	WeightFormat.MaximumFractionalDigits = 1;
+
+	return FText::Format(LOCTEXT("ItemWeightText", "{0} kg"), FText::AsNumber(Weight, &WeightFormat));
+}
+
+
+FItemTextCache& FItemTextCache::Get()
+{
+	static FItemTextCache Cache;
+	return Cache;
+}
+
+
+FItemTextCache::FItemTextCache()
+{
+	FInternationalization::Get().OnCultureChanged().AddRaw(this, &FItemTextCache::Empty);
+}
+
+
+FItemTextCache::~FItemTextCache()
+{
+	if (FInternationalization::IsAvailable())
+	{
+		FInternationalization::Get().OnCultureChanged().RemoveAll(this);
+	}
+}
+
+
+FText FItemTextCache::GetAddErrorText(const EItemAddError Error, TSubclassOf<UItem> ItemClass)
+{
+	const FErrorKey Key(Error, FObjectKey(ItemClass.Get()));
+
+	if (const FText* ErrorText = ErrorTexts.Find(Key))
+	{
+		return *ErrorText;
+	}
+
+	const UItem* ItemDefaults = ItemClass ? ItemClass->GetDefaultObject<UItem>() : nullptr;
+	const FText ItemName = ItemDefaults ? ItemDefaults->ItemDisplayName : FText::GetEmpty();
+
+	FText ErrorText;
+
+	switch (Error)
+	{
+	case EItemAddError::IAE_InventoryFull:
+		ErrorText = LOCTEXT("InventoryCapacityFullText", "Couldn't add item to inventory. Inventory is full");
+		break;
+	case EItemAddError::IAE_TooMuchWeight:
+		ErrorText = LOCTEXT("InventoryTooMuchWeightText", "Couldn't add item to Inventory. Carrying too much weight");
+		break;
+	case EItemAddError::IAE_NotAllAdded:
+		ErrorText = LOCTEXT("InventoryErrorText", "Couldn't add all of the item to your inventory");
+		break;
+	case EItemAddError::IAE_StackTooMuchWeight:
+		ErrorText = FText::Format(LOCTEXT("InventoryStackTooMuchWeightText", "Couldn't add entire stack of {ItemName} to Inventory"), ItemName);
+		break;
+	case EItemAddError::IAE_StackInventoryFull:
+		ErrorText = FText::Format(LOCTEXT("InventoryStackCapacityFullText", "Couldn't add entire stack of {ItemName} to Inventory. Inventory was full."), ItemName);
+		break;
+	case EItemAddError::IAE_CouldntAdd:
+		ErrorText = LOCTEXT("InventoryCouldntAddText", "Couldn't add item to inventory");
+		break;
+	case EItemAddError::IAE_FullStack:
+		ErrorText = FText::Format(LOCTEXT("InventoryFullStackText", "Couldn't add {ItemName}. You already have a full stack of this item"), ItemName);
+		break;
+	default:
+		break;
+	}
+
+	if (ErrorTexts.Num() >= MaxCachedTexts)
+	{
+		ErrorTexts.Empty();
+	}
+
+	return ErrorTexts.Add(Key, ErrorText);
+}
+
+
+FText FItemTextCache::GetQuantityText(const UItem* Item)
+{
+	if (!Item)
+	{
+		return FText::GetEmpty();
+	}
+
+	//The cache is per class, so it only holds for items still using their class's name
+	const UItem* ItemDefaults = Item->GetClass()->GetDefaultObject<UItem>();
+
+	if (!Item->ItemDisplayName.IdenticalTo(ItemDefaults->ItemDisplayName))
+	{
+		return FormatQuantityText(Item->ItemDisplayName, Item->GetQuantity());
+	}
+
+	const FQuantityKey Key(FObjectKey(Item->GetClass()), Item->GetQuantity());
+
+	if (const FText* QuantityText = QuantityTexts.Find(Key))
+	{
+		return *QuantityText;
+	}
+
+	if (QuantityTexts.Num() >= MaxCachedTexts)
+	{
+		QuantityTexts.Empty();
+	}
+
+	return QuantityTexts.Add(Key, FormatQuantityText(ItemDefaults->ItemDisplayName, Item->GetQuantity()));
+}
+
+
+FText FItemTextCache::GetWeightText(const UItem* Item)
+{
+	if (!Item)
+	{
+		return FText::GetEmpty();
+	}
+
+	//The cache is per class, so it only holds for items still using their class's weight
+	const UItem* ItemDefaults = Item->GetClass()->GetDefaultObject<UItem>();
+
+	if (Item->Weight != ItemDefaults->Weight)
+	{
+		return FormatWeightText(Item->GetStackWeight());
+	}
+
+	const FQuantityKey Key(FObjectKey(Item->GetClass()), Item->GetQuantity());
+
+	if (const FText* WeightText = WeightTexts.Find(Key))
+	{
+		return *WeightText;
+	}
+
+	if (WeightTexts.Num() >= MaxCachedTexts)
+	{
+		WeightTexts.Empty();
+	}
+
+	return WeightTexts.Add(Key, FormatWeightText(ItemDefaults->Weight * Item->GetQuantity()));
+}
+
+
+void FItemTextCache::Empty()
+{
+	ErrorTexts.Empty();
+	QuantityTexts.Empty();
+	WeightTexts.Empty();
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -2,17 +2,81 @@
 
 
 #include "Items/WeaponClass.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "Framework/AssetStreamingSubsystem.h"
+#include "Framework/BatchedTickSubsystem.h"
+#include "Framework/HitscanSubsystem.h"
+#include "Framework/ProjectileSubsystem.h"
+#include "Components/InventoryComponent.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "Player/ShooterProjectCharacter.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "TimerManager.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Fire RPCs"), STAT_WeaponFireRPCs, STATGROUP_Combat);
+
+CSV_DEFINE_CATEGORY(Weapons, true);
+
+//Count every RPC a client sends to make its weapon fire, so we can see what sustained fire costs
+static void RecordFireRPC()
+{
+	INC_DWORD_STAT(STAT_WeaponFireRPCs);
+	CSV_CUSTOM_STAT(Weapons, FireRPCs, 1, ECsvCustomStatOp::Accumulate);
+}
+
+
+bool FHitscanImpact::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 bHit = bBlockingHit;
+	Ar.SerializeBits(&bHit, 1);
+	bBlockingHit = bHit;
+
+	bOutSuccess = true;
+
+	bool bLocationSuccess = true;
+	Location.NetSerialize(Ar, Map, bLocationSuccess);
+	bOutSuccess &= bLocationSuccess;
+
+	//Misses don't have a surface, so there's no normal worth sending
+	if (bBlockingHit)
+	{
+		bool bNormalSuccess = true;
+		Normal.NetSerialize(Ar, Map, bNormalSuccess);
+		bOutSuccess &= bNormalSuccess;
+	}
+
+	return true;
+}
 
 // Sets default values
 AWeaponClass::AWeaponClass()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	//The batched tick subsystem handles firing, so weapons don't need a tick of their own
+	PrimaryActorTick.bCanEverTick = false;
 
 	WeaponMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("WeaponMesh"));
 	RootComponent = WeaponMesh;
 
+	SetReplicates(true);
+
+	FireMode = EWeaponFireMode::Projectile;
+	HitscanRange = 10000.f;
+	ShotDamage = 20.f;
+	MuzzleVelocity = 80000.f;
+	ProjectileDrag = 0.000002f;
+	ProjectileLifetime = 3.f;
+	ReloadDuration = 2.f;
+
+	CurrentState = EWeaponState::IDLE;
+	BurstShots = 0;
+	BurstStartTime = 0.f;
+	bWantsToFire = false;
+	bPendingReload = false;
+	bPendingEquip = false;
+	bPendingUnequip = false;
 }
 
 // Called when the game starts or when spawned
@@ -22,25 +86,501 @@ void AWeaponClass::BeginPlay()
 	
 }
 
-// Called every frame
-void AWeaponClass::Tick(float DeltaTime)
+void AWeaponClass::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(TimerHandle_Reload);
+	GetWorldTimerManager().ClearTimer(TimerHandle_Equip);
+
+	if (UBatchedTickSubsystem* BatchedTick = GetWorld()->GetSubsystem<UBatchedTickSubsystem>())
+	{
+		BatchedTick->RemoveWeapon(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AWeaponClass::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	//Only the owner needs the ammo count, everyone else just sees the shots
+	DOREPLIFETIME_CONDITION(AWeaponClass, WeaponData, COND_OwnerOnly);
+}
+
+void AWeaponClass::StartFire()
+{
+	if (!bWantsToFire)
+	{
+		bWantsToFire = true;
+		BurstShots = 0;
+		BurstStartTime = GetWorld()->GetTimeSeconds();
+
+		if (!HasAuthority())
+		{
+			ServerStartFire();
+			RecordFireRPC();
+		}
+
+		DetermineWeaponState();
+	}
+}
+
+void AWeaponClass::StopFire()
+{
+	if (bWantsToFire)
+	{
+		bWantsToFire = false;
+
+		if (!HasAuthority())
+		{
+			ServerStopFire((uint16)FMath::Min<int32>(BurstShots, MAX_uint16));
+			RecordFireRPC();
+		}
+
+		DetermineWeaponState();
+	}
+}
+
+void AWeaponClass::ServerStartFire_Implementation()
+{
+	StartFire();
+}
+
+void AWeaponClass::ServerStopFire_Implementation(const uint16 ClientBurstShots)
+{
+	//The client may have fired a shot that is due on our fire timer but hasn't had a frame to go off here yet, so fire it now.
+	//We never fire ahead of our own timer, and never more shots than fit in the time since our burst started, so spamming
+	//start and stop can't get a client more shots than holding the trigger would.
+	if (CurrentState == EWeaponState::FIRING)
+	{
+		const double Now = GetWorld()->GetTimeSeconds();
+		const float TimeBetweenShots = FMath::Max(WeaponData.TimeBetweenShots, 0.01f);
+		const int32 MaxBurstShots = FMath::FloorToInt((Now - BurstStartTime) / TimeBetweenShots) + 1;
+		const int32 TargetShots = FMath::Min<int32>(ClientBurstShots, MaxBurstShots);
+
+		while (BurstShots < TargetShots && FireTimer.IsShotDue(Now) && WeaponData.RemainingAmmo > 0)
+		{
+			FireShot();
+			FireTimer.ShotFired(TimeBetweenShots);
+		}
+	}
+
+	StopFire();
+}
+
+void AWeaponClass::StartReload()
+{
+	if (CanReload())
+	{
+		if (!HasAuthority() && OwningCharacter->IsLocallyControlled())
+		{
+			ServerStartReload();
+		}
+
+		bPendingReload = true;
+		DetermineWeaponState();
+
+		const float Duration = PlayPawnAnimation(ReloadAnim, ReloadDuration);
+		GetWorldTimerManager().SetTimer(TimerHandle_Reload, this, &AWeaponClass::FinishReload, FMath::Max(Duration, 0.1f), false);
+	}
+}
+
+void AWeaponClass::ServerStartReload_Implementation()
+{
+	StartReload();
+}
+
+void AWeaponClass::FinishReload()
+{
+	const int32 AmmoNeeded = FMath::Max(WeaponData.MagazineSize - WeaponData.RemainingAmmo, 0);
+	int32 AmmoLoaded = AmmoNeeded;
+
+	if (AmmoClass)
+	{
+		if (HasAuthority())
+		{
+			UInventoryComponent* Inventory = OwningCharacter ? OwningCharacter->PlayerInventory : nullptr;
+			AmmoLoaded = Inventory ? Inventory->ConsumeItemsByClass(AmmoClass, AmmoNeeded) : 0;
+		}
+		else
+		{
+			//Predict what the server will load, it replicates the real count back to us
+			AmmoLoaded = FMath::Min(AmmoNeeded, GetInventoryAmmo());
+		}
+	}
+
+	WeaponData.RemainingAmmo += AmmoLoaded;
+
+	bPendingReload = false;
+	DetermineWeaponState();
+}
+
+void AWeaponClass::OnEquip(AShooterProjectCharacter* NewOwner)
+{
+	if (!NewOwner)
+	{
+		return;
+	}
+
+	OwningCharacter = NewOwner;
+
+	if (HasAuthority())
+	{
+		SetOwner(NewOwner);
+	}
+
+	//Only our own weapons show up in the UI
+	if (NewOwner->IsLocallyControlled())
+	{
+		if (UAssetStreamingSubsystem* Streaming = GetWorld()->GetSubsystem<UAssetStreamingSubsystem>())
+		{
+			Streaming->RequestAsset(WeaponData.ThumbnailNormal.ToSoftObjectPath(), EAssetStreamPriority::VisibleUI, FSimpleDelegate::CreateUObject(this, &AWeaponClass::OnThumbnailLoaded));
+			Streaming->RequestAsset(WeaponData.ThumbnailHover.ToSoftObjectPath(), EAssetStreamPriority::VisibleUI, FSimpleDelegate::CreateUObject(this, &AWeaponClass::OnThumbnailLoaded));
+		}
+	}
+
+	AttachToComponent(NewOwner->GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, WeaponData.AttachSocket);
+
+	GetWorldTimerManager().ClearTimer(TimerHandle_Equip);
+	bPendingUnequip = false;
+	bPendingEquip = true;
+	DetermineWeaponState();
+
+	const float Duration = PlayPawnAnimation(EquipAnim);
+
+	if (Duration > 0.f)
+	{
+		GetWorldTimerManager().SetTimer(TimerHandle_Equip, this, &AWeaponClass::FinishEquip, Duration, false);
+	}
+	else
+	{
+		FinishEquip();
+	}
+}
+
+void AWeaponClass::FinishEquip()
+{
+	bPendingEquip = false;
+	DetermineWeaponState();
+}
+
+void AWeaponClass::OnUnequip()
+{
+	//Putting the weapon away cancels whatever it was doing. The server does the same, so there's nothing to send.
+	bWantsToFire = false;
+	bPendingReload = false;
+	bPendingEquip = false;
+	GetWorldTimerManager().ClearTimer(TimerHandle_Reload);
+	GetWorldTimerManager().ClearTimer(TimerHandle_Equip);
+
+	bPendingUnequip = true;
+	DetermineWeaponState();
+
+	const float Duration = PlayPawnAnimation(UnequipAnim);
+
+	if (Duration > 0.f)
+	{
+		GetWorldTimerManager().SetTimer(TimerHandle_Equip, this, &AWeaponClass::FinishUnequip, Duration, false);
+	}
+	else
+	{
+		FinishUnequip();
+	}
+}
+
+void AWeaponClass::FinishUnequip()
+{
+	bPendingUnequip = false;
+
+	if (OwningCharacter)
+	{
+		AttachToComponent(OwningCharacter->GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, WeaponData.DetachSocket);
+	}
+
+	DetermineWeaponState();
+}
+
+bool AWeaponClass::CanFire() const
 {
-	Super::Tick(DeltaTime);
+	return OwningCharacter && !bPendingEquip && !bPendingUnequip && !bPendingReload && WeaponData.RemainingAmmo > 0;
+}
+
+bool AWeaponClass::CanReload() const
+{
+	const bool bHasAmmoToLoad = !AmmoClass || GetInventoryAmmo() > 0;
+	return OwningCharacter && !bPendingEquip && !bPendingUnequip && !bPendingReload && WeaponData.RemainingAmmo < WeaponData.MagazineSize && bHasAmmoToLoad;
+}
+
+void AWeaponClass::OnThumbnailLoaded()
+{
+	//GetThumbnailNormal and GetThumbnailHover were null until now, so have the hotbar's weapon slots read them again
+	if (OwningCharacter && OwningCharacter->IsLocallyControlled())
+	{
+		OwningCharacter->RefreshEquippedSlot(EEquippableSlot::EIS_PrimaryWeapon);
+		OwningCharacter->RefreshEquippedSlot(EEquippableSlot::EIS_SecondaryWeapon);
+	}
+}
+
+UTexture2D* AWeaponClass::GetThumbnailNormal() const
+{
+	return WeaponData.ThumbnailNormal.Get();
+}
+
+UTexture2D* AWeaponClass::GetThumbnailHover() const
+{
+	return WeaponData.ThumbnailHover.Get();
+}
 
+int32 AWeaponClass::GetInventoryAmmo() const
+{
+	const UInventoryComponent* Inventory = OwningCharacter ? OwningCharacter->PlayerInventory : nullptr;
+	return Inventory && AmmoClass ? Inventory->GetItemQuantity(AmmoClass) : 0;
+}
+
+void AWeaponClass::DetermineWeaponState()
+{
+	EWeaponState NewState = EWeaponState::IDLE;
+
+	if (bPendingUnequip)
+	{
+		NewState = EWeaponState::UNEQUIPPING;
+	}
+	else if (bPendingEquip)
+	{
+		NewState = EWeaponState::EQUIPPING;
+	}
+	else if (bPendingReload)
+	{
+		NewState = EWeaponState::RELOADING;
+	}
+	else if (bWantsToFire && CanFire())
+	{
+		NewState = EWeaponState::FIRING;
+	}
+
+	SetWeaponState(NewState);
+}
+
+void AWeaponClass::SetWeaponState(const EWeaponState NewState)
+{
+	if (CurrentState == NewState)
+	{
+		return;
+	}
+
+	const EWeaponState PreviousState = CurrentState;
+	CurrentState = NewState;
+
+	if (NewState == EWeaponState::FIRING)
+	{
+		FireTimer.Start(GetWorld()->GetTimeSeconds());
+
+		//Shots after the first are fired by the batched tick subsystem while we're in this state
+		if (UBatchedTickSubsystem* BatchedTick = GetWorld()->GetSubsystem<UBatchedTickSubsystem>())
+		{
+			BatchedTick->AddWeapon(this);
+		}
+
+		HandleFiring();
+	}
+	else if (PreviousState == EWeaponState::FIRING)
+	{
+		if (UBatchedTickSubsystem* BatchedTick = GetWorld()->GetSubsystem<UBatchedTickSubsystem>())
+		{
+			BatchedTick->RemoveWeapon(this);
+		}
+	}
+}
+
+void AWeaponClass::HandleFiring()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	const float TimeBetweenShots = FMath::Max(WeaponData.TimeBetweenShots, 0.01f);
+
+	while (CurrentState == EWeaponState::FIRING && FireTimer.IsShotDue(Now))
+	{
+		if (WeaponData.RemainingAmmo <= 0)
+		{
+			//Reload straight away if we have the ammo for it, otherwise stop until there's something to shoot
+			if (CanReload())
+			{
+				StartReload();
+			}
+			else
+			{
+				DetermineWeaponState();
+			}
+
+			break;
+		}
+
+		FireShot();
+		FireTimer.ShotFired(TimeBetweenShots);
+	}
+}
+
+void AWeaponClass::FireShot()
+{
+	--WeaponData.RemainingAmmo;
+	++BurstShots;
+
+	if (OwningCharacter && OwningCharacter->IsLocallyControlled())
+	{
+		PlayFireEffects();
+		PlayPawnAnimation(FireAnim);
+	}
+
+	if (HasAuthority())
+	{
+		switch (FireMode)
+		{
+		case EWeaponFireMode::Hitscan:
+			FireHitscan();
+			break;
+		case EWeaponFireMode::Ballistic:
+			FireBallistic();
+			break;
+		default:
+			FireProjectile();
+			break;
+		}
+	}
+}
+
+float AWeaponClass::PlayPawnAnimation(const FWeaponAnim& Animation, const float Fallback /*= 0.f*/)
+{
+	float Duration = 0.f;
+
+	if (OwningCharacter && Animation.Pawn)
+	{
+		Duration = OwningCharacter->PlayAnimMontage(Animation.Pawn);
+	}
+
+	return Duration > 0.f ? Duration : Fallback;
 }
 
 void AWeaponClass::Fire()
 {
-	AActor* PawnOwner = GetOwner();
-	if (PawnOwner)
+	//Already holding the trigger, releasing it here would cut the burst short
+	if (!bWantsToFire)
 	{
-		FVector MuzzleLocation = WeaponMesh->GetSocketLocation("Muzzle");
-		FRotator MuzzleRotation = WeaponMesh->GetSocketRotation("Muzzle");
+		StartFire();
+		StopFire();
+	}
+}
+
+void AWeaponClass::FireHitscan()
+{
+	if (UHitscanSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanSubsystem>())
+	{
+		const FVector MuzzleLocation = WeaponMesh->GetSocketLocation("Muzzle");
+
+		//Shoot where the owner is aiming rather than where the barrel points, so shots go where the crosshair is
+		const APawn* PawnOwner = Cast<APawn>(GetOwner());
+		const FVector AimDirection = PawnOwner ? PawnOwner->GetBaseAimRotation().Vector() : WeaponMesh->GetSocketRotation("Muzzle").Vector();
+
+		Hitscan->QueueShot(this, MuzzleLocation, MuzzleLocation + (AimDirection * HitscanRange));
+	}
+}
+
+void AWeaponClass::FireBallistic()
+{
+	if (UProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UProjectileSubsystem>())
+	{
+		const FVector MuzzleLocation = WeaponMesh->GetSocketLocation("Muzzle");
+
+		const APawn* PawnOwner = Cast<APawn>(GetOwner());
+		const FVector AimDirection = PawnOwner ? PawnOwner->GetBaseAimRotation().Vector() : WeaponMesh->GetSocketRotation("Muzzle").Vector();
+		const FVector Velocity = AimDirection * MuzzleVelocity;
+
+		//The subsystem tells clients about every round we fired this frame in one go
+		ProjectileSubsystem->SpawnProjectile(this, MuzzleLocation, Velocity, ProjectileDrag, ProjectileLifetime);
+	}
+}
 
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+void AWeaponClass::FireProjectile()
+{
+	FVector MuzzleLocation = WeaponMesh->GetSocketLocation("Muzzle");
+	FRotator MuzzleRotation = WeaponMesh->GetSocketRotation("Muzzle");
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	GetWorld()->SpawnActor<AActor>(ProjectileClass, MuzzleLocation, MuzzleRotation);
+}
+
+void AWeaponClass::OnHitscanShotsResolved(const FHitscanShotsFired& ShotsFired)
+{
+	MulticastShotsFired(ShotsFired);
+}
 
-		GetWorld()->SpawnActor<AActor>(ProjectileClass, MuzzleLocation, MuzzleRotation);
+void AWeaponClass::MulticastShotsFired_Implementation(const FHitscanShotsFired& ShotsFired)
+{
+	OnShotsFired(ShotsFired);
+}
+
+void AWeaponClass::OnBallisticShotsFired(const FBallisticShotsFired& ShotsFired)
+{
+	MulticastBallisticShotsFired(ShotsFired);
+}
+
+void AWeaponClass::MulticastBallisticShotsFired_Implementation(const FBallisticShotsFired& ShotsFired)
+{
+	for (const FVector_NetQuantize10& Velocity : ShotsFired.Velocities)
+	{
+		OnProjectileFired(ShotsFired.Origin, Velocity);
 	}
 }
 
+
+static FAutoConsoleCommand SimulateWeaponFireCommand(
+	TEXT("weapon.SimulateFire"),
+	TEXT("Run the weapon fire timer through bursts of sustained fire at a random 30-144fps and print shots and fire RPCs per second. Usage: weapon.SimulateFire [Seconds] [TimeBetweenShots] [BurstSeconds]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const double Seconds = Args.Num() > 0 ? FMath::Max(1.f, FCString::Atof(*Args[0])) : 60.0;
+		const float TimeBetweenShots = Args.Num() > 1 ? FMath::Max(0.01f, FCString::Atof(*Args[1])) : 0.08f;
+		const double BurstSeconds = Args.Num() > 2 ? FMath::Max(0.01f, FCString::Atof(*Args[2])) : 2.0;
+
+		FRandomStream RandomStream(1);
+		FWeaponFireTimer FireTimer;
+
+		double Now = 0.0;
+		int64 NumShots = 0;
+		int64 NumExpectedShots = 0;
+		int64 NumBursts = 0;
+
+		while (Now < Seconds)
+		{
+			const double BurstStart = Now;
+			double LastHeldFrame = Now;
+
+			FireTimer.Start(Now);
+			++NumBursts;
+
+			//Hold the trigger until the first frame after the burst should end
+			while (Now < BurstStart + BurstSeconds)
+			{
+				while (FireTimer.IsShotDue(Now))
+				{
+					++NumShots;
+					FireTimer.ShotFired(TimeBetweenShots);
+				}
+
+				LastHeldFrame = Now;
+				Now += RandomStream.FRandRange(1.f / 144.f, 1.f / 30.f);
+			}
+
+			//One shot when the trigger is pulled, then one every TimeBetweenShots for as long as it was held
+			NumExpectedShots += FMath::FloorToInt((LastHeldFrame - BurstStart) / TimeBetweenShots) + 1;
+
+			//Let go for a moment before the next burst
+			Now += 0.5;
+		}
+
+		//Every burst costs a start and a stop RPC. Before bursts, every shot was its own RPC.
+		const int64 NumBurstRPCs = NumBursts * 2;
+
+		UE_LOG(LogTemp, Log, TEXT("weapon.SimulateFire: %lld bursts over %.1fs, %lld shots fired, %lld expected"), NumBursts, Now, NumShots, NumExpectedShots);
+		UE_LOG(LogTemp, Log, TEXT("  %.2f shots/s, %.2f fire RPCs/s (%.2f with one RPC per shot)"), NumShots / Now, NumBurstRPCs / Now, NumShots / Now);
+	}));
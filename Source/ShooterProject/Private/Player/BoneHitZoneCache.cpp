@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Player/BoneHitZoneCache.h"
+#include "Engine/SkeletalMesh.h"
+
+FBoneHitZoneCache& FBoneHitZoneCache::Get()
+{
+	static FBoneHitZoneCache Cache;
+	return Cache;
+}
+
+
+TSharedPtr<const FBoneHitZones> FBoneHitZoneCache::FindOrAdd(const USkeletalMesh* Mesh, const UClass* CharacterClass, const TMap<FName, EEquippableSlot>& HitZoneBones)
+{
+	if (!Mesh)
+	{
+		return nullptr;
+	}
+
+	const FHitZonesKey Key(Mesh, CharacterClass);
+
+	if (const TSharedPtr<const FBoneHitZones>* CachedHitZones = HitZones.Find(Key))
+	{
+		return *CachedHitZones;
+	}
+
+	//Don't keep tables around for meshes and classes that were unloaded
+	for (auto It = HitZones.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().Get<0>().ResolveObjectPtr() || !It.Key().Get<1>().ResolveObjectPtr())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	const FReferenceSkeleton& RefSkeleton = Mesh->RefSkeleton;
+
+	TArray<EEquippableSlot> BoneZones;
+	BoneZones.SetNumUninitialized(RefSkeleton.GetNum());
+
+	TSharedPtr<FBoneHitZones> NewHitZones = MakeShared<FBoneHitZones>();
+	NewHitZones->Reserve(RefSkeleton.GetNum());
+
+	//Parents always come before their children, so every unlisted bone can just copy its parent
+	for (int32 BoneIndex = 0; BoneIndex < RefSkeleton.GetNum(); ++BoneIndex)
+	{
+		const FName BoneName = RefSkeleton.GetBoneName(BoneIndex);
+
+		if (const EEquippableSlot* Zone = HitZoneBones.Find(BoneName))
+		{
+			BoneZones[BoneIndex] = *Zone;
+		}
+		else
+		{
+			const int32 ParentIndex = RefSkeleton.GetParentIndex(BoneIndex);
+			BoneZones[BoneIndex] = ParentIndex != INDEX_NONE ? BoneZones[ParentIndex] : EEquippableSlot::EIS_Chest;
+		}
+
+		NewHitZones->Add(BoneName, BoneZones[BoneIndex]);
+	}
+
+	return HitZones.Add(Key, NewHitZones);
+}
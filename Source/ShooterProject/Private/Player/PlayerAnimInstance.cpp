@@ -3,62 +3,75 @@
 
 #include "Player/PlayerAnimInstance.h"
 
-#include "GameFramework/PawnMovementComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
 #include "Player/ShooterProjectCharacter.h"
-#include "Engine.h"
 
-UPlayerAnimInstance::UPlayerAnimInstance()
-{
-	bIsInAir = false;
-	Speed = 0.f;
-	Direction = 0.f;
-}
-
-
-void UPlayerAnimInstance::NativeInitializeAnimation()
+void FPlayerAnimInstanceProxy::Initialize(UAnimInstance* InAnimInstance)
 {
-	Super::NativeInitializeAnimation();
+	FAnimInstanceProxy::Initialize(InAnimInstance);
 
-	// Cache pawn
-	Owner = TryGetPawnOwner();
+	// Cache character
+	PlayerAnimInstance = CastChecked<UPlayerAnimInstance>(InAnimInstance);
+	Character = Cast<AShooterProjectCharacter>(InAnimInstance->TryGetPawnOwner());
 }
 
 
-void UPlayerAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+void FPlayerAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
 {
-	Super::NativeUpdateAnimation(DeltaSeconds);
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
 
-	// ensure that owner is valid
-	if (!Owner)
+	// ensure that character is valid
+	if (!Character)
 	{
 		return;
 	}
 
-	if (Owner->IsA(AShooterProjectCharacter::StaticClass()))
-	{
-		AShooterProjectCharacter* PlayerCharacter = Cast<AShooterProjectCharacter>(Owner);
-		if (PlayerCharacter)
-		{
-			
-			bIsInAir = PlayerCharacter->GetMovementComponent()->IsFalling();
-			bIsLocallyControlled = PlayerCharacter->IsLocallyControlled();
-			Speed = PlayerCharacter->GetVelocity().Size();
-			Velocity = PlayerCharacter->GetVelocity();
-			ActorRotation = PlayerCharacter->GetActorRotation();
-			Direction = CalculateDirection(Velocity, ActorRotation);
-
-			// Animation States
-			bIsStanding = PlayerCharacter->CurrentState == EPawnStates::STAND;
-			bIsCrouching = PlayerCharacter->CurrentState == EPawnStates::CROUCH;
-			bIsProning = PlayerCharacter->CurrentState == EPawnStates::PRONE;
+	const FVector Velocity = Character->GetVelocity();
+	const FRotator ActorRotation = Character->GetActorRotation();
 
-		}
+	PlayerAnimInstance->bIsLocallyControlled = Character->IsLocallyControlled();
+	PlayerAnimInstance->Velocity = Velocity;
+	PlayerAnimInstance->ActorRotation = ActorRotation;
+
+	//The scalar path is only needed until the locomotion subsystem's pass has run for our character
+	const FCharacterLocomotion& Locomotion = Character->GetLocomotion();
+
+	if (Locomotion.bValid)
+	{
+		PlayerAnimInstance->bIsInAir = Locomotion.bIsInAir;
+		PlayerAnimInstance->Speed = Locomotion.Speed;
+		PlayerAnimInstance->Direction = Locomotion.Direction;
+	}
+	else
+	{
+		PlayerAnimInstance->bIsInAir = Character->GetCharacterMovement()->IsFalling();
+		PlayerAnimInstance->Speed = Velocity.Size();
+		PlayerAnimInstance->Direction = UPlayerAnimInstance::CalculateDirection(Velocity, ActorRotation);
 	}
+
+	// Animation States
+	PlayerAnimInstance->bIsStanding = Character->CurrentState == EPawnStates::STAND;
+	PlayerAnimInstance->bIsCrouching = Character->CurrentState == EPawnStates::CROUCH;
+	PlayerAnimInstance->bIsProning = Character->CurrentState == EPawnStates::PRONE;
+}
+
+
+UPlayerAnimInstance::UPlayerAnimInstance()
+{
+	bIsInAir = false;
+	Speed = 0.f;
+	Direction = 0.f;
+}
+
+
+FAnimInstanceProxy* UPlayerAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FPlayerAnimInstanceProxy(this);
 }
 
 
 //Calculate direction
-float UPlayerAnimInstance::CalculateDirection(const FVector& PlayerVelocity, const FRotator& PlayerRotation) const
+float UPlayerAnimInstance::CalculateDirection(const FVector& PlayerVelocity, const FRotator& PlayerRotation)
 {
 	if (!PlayerVelocity.IsNearlyZero())
 	{
@@ -83,4 +96,4 @@ float UPlayerAnimInstance::CalculateDirection(const FVector& PlayerVelocity, con
 	}
 
 	return 0.f;
-}
\ No newline at end of file
+}
@@ -0,0 +1,336 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Player/ShooterCharacterMovement.h"
+#include "Components/CapsuleComponent.h"
+#include "EngineUtils.h"
+#include "Framework/MeshMergeSubsystem.h"
+#include "GameFramework/Character.h"
+#include "Player/ShooterProjectCharacter.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Corrections This Frame"), STAT_MovementCorrectionsThisFrame, STATGROUP_Characters);
+
+/** A saved move that remembers whether we wanted to sprint or go prone, so the move is sent and replayed with them */
+class FSavedMove_Shooter : public FSavedMove_Character
+{
+public:
+
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override
+	{
+		Super::Clear();
+
+		bSavedWantsToSprint = false;
+		bSavedWantsToProne = false;
+	}
+
+	virtual uint8 GetCompressedFlags() const override
+	{
+		uint8 Result = Super::GetCompressedFlags();
+
+		if (bSavedWantsToSprint)
+		{
+			Result |= FLAG_Custom_0;
+		}
+
+		if (bSavedWantsToProne)
+		{
+			Result |= FLAG_Custom_1;
+		}
+
+		return Result;
+	}
+
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override
+	{
+		const FSavedMove_Shooter* NewShooterMove = static_cast<const FSavedMove_Shooter*>(NewMove.Get());
+
+		if (bSavedWantsToSprint != NewShooterMove->bSavedWantsToSprint || bSavedWantsToProne != NewShooterMove->bSavedWantsToProne)
+		{
+			return false;
+		}
+
+		return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+	}
+
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override
+	{
+		Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+		const UShooterCharacterMovement* Movement = CastChecked<UShooterCharacterMovement>(C->GetCharacterMovement());
+		bSavedWantsToSprint = Movement->bWantsToSprint;
+		bSavedWantsToProne = Movement->bWantsToProne;
+	}
+
+	virtual void PrepMoveFor(ACharacter* C) override
+	{
+		Super::PrepMoveFor(C);
+
+		UShooterCharacterMovement* Movement = CastChecked<UShooterCharacterMovement>(C->GetCharacterMovement());
+		Movement->bWantsToSprint = bSavedWantsToSprint;
+		Movement->bWantsToProne = bSavedWantsToProne;
+	}
+
+	uint8 bSavedWantsToSprint : 1;
+	uint8 bSavedWantsToProne : 1;
+};
+
+class FNetworkPredictionData_Client_Shooter : public FNetworkPredictionData_Client_Character
+{
+public:
+
+	FNetworkPredictionData_Client_Shooter(const UCharacterMovementComponent& ClientMovement)
+		: FNetworkPredictionData_Client_Character(ClientMovement)
+	{
+	}
+
+	virtual FSavedMovePtr AllocateNewMove() override
+	{
+		return FSavedMovePtr(new FSavedMove_Shooter());
+	}
+};
+
+
+UShooterCharacterMovement::UShooterCharacterMovement()
+{
+	MaxWalkSpeed = 450.f;
+	MaxWalkSpeedCrouched = 200.f;
+	MaxWalkSpeedSprint = 600.f;
+	MaxWalkSpeedProne = 100.f;
+
+	//The default crouched height is smaller than our capsule radius, which would make crouching and prone the same
+	CrouchedHalfHeight = 64.f;
+	ProneHalfHeight = 42.f;
+	StandardCrouchedHalfHeight = CrouchedHalfHeight;
+
+	bWantsToSprint = false;
+	bWantsToProne = false;
+	bIsProne = false;
+
+	NumCorrections = 0;
+	CorrectionCountStartTime = 0.f;
+}
+
+
+void UShooterCharacterMovement::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	StandardCrouchedHalfHeight = CrouchedHalfHeight;
+}
+
+
+void UShooterCharacterMovement::SetWantedStance(const EPawnStates Stance)
+{
+	bWantsToCrouch = Stance == EPawnStates::CROUCH;
+	bWantsToProne = Stance == EPawnStates::PRONE;
+}
+
+
+EPawnStates UShooterCharacterMovement::GetWantedStance() const
+{
+	return bWantsToProne ? EPawnStates::PRONE : bWantsToCrouch ? EPawnStates::CROUCH : EPawnStates::STAND;
+}
+
+
+EPawnStates UShooterCharacterMovement::GetStance() const
+{
+	return bIsProne ? EPawnStates::PRONE : IsCrouching() ? EPawnStates::CROUCH : EPawnStates::STAND;
+}
+
+
+bool UShooterCharacterMovement::IsSprinting() const
+{
+	return bWantsToSprint && IsMovingOnGround() && !IsCrouching() && Velocity.SizeSquared2D() > FMath::Square(MaxWalkSpeedCrouched);
+}
+
+
+void UShooterCharacterMovement::SetSimulatedStance(const EPawnStates Stance)
+{
+	if (!HasValidData())
+	{
+		return;
+	}
+
+	bIsProne = Stance == EPawnStates::PRONE;
+
+	const float TargetHalfHeight = bIsProne ? ProneHalfHeight : StandardCrouchedHalfHeight;
+
+	if (CrouchedHalfHeight == TargetHalfHeight)
+	{
+		return;
+	}
+
+	CrouchedHalfHeight = TargetHalfHeight;
+
+	//bIsCrouched may have replicated before our stance and crouched us to the other height
+	if (CharacterOwner->bIsCrouched)
+	{
+		UnCrouch(true);
+		Crouch(true);
+	}
+}
+
+
+float UShooterCharacterMovement::GetCorrectionsPerMinute() const
+{
+	const UWorld* World = GetWorld();
+	const float Minutes = World ? (World->GetTimeSeconds() - CorrectionCountStartTime) / 60.f : 0.f;
+
+	return Minutes > 0.f ? NumCorrections / Minutes : 0.f;
+}
+
+
+void UShooterCharacterMovement::ResetCorrectionCount()
+{
+	NumCorrections = 0;
+	CorrectionCountStartTime = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+}
+
+
+float UShooterCharacterMovement::GetMaxSpeed() const
+{
+	if (MovementMode == MOVE_Walking || MovementMode == MOVE_NavWalking)
+	{
+		if (bIsProne)
+		{
+			return MaxWalkSpeedProne;
+		}
+
+		if (bWantsToSprint && !IsCrouching())
+		{
+			return MaxWalkSpeedSprint;
+		}
+	}
+
+	return Super::GetMaxSpeed();
+}
+
+
+bool UShooterCharacterMovement::CanAttemptJump() const
+{
+	return !bIsProne && Super::CanAttemptJump();
+}
+
+
+void UShooterCharacterMovement::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	//Replaces the crouch handling in the base class, which would stand us back up while we're prone as we don't want to crouch
+	if (CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
+	const bool bCanCrouch = CanCrouchInCurrentState();
+	const bool bShouldProne = bWantsToProne && bCanCrouch && IsMovingOnGround();
+	const bool bShouldCrouch = (bWantsToCrouch || bShouldProne) && bCanCrouch;
+	const float TargetHalfHeight = bShouldProne ? ProneHalfHeight : StandardCrouchedHalfHeight;
+
+	//Going between crouched and prone means standing up first, as the crouch code only works from standing height
+	if (IsCrouching() && (!bShouldCrouch || CrouchedHalfHeight != TargetHalfHeight))
+	{
+		UnCrouch(false);
+	}
+
+	if (!IsCrouching() && bShouldCrouch)
+	{
+		CrouchedHalfHeight = TargetHalfHeight;
+		Crouch(false);
+	}
+
+	//If there wasn't room to get up we stay at whatever height we were
+	bIsProne = IsCrouching() && CrouchedHalfHeight == ProneHalfHeight;
+}
+
+
+void UShooterCharacterMovement::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+	bWantsToProne = (Flags & FSavedMove_Character::FLAG_Custom_1) != 0;
+}
+
+
+FNetworkPredictionData_Client* UShooterCharacterMovement::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UShooterCharacterMovement* MutableThis = const_cast<UShooterCharacterMovement*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Shooter(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+
+void UShooterCharacterMovement::ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode)
+{
+	++NumCorrections;
+	INC_DWORD_STAT(STAT_MovementCorrectionsThisFrame);
+
+	Super::ClientAdjustPosition_Implementation(TimeStamp, NewLoc, NewVel, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode);
+}
+
+
+void UShooterCharacterMovement::OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity)
+{
+	Super::OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
+
+	//Simulated proxies get these replicated instead
+	if (CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)
+	{
+		if (AShooterProjectCharacter* Character = Cast<AShooterProjectCharacter>(CharacterOwner))
+		{
+			Character->CurrentState = GetStance();
+			Character->bIsSprinting = IsSprinting();
+		}
+	}
+}
+
+
+static FAutoConsoleCommandWithWorldAndArgs MovementCorrectionsCommand(
+	TEXT("character.MovementCorrections"),
+	TEXT("Print how many movement corrections each locally controlled character has had per minute. Pass reset to start counting again, optionally with a packet loss percentage to simulate. Usage: character.MovementCorrections [reset [PktLoss]]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		const bool bReset = Args.Num() > 0 && Args[0] == TEXT("reset");
+
+		if (bReset && Args.Num() > 1)
+		{
+			//Only there in builds with network emulation
+			if (IConsoleVariable* PacketLoss = IConsoleManager::Get().FindConsoleVariable(TEXT("NetEmulation.PktLoss")))
+			{
+				PacketLoss->Set(*Args[1]);
+				UE_LOG(LogTemp, Log, TEXT("character.MovementCorrections: simulating %s%% packet loss"), *Args[1]);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("character.MovementCorrections: network emulation isn't available in this build"));
+			}
+		}
+
+		for (TActorIterator<AShooterProjectCharacter> It(World); It; ++It)
+		{
+			UShooterCharacterMovement* Movement = Cast<UShooterCharacterMovement>(It->GetCharacterMovement());
+
+			if (!Movement || !It->IsLocallyControlled())
+			{
+				continue;
+			}
+
+			if (bReset)
+			{
+				Movement->ResetCorrectionCount();
+				continue;
+			}
+
+			UE_LOG(LogTemp, Log, TEXT("character.MovementCorrections: %s had %d corrections, %.2f per minute"), *It->GetName(), Movement->GetNumCorrections(), Movement->GetCorrectionsPerMinute());
+		}
+	}));
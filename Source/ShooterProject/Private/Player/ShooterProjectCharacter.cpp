@@ -4,21 +4,34 @@
 
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Camera/CameraComponent.h"
+#include "Framework/AssetStreamingSubsystem.h"
+#include "Framework/BatchedTickSubsystem.h"
+#include "Framework/CharacterSignificanceSubsystem.h"
+#include "Framework/DamageQueueSubsystem.h"
+#include "Framework/LagCompensationSubsystem.h"
+#include "Framework/LocomotionSubsystem.h"
+#include "Framework/MeshMergeSubsystem.h"
+#include "Framework/RagdollSubsystem.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
 #include "Components/InteractionComponent.h"
 #include "Components/InventoryComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/GameStateBase.h"
 #include "GameFramework/PlayerState.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Items/EquippableItem.h"
+#include "Items/GearAppearanceCache.h"
 #include "Items/GearItem.h"
+#include "Items/WeaponClass.h"
 #include "Kismet/GameplayStatics.h"
 #include "Materials/MaterialInstance.h"
 #include "Net/UnrealNetwork.h"
 #include "Net/RepLayout.h"
 #include "Particles/Collision/ParticleModuleCollisionGPU.h"
+#include "Player/BoneHitZoneCache.h"
+#include "Player/ShooterCharacterMovement.h"
 #include "Player/ShooterProjectPlayerController.h"
 #include "ShooterProject/ShooterProject.h"
 #include "World/Pickup.h"
@@ -28,8 +41,14 @@
 //////////////////////////////////////////////////////////////////////////
 // AShooterProjectCharacter
 
-AShooterProjectCharacter::AShooterProjectCharacter()
+AShooterProjectCharacter::AShooterProjectCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UShooterCharacterMovement>(ACharacter::CharacterMovementComponentName))
 {
+	ShooterMovement = CastChecked<UShooterCharacterMovement>(GetCharacterMovement());
+
+	//Interaction checks are run by the batched tick subsystem, blueprints that use Event Tick turn this back on
+	PrimaryActorTick.bCanEverTick = false;
+
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
 
@@ -44,11 +63,34 @@ AShooterProjectCharacter::AShooterProjectCharacter()
 	// set the character speed
 	Runningspeed = 450.f;
 	Sprintingspeed = 600.f;
+	ShooterMovement->MaxWalkSpeed = Runningspeed;
+	ShooterMovement->MaxWalkSpeedSprint = Sprintingspeed;
 
 	//Sets Interaction Distance and Frequency
 	InteractionCheckFrequency = 0.f;
 	InteractionCheckDistance = 1000.f;
 
+	MeleeAttackRadius = 15.f;
+
+	MergedMeshComponent = nullptr;
+	MergedMeshHash = 0;
+	bMergedMeshReady = false;
+	bUsingMergedMesh = false;
+
+	DefaultAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPose;
+	bRecordingHitboxes = false;
+	Significance = ECharacterSignificance::Critical;
+	bSignificanceApplied = false;
+
+	//Bone names from the default skeleton
+	HitZoneBones.Add("head", EEquippableSlot::EIS_Head);
+	HitZoneBones.Add("spine_01", EEquippableSlot::EIS_Chest);
+	HitZoneBones.Add("pelvis", EEquippableSlot::EIS_Legs);
+	HitZoneBones.Add("hand_l", EEquippableSlot::EIS_Hands);
+	HitZoneBones.Add("hand_r", EEquippableSlot::EIS_Hands);
+	HitZoneBones.Add("foot_l", EEquippableSlot::EIS_Feet);
+	HitZoneBones.Add("foot_r", EEquippableSlot::EIS_Feet);
+
 	// Rotate with Camera
 	bUseControllerRotationPitch = false;
 	bUseControllerRotationYaw = true;
@@ -85,26 +127,41 @@ AShooterProjectCharacter::AShooterProjectCharacter()
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
 	//Modular Character
-	HelmetMesh = PlayerMeshes.Add(EEquippableSlot::EIS_Helmet, CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("HelmetMesh")));
-	ChestMesh = PlayerMeshes.Add(EEquippableSlot::EIS_Chest, CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("ChestMesh")));
-	LegsMesh = PlayerMeshes.Add(EEquippableSlot::EIS_Legs, CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("LegsMesh")));
-	FeetMesh = PlayerMeshes.Add(EEquippableSlot::EIS_Feet, CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("FeetMesh")));
-	VestMesh = PlayerMeshes.Add(EEquippableSlot::EIS_Vest, CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("VestMesh")));
-	HandsMesh = PlayerMeshes.Add(EEquippableSlot::EIS_Hands, CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("HandsMesh")));
-	BackpackMesh = PlayerMeshes.Add(EEquippableSlot::EIS_Backpack, CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("BackpackMesh")));
+	HelmetMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("HelmetMesh"));
+	SlotMeshes.Set(EEquippableSlot::EIS_Helmet, HelmetMesh);
+	ChestMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("ChestMesh"));
+	SlotMeshes.Set(EEquippableSlot::EIS_Chest, ChestMesh);
+	LegsMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("LegsMesh"));
+	SlotMeshes.Set(EEquippableSlot::EIS_Legs, LegsMesh);
+	FeetMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("FeetMesh"));
+	SlotMeshes.Set(EEquippableSlot::EIS_Feet, FeetMesh);
+	VestMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("VestMesh"));
+	SlotMeshes.Set(EEquippableSlot::EIS_Vest, VestMesh);
+	HandsMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("HandsMesh"));
+	SlotMeshes.Set(EEquippableSlot::EIS_Hands, HandsMesh);
+	BackpackMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("BackpackMesh"));
+	SlotMeshes.Set(EEquippableSlot::EIS_Backpack, BackpackMesh);
 
 	//Tell all the body meshes to use the head mesh for animation
-	for (auto& PlayerMesh : PlayerMeshes)
+	SlotMeshes.ForEach([this](const EEquippableSlot Slot, USkeletalMeshComponent* MeshComponent)
 	{
-		USkeletalMeshComponent* MeshComponent = PlayerMesh.Value;
 		MeshComponent->SetupAttachment(GetMesh());
 		MeshComponent->SetMasterPoseComponent(GetMesh());
-	}
+	});
+
+	SlotMeshes.Set(EEquippableSlot::EIS_Head, GetMesh());
 
-	PlayerMeshes.Add(EEquippableSlot::EIS_Head, GetMesh());
+	//Blueprints look the body meshes up in a map
+	SlotMeshes.ForEach([this](const EEquippableSlot Slot, USkeletalMeshComponent* MeshComponent)
+	{
+		PlayerMeshes.Add(Slot, MeshComponent);
+	});
 
 	GetMesh()->SetOwnerNoSee(true);
 
+	//The significance subsystem decides how much update rate optimizations can skip
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 
@@ -205,7 +262,7 @@ void AShooterProjectCharacter::LootItem(UItem* ItemToGive)
 			{
 				if (AShooterProjectPlayerController* PC = Cast<AShooterProjectPlayerController>(GetController()))
 				{
-					PC->ShowNotification(AddResult.ErrorText);
+					PC->ClientShowItemAddError(AddResult.Error, AddResult.ItemClass);
 				}
 			}
 		}
@@ -227,11 +284,34 @@ bool AShooterProjectCharacter::ServerLootItem_Validate(UItem* ItemToLoot)
 	return true;
 }
 
+void AShooterProjectCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	//Cache the naked meshes so if a player unequips an item we can set the mesh back to the standard. This happens before
+	//gear can be equipped or replicated to us, so gear taken off before BeginPlay still has a naked appearance to go back to.
+	SlotMeshes.ForEach([this](const EEquippableSlot Slot, USkeletalMeshComponent* MeshComponent)
+	{
+		const USkeletalMeshComponent* MeshArchetype = CastChecked<USkeletalMeshComponent>(MeshComponent->GetArchetype());
+		NakedAppearances.Set(Slot, FGearAppearanceCache::Get().FindOrAdd(Slot, MeshArchetype->SkeletalMesh, nullptr));
+
+		if (!SlotAppearances.Contains(Slot))
+		{
+			SlotAppearances.Set(Slot, NakedAppearances[Slot]);
+		}
+	});
+}
+
+
 // Called when the game starts or when spawned
 void AShooterProjectCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
+	//Blueprints may have changed our speeds after the constructor handed them to our movement component
+	ShooterMovement->MaxWalkSpeed = Runningspeed;
+	ShooterMovement->MaxWalkSpeedSprint = Sprintingspeed;
+
 	//Bind interact to BeginLooting-function that sets Player Inventory as the LootSource.
 	LootPlayerInteraction->OnInteract.AddDynamic(this, &AShooterProjectCharacter::BeginLootingPlayer);
 
@@ -241,18 +321,86 @@ void AShooterProjectCharacter::BeginPlay()
 		LootPlayerInteraction->SetInteractableText(FText::FromString(PS->GetPlayerName()));
 	}
 
-	//When the player spawns in, they have no items equipped, so cache thise items (That way, if a player uneqipps an item we can set the mesh back to the standard
-	for (auto& PlayerMesh : PlayerMeshes)
+	OnEquippedItemsChanged.AddDynamic(this, &AShooterProjectCharacter::OnEquipmentChanged);
+	UpdateDefenceProfile();
+
+	//Look up which body slot each bone belongs to once, so hits only need a table lookup. Characters using the same mesh share the same table.
+	if (HasAuthority())
+	{
+		BoneHitZones = FBoneHitZoneCache::Get().FindOrAdd(GetMesh()->SkeletalMesh, GetClass(), HitZoneBones);
+	}
+
+	RequestMergedMesh();
+
+	//Nothing is ever rendered on a dedicated server, so don't evaluate poses there unless hitboxes need them
+	DefaultAnimTickOption = IsRunningDedicatedServer() ? EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered : GetMesh()->VisibilityBasedAnimTickOption;
+
+	//Record our poses so hits clients send us can be checked against where they saw us
+	if (HasAuthority())
 	{
-		NakedMeshes.Add(PlayerMesh.Key, PlayerMesh.Value->SkeletalMesh);
+		if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
+	}
+
+	UpdateAnimTickOption();
+
+	if (UCharacterSignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<UCharacterSignificanceSubsystem>())
+	{
+		SignificanceSubsystem->RegisterCharacter(this);
+	}
+
+	if (ULocomotionSubsystem* LocomotionSubsystem = GetWorld()->GetSubsystem<ULocomotionSubsystem>())
+	{
+		LocomotionSubsystem->RegisterCharacter(this);
+	}
+
+	if (UBatchedTickSubsystem* BatchedTick = GetWorld()->GetSubsystem<UBatchedTickSubsystem>())
+	{
+		BatchedTick->AddCharacter(this);
 	}
 }
 
 
-void AShooterProjectCharacter::Tick(float DeltaTime)
+void AShooterProjectCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
 
+	if (UMeshMergeSubsystem* MeshMerge = GetWorld()->GetSubsystem<UMeshMergeSubsystem>())
+	{
+		MeshMerge->UnregisterCharacter(this);
+	}
+
+	if (URagdollSubsystem* RagdollSubsystem = GetWorld()->GetSubsystem<URagdollSubsystem>())
+	{
+		RagdollSubsystem->RemoveRagdoll(this);
+	}
+
+	if (UCharacterSignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<UCharacterSignificanceSubsystem>())
+	{
+		SignificanceSubsystem->UnregisterCharacter(this);
+	}
+
+	if (ULocomotionSubsystem* LocomotionSubsystem = GetWorld()->GetSubsystem<ULocomotionSubsystem>())
+	{
+		LocomotionSubsystem->UnregisterCharacter(this);
+	}
+
+	if (UBatchedTickSubsystem* BatchedTick = GetWorld()->GetSubsystem<UBatchedTickSubsystem>())
+	{
+		BatchedTick->RemoveCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void AShooterProjectCharacter::TickInteraction(float DeltaTime)
+{
 	const bool bIsInteractingOnServer = (HasAuthority() && IsInteracting());
 
 	if ((!HasAuthority() || bIsInteractingOnServer) && GetWorld()->TimeSince(InteractionData.LastInteractionCheckTime) > InteractionCheckFrequency)
@@ -266,7 +414,13 @@ void AShooterProjectCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProper
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
 	DOREPLIFETIME(AShooterProjectCharacter, LootSource);
+	DOREPLIFETIME(AShooterProjectCharacter, CurrentWeapon);
 	DOREPLIFETIME(AShooterProjectCharacter, Health);
+	DOREPLIFETIME(AShooterProjectCharacter, EquippedItems);
+
+	//Our own client and the server get these from the movement component
+	DOREPLIFETIME_CONDITION(AShooterProjectCharacter, CurrentState, COND_SimulatedOnly);
+	DOREPLIFETIME_CONDITION(AShooterProjectCharacter, bIsSprinting, COND_SimulatedOnly);
 	//DOREPLIFETIME_CONDITION(AShooterProjectCharacter, Health, COND_OwnerOnly);
 }
 
@@ -285,23 +439,139 @@ float AShooterProjectCharacter::TakeDamage(float DamageAmount, FDamageEvent cons
 {
 	Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
 
-	const float DamageDealt = ModifyHealth(-DamageAmount);
+	//Damage is applied at the end of the frame along with everything else that hit us this frame
+	if (UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>())
+	{
+		DamageQueue->QueueDamage(this, DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+
+		//Nothing has been dealt yet, armor and health are only applied when the queue runs
+		return 0.f;
+	}
+
+	const FName HitBone = DamageEvent.IsOfType(FPointDamageEvent::ClassID) ? static_cast<const FPointDamageEvent&>(DamageEvent).HitInfo.BoneName : NAME_None;
+	const float DamageDealt = DamageAmount * GetDamageTakenMultiplier(HitBone);
+	ApplyQueuedDamage(DamageDealt, DamageEvent, EventInstigator, DamageCauser);
+
+	return DamageDealt;
+}
 
-	GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Red, "TakeDamage function");
 
-	if (Health <= 0.f)
+float AShooterProjectCharacter::GetDamageTakenMultiplier(const FName HitBone /*= NAME_None*/) const
+{
+	if (!HitBone.IsNone() && BoneHitZones.IsValid())
 	{
-		if (AShooterProjectCharacter* KillerCharacter = Cast<AShooterProjectCharacter>(DamageCauser->GetOwner()))
+		if (const EEquippableSlot* Zone = BoneHitZones->Find(HitBone))
 		{
-			KilledByPlayer(DamageEvent, KillerCharacter, DamageCauser);
+			return DefenceProfile.ZoneDamageTaken[(uint8)*Zone];
 		}
-		else
+	}
+
+	return DefenceProfile.OverallDamageTaken;
+}
+
+
+void AShooterProjectCharacter::OnEquipmentChanged(const EEquippableSlot Slot, const UEquippableItem* Item)
+{
+	UpdateDefenceProfile();
+
+	//The hotbar shows what we have equipped, so stream its thumbnail in and refresh the slot once it has
+	UEquippableItem* EquippedItem = EquippedItems.Items[Slot];
+
+	if (EquippedItem && !EquippedItem->Thumbnail && IsLocallyControlled())
+	{
+		EquippedItem->RequestThumbnail(EAssetStreamPriority::VisibleUI, FSimpleDelegate::CreateUObject(this, &AShooterProjectCharacter::RefreshEquippedSlot, Slot));
+	}
+}
+
+
+void AShooterProjectCharacter::RefreshEquippedSlot(const EEquippableSlot Slot)
+{
+	OnEquippedItemsChanged.Broadcast(Slot, EquippedItems.Items[Slot]);
+}
+
+
+//However much gear we wear, some damage always gets through
+static const float MinDamageTaken = 0.1f;
+
+void AShooterProjectCharacter::UpdateDefenceProfile()
+{
+	float ZoneDamageTaken[(uint8)EEquippableSlot::EIS_MAX];
+	float OverallDamageTaken = 1.f;
+
+	for (float& DamageTaken : ZoneDamageTaken)
+	{
+		DamageTaken = 1.f;
+	}
+
+	EquippedItems.Items.ForEach([&ZoneDamageTaken, &OverallDamageTaken](const EEquippableSlot Slot, const UEquippableItem* EquippedItem)
+	{
+		if (const UGearItem* Gear = Cast<UGearItem>(EquippedItem))
 		{
-			Suicide(DamageEvent, DamageCauser);
-		}			
+			//Gear protects the part of the body it is worn over
+			EEquippableSlot Zone = Gear->Slot;
+
+			switch (Gear->Slot)
+			{
+			case EEquippableSlot::EIS_Helmet:
+				Zone = EEquippableSlot::EIS_Head;
+				break;
+			case EEquippableSlot::EIS_Vest:
+			case EEquippableSlot::EIS_Backpack:
+				Zone = EEquippableSlot::EIS_Chest;
+				break;
+			default:
+				break;
+			}
+
+			//Each piece stops its share of whatever got through the others, so stacking gear never adds up to immunity
+			const float PieceDamageTaken = 1.f - FMath::Clamp(Gear->DamageDefenceMultiplier, 0.f, 1.f);
+
+			ZoneDamageTaken[(uint8)Zone] *= PieceDamageTaken;
+			OverallDamageTaken *= PieceDamageTaken;
+		}
+	});
+
+	for (int32 i = 0; i < (uint8)EEquippableSlot::EIS_MAX; ++i)
+	{
+		DefenceProfile.ZoneDamageTaken[i] = FMath::Max(ZoneDamageTaken[i], MinDamageTaken);
 	}
 
-	return DamageDealt;
+	DefenceProfile.OverallDamageTaken = FMath::Max(OverallDamageTaken, MinDamageTaken);
+}
+
+
+bool AShooterProjectCharacter::ApplyQueuedDamage(const float Damage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	if (!HasAuthority() || !IsAlive())
+	{
+		return false;
+	}
+
+	ModifyHealth(-Damage);
+
+	if (Health > 0.f)
+	{
+		return false;
+	}
+
+	//Credit the player that hit us, whether it was with a weapon they own or with their fists
+	AShooterProjectCharacter* KillerCharacter = EventInstigator ? Cast<AShooterProjectCharacter>(EventInstigator->GetPawn()) : nullptr;
+
+	if (!KillerCharacter && DamageCauser)
+	{
+		KillerCharacter = Cast<AShooterProjectCharacter>(DamageCauser->GetOwner());
+	}
+
+	if (KillerCharacter && KillerCharacter != this)
+	{
+		KilledByPlayer(DamageEvent, KillerCharacter, DamageCauser);
+	}
+	else
+	{
+		Suicide(DamageEvent, DamageCauser);
+	}
+
+	return true;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -313,6 +583,7 @@ void AShooterProjectCharacter::SetupPlayerInputComponent(class UInputComponent*
 	check(PlayerInputComponent);
 	PlayerInputComponent->BindAction("Fire", IE_Pressed, this, &AShooterProjectCharacter::StartFire);
 	PlayerInputComponent->BindAction("Fire", IE_Released, this, &AShooterProjectCharacter::StopFire);
+	PlayerInputComponent->BindAction("Reload", IE_Pressed, this, &AShooterProjectCharacter::StartReload);
 	
 	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ACharacter::Jump);
 	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
@@ -326,6 +597,9 @@ void AShooterProjectCharacter::SetupPlayerInputComponent(class UInputComponent*
 	PlayerInputComponent->BindAction("Prone", IE_Pressed, this, &AShooterProjectCharacter::StartProning);
 	PlayerInputComponent->BindAction("Prone", IE_Released, this, &AShooterProjectCharacter::StopProning);
 
+	PlayerInputComponent->BindAction("Sprint", IE_Pressed, this, &AShooterProjectCharacter::StartSprinting);
+	PlayerInputComponent->BindAction("Sprint", IE_Released, this, &AShooterProjectCharacter::StopSprinting);
+
 	PlayerInputComponent->BindAction("NextStance", IE_Pressed, this, &AShooterProjectCharacter::NextPawnState);
 	PlayerInputComponent->BindAction("PrevStance", IE_Pressed, this, &AShooterProjectCharacter::PrevPawnState);
 
@@ -600,7 +874,7 @@ void AShooterProjectCharacter::DropItem(class UItem* Item, const int32 Quantity)
 			ensure(PickupClass);
 
 			APickup* Pickup = GetWorld()->SpawnActor<APickup>(PickupClass, SpawnTransform, SpawnParams);
-			Pickup->InitializePickup(Item->GetClass(), DroppedQuantity);
+			Pickup->InitializePickup(Item->GetClass(), DroppedQuantity, true);
 		}
 	}
 }
@@ -620,7 +894,7 @@ bool AShooterProjectCharacter::ServerDropItem_Validate(class UItem* Item, const
 
 bool AShooterProjectCharacter::EquipItem(class UEquippableItem* Item)
 {
-	EquippedItems.Add(Item->Slot, Item);
+	EquippedItems.Items.Set(Item->Slot, Item);
 	OnEquippedItemsChanged.Broadcast(Item->Slot, Item);
 	return true;
 }
@@ -630,63 +904,208 @@ bool AShooterProjectCharacter::UnequipItem(class UEquippableItem* Item)
 {
 	if (Item)
 	{
-		if (EquippedItems.Contains(Item->Slot))
+		if (Item == EquippedItems.Items[Item->Slot])
 		{
-			if (Item == *EquippedItems.Find(Item->Slot))
-			{
-				EquippedItems.Remove(Item->Slot);
-				OnEquippedItemsChanged.Broadcast(Item->Slot, nullptr);
-				return true;
-			}
+			EquippedItems.Items.Remove(Item->Slot);
+			OnEquippedItemsChanged.Broadcast(Item->Slot, nullptr);
+			return true;
 		}
 	}
 	return false;
 }
 
 
+void AShooterProjectCharacter::OnRep_EquippedItems(const FEquippedItemSlots& PreviousEquippedItems)
+{
+	//Only look at slots that had or have an item
+	for (uint32 Mask = PreviousEquippedItems.Items.GetOccupiedMask() | EquippedItems.Items.GetOccupiedMask(); Mask; Mask &= Mask - 1)
+	{
+		const EEquippableSlot Slot = (EEquippableSlot)FMath::CountTrailingZeros(Mask);
+
+		UEquippableItem* Item = EquippedItems.Items[Slot];
+		UEquippableItem* PreviousItem = PreviousEquippedItems.Items[Slot];
+
+		if (Item == PreviousItem)
+		{
+			continue;
+		}
+
+		if (UGearItem* Gear = Cast<UGearItem>(Item))
+		{
+			EquipGear(Gear);
+		}
+		else if (Cast<UGearItem>(PreviousItem))
+		{
+			UnequipGear(Slot);
+		}
+
+		OnEquippedItemsChanged.Broadcast(Slot, Item);
+	}
+}
+
+
 void AShooterProjectCharacter::EquipGear(class UGearItem* Gear)
 {
-	if (USkeletalMeshComponent* GearMesh = *PlayerMeshes.Find(Gear->Slot))
+	if (const FGearAppearance* Appearance = Gear->GetAppearance())
+	{
+		SetSlotAppearance(Gear->Slot, Appearance);
+	}
+	else if (UAssetStreamingSubsystem* Streaming = GetWorld()->GetSubsystem<UAssetStreamingSubsystem>())
+	{
+		Streaming->RequestAsset(Gear->Mesh.ToSoftObjectPath(), EAssetStreamPriority::Equipped, FSimpleDelegate::CreateUObject(this, &AShooterProjectCharacter::OnGearMeshLoaded, TWeakObjectPtr<UGearItem>(Gear)));
+	}
+}
+
+
+void AShooterProjectCharacter::OnGearMeshLoaded(TWeakObjectPtr<UGearItem> Gear)
+{
+	//It may have been taken off while it was loading
+	if (Gear.IsValid() && GetEquippedItem(Gear->Slot) == Gear.Get())
 	{
-		GearMesh->SetSkeletalMesh(Gear->Mesh);
-		GearMesh->SetMaterial(GearMesh->GetMaterials().Num() - 1, Gear->MaterialInstance);
+		SetSlotAppearance(Gear->Slot, Gear->GetAppearance());
 	}
 }
 
 
 void AShooterProjectCharacter::UnequipGear(const EEquippableSlot Slot)
 {
-	if (USkeletalMeshComponent* EquippableMesh = *PlayerMeshes.Find(Slot))
+	//For some gear like backpacks, there is no naked mesh, so the naked appearance has no mesh
+	SetSlotAppearance(Slot, NakedAppearances[Slot]);
+}
+
+
+void AShooterProjectCharacter::SetSlotAppearance(const EEquippableSlot Slot, const FGearAppearance* Appearance)
+{
+	USkeletalMeshComponent* MeshComponent = SlotMeshes[Slot];
+
+	if (!MeshComponent || !Appearance || SlotAppearances[Slot] == Appearance)
 	{
-		if (USkeletalMesh* BodyMesh = *NakedMeshes.Find(Slot))
-		{
-			EquippableMesh->SetSkeletalMesh(BodyMesh);
+		return;
+	}
 
-			//Put the materials back on the body mesh (Since gear may have applied a different material
-			for (int32 i = 0; i < BodyMesh->Materials.Num(); ++i)
-			{
-				if (BodyMesh->Materials.IsValidIndex(i))
-				{
-					EquippableMesh->SetMaterial(i, BodyMesh->Materials[i].MaterialInterface);
-				}
-			}
-		}
-		else
+	SlotAppearances.Set(Slot, Appearance);
+
+	//The appearance already has every material set up, so we don't need to set them one by one
+	MeshComponent->SetSkeletalMesh(Appearance->Mesh.Get());
+	MeshComponent->OverrideMaterials.Reset(Appearance->OverrideMaterials.Num());
+
+	for (const TWeakObjectPtr<UMaterialInterface>& Material : Appearance->OverrideMaterials)
+	{
+		MeshComponent->OverrideMaterials.Add(Material.Get());
+	}
+
+	MeshComponent->MarkRenderStateDirty();
+
+	RequestMergedMesh();
+}
+
+
+void AShooterProjectCharacter::RequestMergedMesh()
+{
+	//We never see our own body from far away
+	if (IsLocallyControlled())
+	{
+		return;
+	}
+
+	UMeshMergeSubsystem* MeshMerge = GetWorld()->GetSubsystem<UMeshMergeSubsystem>();
+
+	if (!MeshMerge || !MeshMerge->IsMergingEnabled())
+	{
+		return;
+	}
+
+	//Our merged mesh shows our old gear now, so show the separate meshes until the new one is ready
+	SetUseMergedMesh(false);
+	bMergedMeshReady = false;
+
+	TArray<USkeletalMeshComponent*> Parts;
+	Parts.Add(GetMesh());
+
+	SlotMeshes.ForEach([this, &Parts](const EEquippableSlot Slot, USkeletalMeshComponent* MeshComponent)
+	{
+		if (MeshComponent != GetMesh())
 		{
-			//For some gear like backpacks, there is no naked mesh
-			EquippableMesh->SetSkeletalMesh(nullptr);
+			Parts.Add(MeshComponent);
 		}
+	});
+
+	if (USkeletalMesh* MergedMesh = MeshMerge->RequestMergedMesh(this, Parts, MergedMeshHash))
+	{
+		SetMergedMesh(MergedMesh, MergedMeshHash);
 	}
 }
 
 
-class USkeletalMeshComponent* AShooterProjectCharacter::GetSlotSkeletalMeshComponent(const EEquippableSlot Slot)
+void AShooterProjectCharacter::SetMergedMesh(USkeletalMesh* MergedMesh, const uint32 Hash)
 {
-	if (PlayerMeshes.Contains(Slot))
+	if (!MergedMesh || Hash != MergedMeshHash)
 	{
-		return *PlayerMeshes.Find(Slot);
+		return;
 	}
-	return nullptr;
+
+	if (!MergedMeshComponent)
+	{
+		MergedMeshComponent = NewObject<USkeletalMeshComponent>(this, TEXT("MergedMesh"));
+		MergedMeshComponent->SetupAttachment(GetMesh());
+		MergedMeshComponent->SetMasterPoseComponent(GetMesh());
+		MergedMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		MergedMeshComponent->SetVisibility(false);
+		MergedMeshComponent->RegisterComponent();
+	}
+
+	MergedMeshComponent->SetSkeletalMesh(MergedMesh);
+	bMergedMeshReady = true;
+}
+
+
+void AShooterProjectCharacter::SetUseMergedMesh(bool bUseMergedMesh)
+{
+	bUseMergedMesh = bUseMergedMesh && bMergedMeshReady;
+
+	if (bUseMergedMesh == bUsingMergedMesh)
+	{
+		return;
+	}
+
+	bUsingMergedMesh = bUseMergedMesh;
+	UpdateAnimTickOption();
+
+	SlotMeshes.ForEach([bUseMergedMesh](const EEquippableSlot Slot, USkeletalMeshComponent* MeshComponent)
+	{
+		MeshComponent->SetVisibility(!bUseMergedMesh);
+	});
+
+	MergedMeshComponent->SetVisibility(bUseMergedMesh);
+}
+
+
+class USkeletalMeshComponent* AShooterProjectCharacter::GetSlotSkeletalMeshComponent(const EEquippableSlot Slot)
+{
+	return SlotMeshes[Slot];
+}
+
+
+TMap<EEquippableSlot, UEquippableItem*> AShooterProjectCharacter::GetEquippedItems() const
+{
+	TMap<EEquippableSlot, UEquippableItem*> Items;
+
+	EquippedItems.Items.ForEach([&Items](const EEquippableSlot Slot, UEquippableItem* Item)
+	{
+		Items.Add(Slot, Item);
+	});
+
+	return Items;
+}
+
+
+void AShooterProjectCharacter::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	AShooterProjectCharacter* This = CastChecked<AShooterProjectCharacter>(InThis);
+
+	This->SlotMeshes.AddReferencedObjects(Collector, This);
+
+	Super::AddReferencedObjects(InThis, Collector);
 }
 
 
@@ -704,29 +1123,52 @@ void AShooterProjectCharacter::PrevInventoryItem()
 }
 
 
+//The stance handlers only say what we want, our movement component gets us there and sets CurrentState once we are
 void AShooterProjectCharacter::StartCrouching()
 {
-	CurrentState = EPawnStates::CROUCH;
-	Crouch();
+	ShooterMovement->SetWantedStance(EPawnStates::CROUCH);
 }
 
 
 void AShooterProjectCharacter::StopCrouching()
 {
-	CurrentState = EPawnStates::STAND;
-	UnCrouch();
+	if (ShooterMovement->GetWantedStance() == EPawnStates::CROUCH)
+	{
+		ShooterMovement->SetWantedStance(EPawnStates::STAND);
+	}
 }
 
 
 void AShooterProjectCharacter::StartProning()
 {
-	CurrentState = EPawnStates::PRONE;
+	ShooterMovement->SetWantedStance(EPawnStates::PRONE);
 }
 
 
 void AShooterProjectCharacter::StopProning()
 {
-	CurrentState = EPawnStates::STAND;
+	if (ShooterMovement->GetWantedStance() == EPawnStates::PRONE)
+	{
+		ShooterMovement->SetWantedStance(EPawnStates::STAND);
+	}
+}
+
+
+void AShooterProjectCharacter::StartSprinting()
+{
+	ShooterMovement->SetWantsToSprint(true);
+}
+
+
+void AShooterProjectCharacter::StopSprinting()
+{
+	ShooterMovement->SetWantsToSprint(false);
+}
+
+
+void AShooterProjectCharacter::OnRep_CurrentState()
+{
+	ShooterMovement->SetSimulatedStance(CurrentState);
 }
 
 float AShooterProjectCharacter::ModifyHealth(const float Delta)
@@ -743,14 +1185,55 @@ void AShooterProjectCharacter::OnRep_Health(float OldHealth)
 	OnHealthModified(Health - OldHealth);
 }
 
+void AShooterProjectCharacter::EquipWeapon(AWeaponClass* Weapon)
+{
+	if (HasAuthority() && Weapon != CurrentWeapon)
+	{
+		AWeaponClass* PreviousWeapon = CurrentWeapon;
+		CurrentWeapon = Weapon;
+		OnRep_CurrentWeapon(PreviousWeapon);
+	}
+}
+
+void AShooterProjectCharacter::OnRep_CurrentWeapon(AWeaponClass* PreviousWeapon)
+{
+	if (PreviousWeapon)
+	{
+		PreviousWeapon->OnUnequip();
+	}
+
+	if (CurrentWeapon)
+	{
+		CurrentWeapon->OnEquip(this);
+	}
+}
+
 void AShooterProjectCharacter::StartFire()
 {
-	BeginMeleeAttack();
+	if (CurrentWeapon)
+	{
+		CurrentWeapon->StartFire();
+	}
+	else
+	{
+		BeginMeleeAttack();
+	}
 }
 
 void AShooterProjectCharacter::StopFire()
 {
-	
+	if (CurrentWeapon)
+	{
+		CurrentWeapon->StopFire();
+	}
+}
+
+void AShooterProjectCharacter::StartReload()
+{
+	if (CurrentWeapon)
+	{
+		CurrentWeapon->StartReload();
+	}
 }
 
 void AShooterProjectCharacter::BeginMeleeAttack()
@@ -758,7 +1241,7 @@ void AShooterProjectCharacter::BeginMeleeAttack()
 	if (GetWorld()->TimeSince(LastMeleeAttackTime) > MeleeAttackMontage->GetPlayLength())
 	{
 		FHitResult Hit;
-		FCollisionShape Shape = FCollisionShape::MakeSphere(15.f);
+		FCollisionShape Shape = FCollisionShape::MakeSphere(MeleeAttackRadius);
 
 		FVector StartTrace = FollowCamera->GetComponentLocation();
 		FVector EndTrace = (FollowCamera->GetComponentRotation().Vector() * MeleeAttackDistance) + StartTrace;
@@ -778,15 +1261,17 @@ void AShooterProjectCharacter::BeginMeleeAttack()
 			}
 		}
 
-		ServerProcessMeleeHit(Hit);
+		//Tell the server when we swept in its time, so it can check the hit against where we saw the other player
+		const AGameStateBase* GameState = GetWorld()->GetGameState();
+		ServerProcessMeleeHit(Hit, GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds());
 
 		LastMeleeAttackTime = GetWorld()->GetTimeSeconds();
 	}
 }
 
-void AShooterProjectCharacter::ServerProcessMeleeHit_Implementation(const FHitResult& MeleeHit)
+void AShooterProjectCharacter::ServerProcessMeleeHit_Implementation(const FHitResult& MeleeHit, const float ClientTimestamp)
 {
-	if (GetWorld()->TimeSince(LastMeleeAttackTime) > MeleeAttackMontage->GetPlayLength() && (GetActorLocation() - MeleeHit.ImpactPoint).Size() <= MeleeAttackDistance)
+	if (GetWorld()->TimeSince(LastMeleeAttackTime) > MeleeAttackMontage->GetPlayLength() && IsValidMeleeHit(MeleeHit, ClientTimestamp))
 	{
 		MulticastPlayMeleeFX();
 
@@ -795,6 +1280,30 @@ void AShooterProjectCharacter::ServerProcessMeleeHit_Implementation(const FHitRe
 	LastMeleeAttackTime = GetWorld()->GetTimeSeconds();
 }
 
+bool AShooterProjectCharacter::IsValidMeleeHit(const FHitResult& MeleeHit, const float ClientTimestamp) const
+{
+	//The sweep has to start around our head and can't be longer than our reach
+	const float MaxStartDistance = GetCapsuleComponent()->GetScaledCapsuleHalfHeight() + MeleeAttackDistance;
+
+	if (FVector::DistSquared(MeleeHit.TraceStart, GetActorLocation()) > FMath::Square(MaxStartDistance)
+		|| FVector::DistSquared(MeleeHit.TraceStart, MeleeHit.TraceEnd) > FMath::Square(MeleeAttackDistance + KINDA_SMALL_NUMBER)
+		|| FVector::DistSquared(MeleeHit.TraceStart, MeleeHit.ImpactPoint) > FMath::Square(MeleeAttackDistance + MeleeAttackRadius))
+	{
+		return false;
+	}
+
+	//Players move while the hit is on its way to us, so check it against where the client saw them instead of where they are now
+	if (const AShooterProjectCharacter* HitPlayer = Cast<AShooterProjectCharacter>(MeleeHit.GetActor()))
+	{
+		if (const ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+		{
+			return LagCompensation->ValidateSweep(HitPlayer, MeleeHit.TraceStart, MeleeHit.TraceEnd, MeleeAttackRadius, ClientTimestamp, MeleeHit.BoneName);
+		}
+	}
+
+	return true;
+}
+
 void AShooterProjectCharacter::MulticastPlayMeleeFX_Implementation()
 {
 	if (!IsLocallyControlled())
@@ -821,8 +1330,6 @@ void AShooterProjectCharacter::OnRep_Killer()
 	//Remove player from World after 20 seconds
 	SetLifeSpan(20.f);
 
-	GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-	GetMesh()->SetSimulatePhysics(true);
 	GetMesh()->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	GetCapsuleComponent()->SetCollisionResponseToAllChannels(ECR_Ignore);
@@ -830,19 +1337,43 @@ void AShooterProjectCharacter::OnRep_Killer()
 
 	TurnOff();
 
+	//Dead bodies only need to be lootable, which doesn't need anything to tick
+	SetActorTickEnabled(false);
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+
+	if (UBatchedTickSubsystem* BatchedTick = GetWorld()->GetSubsystem<UBatchedTickSubsystem>())
+	{
+		BatchedTick->RemoveCharacter(this);
+	}
+
+	//Only so many ragdolls get to simulate at once
+	if (URagdollSubsystem* RagdollSubsystem = GetWorld()->GetSubsystem<URagdollSubsystem>())
+	{
+		RagdollSubsystem->AddRagdoll(this);
+	}
+	else
+	{
+		StartRagdoll();
+	}
+
 	//Activates Looting after player is dead
 	LootPlayerInteraction->Activate();
 
-	//Unequip all equipped items so they can be looted
 	if (HasAuthority())
 	{
-		TArray<UEquippableItem*> Equippables;
-		EquippedItems.GenerateValueArray(Equippables);
+		//Dead players can't be hit anymore, so stop recording them
+		if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+		{
+			LagCompensation->UnregisterCharacter(this);
+		}
 
-		for (auto& EquippedItem : Equippables)
+		//Unequip all equipped items so they can be looted. Unequipping empties the slots, so go through a copy.
+		const TEquippableSlotArray<UEquippableItem*> Equippables = EquippedItems.Items;
+
+		Equippables.ForEach([](const EEquippableSlot Slot, UEquippableItem* EquippedItem)
 		{
 			EquippedItem->SetEquipped(false);
-		}
+		});
 	}
 	//Show Deathscreen
 	if (IsLocallyControlled())
@@ -855,16 +1386,81 @@ void AShooterProjectCharacter::OnRep_Killer()
 }
 
 
+void AShooterProjectCharacter::UpdateAnimTickOption()
+{
+	GetMesh()->VisibilityBasedAnimTickOption = bRecordingHitboxes || bUsingMergedMesh ? EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones : DefaultAnimTickOption;
+}
+
+
+void AShooterProjectCharacter::SetRecordingHitboxes(const bool bRecord)
+{
+	if (bRecordingHitboxes != bRecord)
+	{
+		bRecordingHitboxes = bRecord;
+		UpdateAnimTickOption();
+	}
+}
+
+
+void AShooterProjectCharacter::SetSignificance(const ECharacterSignificance NewSignificance, const FSignificanceUpdateRate& UpdateRate)
+{
+	//The mesh only gets its update rate parameters once it has ticked, so keep trying until then
+	FAnimUpdateRateParameters* UpdateRateParams = GetMesh()->AnimUpdateRateParams;
+
+	if (!UpdateRateParams || (NewSignificance == Significance && bSignificanceApplied))
+	{
+		return;
+	}
+
+	Significance = NewSignificance;
+	bSignificanceApplied = true;
+
+	//Update rate parameters are shared by all of our meshes, so the gear meshes follow the body mesh's rate
+	UpdateRateParams->BaseVisibleDistanceFactorThesholds = UpdateRate.VisibleScreenSizeThresholds;
+	UpdateRateParams->BaseNonRenderedUpdateRate = UpdateRate.NonRenderedUpdateRate;
+}
+
+
+void AShooterProjectCharacter::StartRagdoll()
+{
+	GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	GetMesh()->SetSimulatePhysics(true);
+}
+
+
+void AShooterProjectCharacter::FreezeRagdoll()
+{
+	//Stop updating the skeleton first, so we keep the pose physics left us in instead of going back to the animation
+	GetMesh()->bNoSkeletonUpdate = true;
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+
+	//Nothing moves the body after this, so none of our meshes need to tick
+	SlotMeshes.ForEach([](const EEquippableSlot Slot, USkeletalMeshComponent* MeshComponent)
+	{
+		MeshComponent->SetComponentTickEnabled(false);
+	});
+
+	if (MergedMeshComponent)
+	{
+		MergedMeshComponent->SetComponentTickEnabled(false);
+	}
+}
+
+
 // Next AnimBP State
 void AShooterProjectCharacter::NextPawnState()
 {
-	if (CurrentState == EPawnStates::STAND)
+	//Step from the stance we asked for, we may not have got into it yet
+	const EPawnStates WantedStance = ShooterMovement->GetWantedStance();
+
+	if (WantedStance == EPawnStates::STAND)
 	{
-		CurrentState = EPawnStates::CROUCH;
+		ShooterMovement->SetWantedStance(EPawnStates::CROUCH);
 	}
-	else if (CurrentState == EPawnStates::CROUCH)
+	else if (WantedStance == EPawnStates::CROUCH)
 	{
-		CurrentState = EPawnStates::PRONE;
+		ShooterMovement->SetWantedStance(EPawnStates::PRONE);
 	}
 }
 
@@ -872,13 +1468,15 @@ void AShooterProjectCharacter::NextPawnState()
 // Prev AnimBP State
 void AShooterProjectCharacter::PrevPawnState()
 {
-	if (CurrentState == EPawnStates::PRONE)
+	const EPawnStates WantedStance = ShooterMovement->GetWantedStance();
+
+	if (WantedStance == EPawnStates::PRONE)
 	{
-		CurrentState = EPawnStates::CROUCH;
+		ShooterMovement->SetWantedStance(EPawnStates::CROUCH);
 	}
-	else if (CurrentState == EPawnStates::CROUCH)
+	else if (WantedStance == EPawnStates::CROUCH)
 	{
-		CurrentState = EPawnStates::STAND;
+		ShooterMovement->SetWantedStance(EPawnStates::STAND);
 	}
 }
 
@@ -2,14 +2,128 @@
 
 
 #include "Player/ShooterProjectPlayerController.h"
+#include "Items/ItemTextCache.h"
+#include "Components/InteractionComponent.h"
+#include "Framework/BatchedTickSubsystem.h"
+#include "Player/ShooterProjectCharacter.h"
+#include "UI/InteractionWidget.h"
+#include "UObject/ConstructorHelpers.h"
 
 
 AShooterProjectPlayerController::AShooterProjectPlayerController()
 {
-
+	//Interactables used to pick this card themselves, so keep it as the default for controllers that don't set one
+	static ConstructorHelpers::FClassFinder<UInteractionWidget> InteractionCardClass(TEXT("/Game/Blueprints/UI/Widget/WBP_InteractionCard"));
+	if (InteractionCardClass.Class != NULL)
+	{
+		InteractionWidgetClass = InteractionCardClass.Class;
+	}
 }
 
 void AShooterProjectPlayerController::ClientShowNotification_Implementation(const FText& Message)
 {
 	ShowNotification(Message);
 }
+
+void AShooterProjectPlayerController::ClientShowItemAddError_Implementation(const EItemAddError Error, TSubclassOf<class UItem> ItemClass)
+{
+	ShowNotification(FItemTextCache::Get().GetAddErrorText(Error, ItemClass));
+}
+
+void AShooterProjectPlayerController::ClientHitMarker_Implementation(APawn* Victim, const uint16 Damage, const bool bKilled)
+{
+	OnHitMarker(Victim, Damage, bKilled);
+}
+
+void AShooterProjectPlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UBatchedTickSubsystem* BatchedTick = GetWorld()->GetSubsystem<UBatchedTickSubsystem>())
+	{
+		BatchedTick->RemoveInteractionWidget(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AShooterProjectPlayerController::ShowInteractionWidget(UInteractionComponent* InteractionComponent)
+{
+	if (!InteractionComponent || !IsLocalController() || !InteractionWidgetClass)
+	{
+		return;
+	}
+
+	if (!InteractionWidget)
+	{
+		InteractionWidget = CreateWidget<UInteractionWidget>(this, InteractionWidgetClass);
+		InteractionWidget->SetAlignmentInViewport(FVector2D(0.5f, 0.5f));
+		InteractionWidget->AddToPlayerScreen();
+	}
+
+	ShownInteraction = InteractionComponent;
+
+	InteractionWidget->UpdateInteractionWidget(InteractionComponent);
+	UpdateInteractionWidgetPosition();
+
+	if (UBatchedTickSubsystem* BatchedTick = GetWorld()->GetSubsystem<UBatchedTickSubsystem>())
+	{
+		BatchedTick->AddInteractionWidget(this);
+	}
+}
+
+void AShooterProjectPlayerController::HideInteractionWidget(UInteractionComponent* InteractionComponent)
+{
+	if (!ShownInteraction || ShownInteraction != InteractionComponent)
+	{
+		return;
+	}
+
+	ShownInteraction = nullptr;
+
+	if (InteractionWidget)
+	{
+		InteractionWidget->SetVisibility(ESlateVisibility::Collapsed);
+	}
+
+	if (UBatchedTickSubsystem* BatchedTick = GetWorld()->GetSubsystem<UBatchedTickSubsystem>())
+	{
+		BatchedTick->RemoveInteractionWidget(this);
+	}
+}
+
+void AShooterProjectPlayerController::RefreshInteractionWidget(UInteractionComponent* InteractionComponent)
+{
+	if (InteractionWidget && ShownInteraction && ShownInteraction == InteractionComponent)
+	{
+		InteractionWidget->UpdateInteractionWidget(InteractionComponent);
+	}
+}
+
+void AShooterProjectPlayerController::UpdateInteractionWidgetPosition()
+{
+	if (!InteractionWidget || !ShownInteraction)
+	{
+		return;
+	}
+
+	//Our pawn can go without ending focus, like when it dies, so make sure it's still looking at what we're showing
+	const AShooterProjectCharacter* Character = Cast<AShooterProjectCharacter>(GetPawn());
+
+	if (!Character || Character->GetInteractable() != ShownInteraction)
+	{
+		HideInteractionWidget(ShownInteraction);
+		return;
+	}
+
+	//Hidden while the interactable is behind the camera, as a screen space widget component would be
+	FVector2D ScreenPosition;
+
+	if (ProjectWorldLocationToScreen(ShownInteraction->GetComponentLocation(), ScreenPosition, true))
+	{
+		InteractionWidget->SetPositionInViewport(ScreenPosition);
+		InteractionWidget->SetVisibility(ESlateVisibility::HitTestInvisible);
+	}
+	else
+	{
+		InteractionWidget->SetVisibility(ESlateVisibility::Collapsed);
+	}
+}
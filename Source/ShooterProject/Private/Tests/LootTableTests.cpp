@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "Engine/DataTable.h"
+#include "World/ItemSpawn.h"
+#include "World/LootTableSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LootTableTests
+{
+	static const int32 NumSamples = 200000;
+
+	//The same seed every run, so a failure can always be reproduced
+	static const int32 TestSeed = 0x1007AB1E;
+
+	static FName GetRowName(const int32 RowIndex)
+	{
+		return FName(*FString::Printf(TEXT("Row%d"), RowIndex));
+	}
+
+	static UDataTable* MakeLootTable(const TArray<float>& Probabilities)
+	{
+		UDataTable* LootTable = NewObject<UDataTable>(GetTransientPackage());
+		LootTable->RowStruct = FLootTableRow::StaticStruct();
+
+		for (int32 i = 0; i < Probabilities.Num(); ++i)
+		{
+			FLootTableRow Row;
+			Row.Probability = Probabilities[i];
+			LootTable->AddRow(GetRowName(i), Row);
+		}
+
+		return LootTable;
+	}
+
+	//Upper tail critical value of the chi-square distribution at p = 0.001, using the Wilson-Hilferty approximation
+	static double GetChiSquareCriticalValue(const int32 DegreesOfFreedom)
+	{
+		const double Z = 3.090;
+		const double K = DegreesOfFreedom;
+		const double Term = 1.0 - 2.0 / (9.0 * K) + Z * FMath::Sqrt(2.0 / (9.0 * K));
+		return K * Term * Term * Term;
+	}
+
+	/** Sample the table and check the counts against the probabilities it was built from with Pearson's chi-square test.
+	Rows with a probability of zero must never come up. */
+	static bool TestDistribution(FAutomationTestBase& Test, const TArray<float>& Probabilities)
+	{
+		const UDataTable* LootTable = MakeLootTable(Probabilities);
+		const FCompiledLootTable CompiledTable(LootTable);
+
+		TMap<const FLootTableRow*, int32> RowIndices;
+		float TotalProbability = 0.f;
+		int32 NumWeightedRows = 0;
+
+		for (int32 i = 0; i < Probabilities.Num(); ++i)
+		{
+			RowIndices.Add(LootTable->FindRow<FLootTableRow>(GetRowName(i), TEXT("")), i);
+
+			if (Probabilities[i] > 0.f)
+			{
+				TotalProbability += Probabilities[i];
+				++NumWeightedRows;
+			}
+		}
+
+		Test.TestEqual(TEXT("Rows with a probability are compiled, the rest are dropped"), CompiledTable.Num(), NumWeightedRows);
+
+		TArray<int32> Counts;
+		Counts.SetNumZeroed(Probabilities.Num());
+
+		FRandomStream RandomStream(TestSeed);
+
+		for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+		{
+			const FLootTableRow* Row = CompiledTable.Sample(RandomStream);
+			const int32* RowIndex = Row ? RowIndices.Find(Row) : nullptr;
+
+			if (!RowIndex)
+			{
+				Test.AddError(TEXT("Sample returned a row that isn't in the table"));
+				return false;
+			}
+
+			++Counts[*RowIndex];
+		}
+
+		double ChiSquare = 0.0;
+
+		for (int32 i = 0; i < Probabilities.Num(); ++i)
+		{
+			if (Probabilities[i] <= 0.f)
+			{
+				Test.TestEqual(FString::Printf(TEXT("Zero probability row %d is never picked"), i), Counts[i], 0);
+				continue;
+			}
+
+			const double Expected = double(NumSamples) * Probabilities[i] / TotalProbability;
+			ChiSquare += FMath::Square(Counts[i] - Expected) / Expected;
+		}
+
+		//One weighted row can only ever be picked, there's nothing for the test to measure
+		if (NumWeightedRows > 1)
+		{
+			const double CriticalValue = GetChiSquareCriticalValue(NumWeightedRows - 1);
+
+			Test.TestTrue(FString::Printf(TEXT("Chi-square %.2f is under the p = 0.001 critical value %.2f for %d rows"), ChiSquare, CriticalValue, NumWeightedRows), ChiSquare < CriticalValue);
+		}
+
+		return true;
+	}
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLootTableDistributionTest, "ShooterProject.Loot.AliasTable.Distribution", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLootTableDistributionTest::RunTest(const FString& Parameters)
+{
+	LootTableTests::TestDistribution(*this, { 1.f, 1.f, 1.f, 1.f });
+	LootTableTests::TestDistribution(*this, { 0.5f, 0.25f, 0.15f, 0.1f });
+	LootTableTests::TestDistribution(*this, { 0.9f, 0.05f, 0.03f, 0.01f, 0.005f, 0.005f });
+	LootTableTests::TestDistribution(*this, { 0.001f, 1.f, 0.2f, 0.7f, 0.02f, 0.35f, 0.6f, 0.08f });
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLootTableZeroWeightTest, "ShooterProject.Loot.AliasTable.ZeroWeightRows", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLootTableZeroWeightTest::RunTest(const FString& Parameters)
+{
+	LootTableTests::TestDistribution(*this, { 0.4f, 0.f, 0.6f, 0.f });
+	LootTableTests::TestDistribution(*this, { 0.f, 0.f, 0.3f, 0.2f, 0.f });
+
+	//Nothing to pick from, so there's no row to give back
+	const FCompiledLootTable AllZeroTable(LootTableTests::MakeLootTable({ 0.f, 0.f }));
+	TestTrue(TEXT("A table of only zero probability rows is empty"), AllZeroTable.IsEmpty());
+	TestNull(TEXT("Sampling an empty table gives no row"), AllZeroTable.Sample(FRandomStream(LootTableTests::TestSeed)));
+
+	const FCompiledLootTable EmptyTable(LootTableTests::MakeLootTable({}));
+	TestNull(TEXT("Sampling a table with no rows gives no row"), EmptyTable.Sample(FRandomStream(LootTableTests::TestSeed)));
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLootTableSingleRowTest, "ShooterProject.Loot.AliasTable.SingleRow", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLootTableSingleRowTest::RunTest(const FString& Parameters)
+{
+	LootTableTests::TestDistribution(*this, { 0.3f });
+	LootTableTests::TestDistribution(*this, { 0.f, 0.3f, 0.f });
+
+	const FCompiledLootTable CompiledTable(LootTableTests::MakeLootTable({ 0.3f }));
+	TestEqual(TEXT("A single row has all of the weight"), CompiledTable.GetRowWeight(0), 1.f);
+
+	//Rolls of exactly 0 and 1 are the edges of the column lookup
+	TestNotNull(TEXT("A roll of 0 picks the row"), CompiledTable.Sample(0.f, 0.f));
+	TestNotNull(TEXT("A roll of 1 picks the row"), CompiledTable.Sample(1.f, 1.f));
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -2,4 +2,86 @@
 
 
 #include "UI/InventoryItemWidget.h"
+#include "UI/ItemTooltip.h"
+#include "Items/Item.h"
+#include "Framework/AssetStreamingSubsystem.h"
 
+void UInventoryItemWidget::NativeOnListItemObjectSet(UObject* ListItemObject)
+{
+	IUserObjectListEntry::NativeOnListItemObjectSet(ListItemObject);
+
+	SetItem(Cast<UItem>(ListItemObject));
+}
+
+
+void UInventoryItemWidget::NativeOnEntryReleased()
+{
+	IUserObjectListEntry::NativeOnEntryReleased();
+
+	//Back in the pool, so stop listening to an item we no longer show
+	SetItem(nullptr);
+}
+
+
+void UInventoryItemWidget::NativeOnMouseEnter(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent)
+{
+	Super::NativeOnMouseEnter(InGeometry, InMouseEvent);
+
+	if (!Item || !Item->ItemTooltip)
+	{
+		return;
+	}
+
+	if (!Tooltip)
+	{
+		Tooltip = CreateWidget<UItemTooltip>(this, Item->ItemTooltip);
+		Tooltip->InventoryItemWidget = this;
+		SetToolTip(Tooltip);
+	}
+}
+
+
+void UInventoryItemWidget::OnItemModified()
+{
+	RefreshItem();
+}
+
+
+void UInventoryItemWidget::OnThumbnailLoaded(TWeakObjectPtr<UItem> LoadedItem)
+{
+	//We may have been recycled for another item while the thumbnail was loading
+	if (Item && Item == LoadedItem.Get())
+	{
+		RefreshItem();
+	}
+}
+
+
+void UInventoryItemWidget::SetItem(UItem* NewItem)
+{
+	if (Item)
+	{
+		Item->OnItemModified.RemoveDynamic(this, &UInventoryItemWidget::OnItemModified);
+	}
+
+	//The tooltip reads the item when it's constructed, so a recycled widget needs a new one
+	if (Tooltip && NewItem != Item)
+	{
+		Tooltip = nullptr;
+		SetToolTip(nullptr);
+	}
+
+	Item = NewItem;
+
+	if (Item)
+	{
+		Item->OnItemModified.AddDynamic(this, &UInventoryItemWidget::OnItemModified);
+		RefreshItem();
+
+		//Refresh again once the thumbnail is in, Thumbnail is null until then
+		if (!Item->Thumbnail && !Item->ThumbnailAsset.IsNull())
+		{
+			Item->RequestThumbnail(EAssetStreamPriority::VisibleUI, FSimpleDelegate::CreateUObject(this, &UInventoryItemWidget::OnThumbnailLoaded, TWeakObjectPtr<UItem>(Item)));
+		}
+	}
+}
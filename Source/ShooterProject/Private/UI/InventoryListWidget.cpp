@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UI/InventoryListWidget.h"
+#include "Components/InventoryComponent.h"
+#include "Components/ListView.h"
+#include "Components/TileView.h"
+#include "Blueprint/WidgetTree.h"
+#include "Items/Item.h"
+#include "UI/InventoryItemWidget.h"
+#include "Framework/Application/SlateApplication.h"
+#include "UObject/ConstructorHelpers.h"
+#include "UObject/UObjectIterator.h"
+
+UInventoryListWidget::UInventoryListWidget(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	static ConstructorHelpers::FClassFinder<UInventoryItemWidget> InventoryItemClass(TEXT("/Game/Blueprints/UI/Widget/WBP_InventoryItem"));
+	if (InventoryItemClass.Class != NULL)
+	{
+		EntryWidgetClass = InventoryItemClass.Class;
+	}
+}
+
+
+bool UInventoryListWidget::Initialize()
+{
+	if (!Super::Initialize())
+	{
+		return false;
+	}
+
+	//Nothing laid out for us, so make a tile view to match the old wrap box of item widgets
+	if (!ItemList && WidgetTree && !WidgetTree->RootWidget && EntryWidgetClass)
+	{
+		UTileView* TileView = WidgetTree->ConstructWidget<UTileView>(UTileView::StaticClass(), TEXT("ItemList"));
+
+		//The list only exposes its entry class to the designer
+		if (FClassProperty* EntryClassProperty = FindFProperty<FClassProperty>(UListViewBase::StaticClass(), TEXT("EntryWidgetClass")))
+		{
+			EntryClassProperty->SetObjectPropertyValue_InContainer(TileView, EntryWidgetClass);
+		}
+
+		WidgetTree->RootWidget = TileView;
+		ItemList = TileView;
+	}
+
+	return true;
+}
+
+
+void UInventoryListWidget::SetInventory(UInventoryComponent* NewInventory)
+{
+	if (Inventory)
+	{
+		Inventory->OnInventoryUpdated.RemoveDynamic(this, &UInventoryListWidget::SyncItems);
+	}
+
+	Inventory = NewInventory;
+
+	if (Inventory)
+	{
+		Inventory->OnInventoryUpdated.AddDynamic(this, &UInventoryListWidget::SyncItems);
+	}
+
+	SyncItems();
+}
+
+
+void UInventoryListWidget::SyncItems()
+{
+	if (!ItemList)
+	{
+		return;
+	}
+
+	//What the list should show, in inventory order
+	TArray<UObject*> OrderedItems;
+	TSet<UObject*> InventoryItems;
+
+	if (Inventory)
+	{
+		for (UItem* Item : Inventory->GetItems())
+		{
+			if (Item && Item->ShouldShowInInventory())
+			{
+				OrderedItems.Add(Item);
+				InventoryItems.Add(Item);
+			}
+		}
+	}
+
+	//Take out what's gone. The list keeps widgets for the rest, and releases the removed ones back to its pool
+	TSet<UObject*> ListedItems;
+	const TArray<UObject*> CurrentItems = ItemList->GetListItems();
+
+	for (UObject* ListedItem : CurrentItems)
+	{
+		if (InventoryItems.Contains(ListedItem))
+		{
+			ListedItems.Add(ListedItem);
+		}
+		else
+		{
+			ItemList->RemoveItem(ListedItem);
+		}
+	}
+
+	//Then add what's new where it is in the inventory. Quantity changes don't get here, each entry listens to its own item for those
+	if (ListedItems.Num() == OrderedItems.Num())
+	{
+		return;
+	}
+
+	//Items that are still listed kept their order, so if everything new comes after them it can just go on the end
+	bool bNewItemsAtEnd = true;
+	int32 FirstNewIndex = INDEX_NONE;
+
+	for (int32 i = 0; i < OrderedItems.Num(); ++i)
+	{
+		if (!ListedItems.Contains(OrderedItems[i]))
+		{
+			FirstNewIndex = FirstNewIndex == INDEX_NONE ? i : FirstNewIndex;
+		}
+		else if (FirstNewIndex != INDEX_NONE)
+		{
+			bNewItemsAtEnd = false;
+			break;
+		}
+	}
+
+	if (bNewItemsAtEnd)
+	{
+		for (int32 i = FirstNewIndex; i < OrderedItems.Num(); ++i)
+		{
+			ItemList->AddItem(OrderedItems[i]);
+		}
+	}
+	else
+	{
+		//The list has no insert, so hand it the whole order. Entries for items it already shows are kept, not rebuilt.
+		ItemList->SetListItems(OrderedItems);
+	}
+}
+
+
+void UInventoryListWidget::NativeDestruct()
+{
+	if (Inventory)
+	{
+		Inventory->OnInventoryUpdated.RemoveDynamic(this, &UInventoryListWidget::SyncItems);
+	}
+
+	Super::NativeDestruct();
+}
+
+
+static FAutoConsoleCommandWithWorldAndArgs InventoryListBenchmarkCommand(
+	TEXT("ui.InventoryListBenchmark"),
+	TEXT("Compare building a widget for every item in a stash against filling the inventory list, which only builds the rows on screen. Needs an inventory list on screen. Usage: ui.InventoryListBenchmark [Items]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UInventoryListWidget* ListWidget = nullptr;
+
+		for (TObjectIterator<UInventoryListWidget> It; It; ++It)
+		{
+			if (It->GetWorld() == World && It->ItemList && It->ItemList->GetCachedWidget().IsValid() && It->IsVisible())
+			{
+				ListWidget = *It;
+				break;
+			}
+		}
+
+		if (!ListWidget || !ListWidget->ItemList->GetEntryWidgetClass())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ui.InventoryListBenchmark: no inventory list with an entry widget class on screen"));
+			return;
+		}
+
+		UListView* ItemList = ListWidget->ItemList;
+		const int32 NumItems = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 500;
+
+		TArray<UItem*> Items;
+		Items.Reserve(NumItems);
+
+		for (int32 i = 0; i < NumItems; ++i)
+		{
+			Items.Add(NewObject<UItem>(GetTransientPackage()));
+		}
+
+		//The old way, one widget per item, each built straight away
+		TArray<UUserWidget*> EntryWidgets;
+		EntryWidgets.Reserve(NumItems);
+
+		double StartTime = FPlatformTime::Seconds();
+
+		for (int32 i = 0; i < NumItems; ++i)
+		{
+			UUserWidget* EntryWidget = CreateWidget<UUserWidget>(ListWidget->GetOwningPlayer(), ItemList->GetEntryWidgetClass());
+			EntryWidget->TakeWidget();
+			EntryWidgets.Add(EntryWidget);
+		}
+
+		const double RebuildSeconds = FPlatformTime::Seconds() - StartTime;
+
+		for (UUserWidget* EntryWidget : EntryWidgets)
+		{
+			EntryWidget->ReleaseSlateResources(true);
+			EntryWidget->MarkPendingKill();
+		}
+
+		//The list only makes entries once it ticks, so tick it here to count the time to generate what's on screen
+		StartTime = FPlatformTime::Seconds();
+
+		ItemList->SetListItems(Items);
+
+		TSharedPtr<SWidget> ListSlateWidget = ItemList->GetCachedWidget();
+		ListSlateWidget->Tick(ListSlateWidget->GetCachedGeometry(), FSlateApplication::Get().GetCurrentTime(), 0.f);
+
+		const double ListSeconds = FPlatformTime::Seconds() - StartTime;
+		const int32 NumEntryWidgets = ItemList->GetDisplayedEntryWidgets().Num();
+
+		UE_LOG(LogTemp, Log, TEXT("ui.InventoryListBenchmark: %d items, one widget each took %.2fms, the list made %d widgets in %.2fms"),
+			NumItems, RebuildSeconds * 1000.0, NumEntryWidgets, ListSeconds * 1000.0);
+
+		//Put the real inventory back, and tick again so the list lets go of our items before they're thrown away
+		ItemList->ClearListItems();
+		ListWidget->SyncItems();
+		ListSlateWidget->Tick(ListSlateWidget->GetCachedGeometry(), FSlateApplication::Get().GetCurrentTime(), 0.f);
+
+		for (UItem* Item : Items)
+		{
+			Item->MarkPendingKill();
+		}
+	}));
@@ -2,6 +2,7 @@
 
 
 #include "UI/InventoryUserWidget.h"
+#include "UI/InventoryListWidget.h"
 
 UInventoryUserWidget::UInventoryUserWidget(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -11,4 +12,12 @@ UInventoryUserWidget::UInventoryUserWidget(const FObjectInitializer& ObjectIniti
 void UInventoryUserWidget::NativeConstruct()
 {
 	Super::NativeConstruct();
+
+	if (InventoryList)
+	{
+		if (AShooterProjectCharacter* Character = Cast<AShooterProjectCharacter>(GetOwningPlayerPawn()))
+		{
+			InventoryList->SetInventory(Character->PlayerInventory);
+		}
+	}
 }
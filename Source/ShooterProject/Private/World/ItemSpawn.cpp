@@ -4,6 +4,9 @@
 #include "World/ItemSpawn.h"
 
 #include "Items/Item.h"
+#include "World/LootDirectorSubsystem.h"
+#include "World/LootSpawnSubsystem.h"
+#include "World/LootTableSubsystem.h"
 #include "World/Pickup.h"
 
 AItemSpawn::AItemSpawn()
@@ -23,36 +26,89 @@ void AItemSpawn::OnItemTaken(AActor* DestroyedActor)
 
 		if (SpawnedPickups.Num() <= 0)
 		{
-			GetWorldTimerManager().SetTimer(TimerHandle_RespawnItem, this, &AItemSpawn::SpawnItem, FMath::RandRange(RespawnRange.GetMin(), RespawnRange.GetMax()), false);
+			ScheduleRespawn();
 		}
 	}
 }
 
 
-void AItemSpawn::SpawnItem()
+void AItemSpawn::ScheduleRespawn()
+{
+	GetWorldTimerManager().SetTimer(TimerHandle_RespawnItem, this, &AItemSpawn::QueueSpawn, LootStream.RandRange(RespawnRange.GetMin(), RespawnRange.GetMax()), false);
+}
+
+
+void AItemSpawn::RollLoot(const FRandomStream& RandomStream, TArray<TSubclassOf<UItem>>& OutItems, const ULootDirectorSubsystem* LootDirector /*= nullptr*/) const
 {
-	if (HasAuthority() && LootTable)
+	if (const FCompiledLootTable* CompiledTable = ULootTableSubsystem::FindOrCompile(this, LootTable))
 	{
-		TArray<FLootTableRow*> SpawnItems;
-		LootTable->GetAllRows("", SpawnItems);
+		RollLoot(*CompiledTable, RandomStream, OutItems, LootDirector);
+	}
+}
 
-		const FLootTableRow* LootRow = SpawnItems[FMath::FRandRange(0, SpawnItems.Num() - 1)];
 
-		ensure(LootRow);
+bool AItemSpawn::RollLoot(const FCompiledLootTable& CompiledTable, const FRandomStream& RandomStream, TArray<TSubclassOf<UItem>>& OutItems, const ULootDirectorSubsystem* LootDirector /*= nullptr*/) const
+{
+	const FLootTableRow* LootRow = LootDirector ? LootDirector->SampleLootTable(CompiledTable, RandomStream, this) : CompiledTable.Sample(RandomStream);
 
-		float ProbabilityRoll = FMath::FRandRange(0.f, 1.f);
+	if (LootRow)
+	{
+		OutItems.Append(LootRow->Items);
+	}
 
-		while (ProbabilityRoll > LootRow->Probability)
+	return LootRow != nullptr;
+}
+
+
+void AItemSpawn::QueueSpawn()
+{
+	if (ULootSpawnSubsystem* LootSpawnSubsystem = GetWorld()->GetSubsystem<ULootSpawnSubsystem>())
+	{
+		LootSpawnSubsystem->RequestSpawn(this);
+	}
+	else
+	{
+		SpawnItem();
+	}
+}
+
+
+void AItemSpawn::SpawnItem()
+{
+	if (HasAuthority() && PickupClass)
+	{
+		const ULootDirectorSubsystem* LootDirector = GetWorld()->GetSubsystem<ULootDirectorSubsystem>();
+
+		//The world already has as many pickups as we allow, try again later
+		if (LootDirector && LootDirector->IsAtPickupBudget())
+		{
+			ScheduleRespawn();
+			return;
+		}
+
+		const FCompiledLootTable* CompiledTable = ULootTableSubsystem::FindOrCompile(this, LootTable);
+
+		//Nothing will ever come out of this table, so don't keep rescheduling
+		if (!CompiledTable || CompiledTable->IsEmpty())
 		{
-			LootRow = SpawnItems[FMath::FRandRange(0, SpawnItems.Num() - 1)];
-			ProbabilityRoll = FMath::FRandRange(0.f, 1.f);
+			UE_LOG(LogTemp, Warning, TEXT("%s has no loot table rows to spawn from, it won't spawn anything."), *GetName());
+			return;
 		}
 
-		if (LootRow && LootRow->Items.Num() && PickupClass)
+		TArray<TSubclassOf<UItem>> ItemClasses;
+
+		//Everything we rolled is capped, try again later
+		if (!RollLoot(*CompiledTable, LootStream, ItemClasses, LootDirector))
 		{
-			float Angle = 0.f;
+			ScheduleRespawn();
+			return;
+		}
+
+		float Angle = 0.f;
 
-			for (auto& ItemClass : LootRow->Items)
+		for (auto& ItemClass : ItemClasses)
+		{
+			if (ItemClass)
 			{
 				const FVector LocationOffset = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * 50.f;
 
@@ -70,9 +126,9 @@ void AItemSpawn::SpawnItem()
 				Pickup->OnDestroyed.AddUniqueDynamic(this, &AItemSpawn::OnItemTaken);
 
 				SpawnedPickups.Add(Pickup);
-
-				Angle += (PI * 2.f) / LootRow->Items.Num();
 			}
+
+			Angle += (PI * 2.f) / ItemClasses.Num();
 		}
 	}
 }
@@ -84,6 +140,7 @@ void AItemSpawn::BeginPlay()
 
 	if (HasAuthority())
 	{
-		SpawnItem();
+		LootStream.Initialize(ULootTableSubsystem::MakeLootSeed(ULootTableSubsystem::GetMatchLootSeed(this), this));
+		QueueSpawn();
 	}
 }
@@ -0,0 +1,312 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "World/LootDirectorSubsystem.h"
+#include "Engine/World.h"
+#include "Items/Item.h"
+#include "World/ItemSpawn.h"
+#include "World/LootRegionVolume.h"
+#include "World/LootTableSubsystem.h"
+#include "World/Pickup.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Pickups"), STAT_LiveLootPickups, STATGROUP_Loot);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Culled Dropped Pickups"), STAT_CulledDroppedPickups, STATGROUP_Loot);
+
+ULootDirectorSubsystem::ULootDirectorSubsystem()
+{
+	MaxLivePickups = 1500;
+	MinSpawnBias = 0.1f;
+	MaxBiasRerolls = 4;
+	DroppedPickupsHead = 0;
+}
+
+
+bool ULootDirectorSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void ULootDirectorSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	for (const FLootPopulationCap& Cap : GlobalItemCaps)
+	{
+		if (UClass* ItemClass = Cap.ItemClass.LoadSynchronous())
+		{
+			ResolvedGlobalCaps.Add(ItemClass, Cap.MaxCount);
+		}
+	}
+}
+
+
+void ULootDirectorSubsystem::RegisterRegion(ALootRegionVolume* Region)
+{
+	if (Region)
+	{
+		FRegionPopulation& RegionPopulation = Regions.AddDefaulted_GetRef();
+		RegionPopulation.Region = Region;
+
+		ActorRegionIndices.Empty();
+	}
+}
+
+
+void ULootDirectorSubsystem::UnregisterRegion(ALootRegionVolume* Region)
+{
+	//Keep the slot around so the region indices of tracked loot stay valid
+	for (FRegionPopulation& RegionPopulation : Regions)
+	{
+		if (RegionPopulation.Region == Region)
+		{
+			RegionPopulation.Region = nullptr;
+		}
+	}
+
+	ActorRegionIndices.Empty();
+}
+
+
+void ULootDirectorSubsystem::RegisterPickup(APickup* Pickup, UClass* ItemClass, const bool bDropped)
+{
+	if (!Pickup || !ItemClass || LivePickups.Contains(Pickup))
+	{
+		return;
+	}
+
+	FTrackedPickup TrackedPickup;
+	TrackedPickup.ItemClass = ItemClass;
+	TrackedPickup.RegionIndex = FindRegionIndex(Pickup->GetActorLocation());
+
+	LivePickups.Add(Pickup, TrackedPickup);
+	AddLive(ItemClass, TrackedPickup.RegionIndex);
+
+	SET_DWORD_STAT(STAT_LiveLootPickups, LivePickups.Num());
+
+	if (bDropped)
+	{
+		DroppedPickups.Add(Pickup);
+	}
+
+	CullDroppedPickups();
+}
+
+
+void ULootDirectorSubsystem::UnregisterPickup(APickup* Pickup)
+{
+	FTrackedPickup TrackedPickup;
+
+	if (LivePickups.RemoveAndCopyValue(Pickup, TrackedPickup))
+	{
+		RemoveLive(TrackedPickup.ItemClass, TrackedPickup.RegionIndex);
+
+		SET_DWORD_STAT(STAT_LiveLootPickups, LivePickups.Num());
+	}
+}
+
+
+void ULootDirectorSubsystem::AddContainerLoot(UClass* ItemClass, const AActor* Container)
+{
+	AddLive(ItemClass, GetActorRegionIndex(Container));
+}
+
+
+void ULootDirectorSubsystem::RemoveContainerLoot(UClass* ItemClass, const AActor* Container)
+{
+	RemoveLive(ItemClass, GetActorRegionIndex(Container));
+}
+
+
+const FLootTableRow* ULootDirectorSubsystem::SampleLootTable(const FCompiledLootTable& LootTable, const FRandomStream& RandomStream, const AActor* Spawner) const
+{
+	const int32 RegionIndex = GetActorRegionIndex(Spawner);
+
+	for (int32 Roll = 0; Roll <= MaxBiasRerolls; ++Roll)
+	{
+		const FLootTableRow* LootRow = LootTable.Sample(RandomStream);
+
+		if (!LootRow)
+		{
+			return nullptr;
+		}
+
+		//A row is only as likely to be kept as its most capped item
+		float RowBias = 1.f;
+
+		for (const TSubclassOf<UItem>& ItemClass : LootRow->Items)
+		{
+			RowBias = FMath::Min(RowBias, GetSpawnBias(ItemClass, RegionIndex));
+		}
+
+		//Always draw the number, so the stream advances the same way no matter what the bias was
+		const float KeepRoll = RandomStream.GetFraction();
+
+		if (RowBias > 0.f && (KeepRoll < RowBias || Roll == MaxBiasRerolls))
+		{
+			return LootRow;
+		}
+	}
+
+	return nullptr;
+}
+
+
+bool ULootDirectorSubsystem::IsAtPickupBudget() const
+{
+	return MaxLivePickups > 0 && LivePickups.Num() >= MaxLivePickups;
+}
+
+
+int32 ULootDirectorSubsystem::GetLiveCount(TSubclassOf<UItem> ItemClass) const
+{
+	const int32* LiveCount = LiveCounts.Find(ItemClass);
+	return LiveCount ? *LiveCount : 0;
+}
+
+
+int32 ULootDirectorSubsystem::FindRegionIndex(const FVector& Location) const
+{
+	for (int32 i = 0; i < Regions.Num(); ++i)
+	{
+		if (const ALootRegionVolume* Region = Regions[i].Region.Get())
+		{
+			if (Region->EncompassesPoint(Location))
+			{
+				return i;
+			}
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+
+int32 ULootDirectorSubsystem::GetActorRegionIndex(const AActor* Actor) const
+{
+	if (!Actor)
+	{
+		return INDEX_NONE;
+	}
+
+	if (const int32* RegionIndex = ActorRegionIndices.Find(Actor))
+	{
+		return *RegionIndex;
+	}
+
+	return ActorRegionIndices.Add(Actor, FindRegionIndex(Actor->GetActorLocation()));
+}
+
+
+void ULootDirectorSubsystem::AddLive(UClass* ItemClass, const int32 RegionIndex)
+{
+	if (!ItemClass)
+	{
+		return;
+	}
+
+	++LiveCounts.FindOrAdd(ItemClass);
+
+	if (Regions.IsValidIndex(RegionIndex))
+	{
+		FRegionPopulation& RegionPopulation = Regions[RegionIndex];
+		++RegionPopulation.LiveCounts.FindOrAdd(ItemClass);
+		++RegionPopulation.LiveTotal;
+	}
+}
+
+
+void ULootDirectorSubsystem::RemoveLive(UClass* ItemClass, const int32 RegionIndex)
+{
+	if (!ItemClass)
+	{
+		return;
+	}
+
+	if (int32* LiveCount = LiveCounts.Find(ItemClass))
+	{
+		*LiveCount = FMath::Max(*LiveCount - 1, 0);
+	}
+
+	if (Regions.IsValidIndex(RegionIndex))
+	{
+		FRegionPopulation& RegionPopulation = Regions[RegionIndex];
+
+		if (int32* RegionCount = RegionPopulation.LiveCounts.Find(ItemClass))
+		{
+			*RegionCount = FMath::Max(*RegionCount - 1, 0);
+		}
+
+		RegionPopulation.LiveTotal = FMath::Max(RegionPopulation.LiveTotal - 1, 0);
+	}
+}
+
+
+float ULootDirectorSubsystem::GetSpawnBias(UClass* ItemClass, const int32 RegionIndex) const
+{
+	if (!ItemClass)
+	{
+		return 1.f;
+	}
+
+	//Find whichever cap we're closest to hitting
+	float Fill = 0.f;
+
+	if (const int32* GlobalCap = ResolvedGlobalCaps.Find(ItemClass))
+	{
+		const int32* LiveCount = LiveCounts.Find(ItemClass);
+		Fill = FMath::Max(Fill, *GlobalCap > 0 ? float(LiveCount ? *LiveCount : 0) / *GlobalCap : 1.f);
+	}
+
+	if (Regions.IsValidIndex(RegionIndex))
+	{
+		const FRegionPopulation& RegionPopulation = Regions[RegionIndex];
+
+		if (const ALootRegionVolume* Region = RegionPopulation.Region.Get())
+		{
+			if (Region->MaxItems > 0)
+			{
+				Fill = FMath::Max(Fill, float(RegionPopulation.LiveTotal) / Region->MaxItems);
+			}
+
+			if (const int32* RegionCap = Region->ItemCaps.Find(ItemClass))
+			{
+				const int32* RegionCount = RegionPopulation.LiveCounts.Find(ItemClass);
+				Fill = FMath::Max(Fill, *RegionCap > 0 ? float(RegionCount ? *RegionCount : 0) / *RegionCap : 1.f);
+			}
+		}
+	}
+
+	if (Fill >= 1.f)
+	{
+		return 0.f;
+	}
+
+	return FMath::Max(1.f - Fill, MinSpawnBias);
+}
+
+
+void ULootDirectorSubsystem::CullDroppedPickups()
+{
+	//The newest dropped pickup is never culled, otherwise dropping an item while over budget would make it vanish instantly
+	while (MaxLivePickups > 0 && LivePickups.Num() > MaxLivePickups && DroppedPickupsHead < DroppedPickups.Num() - 1)
+	{
+		APickup* OldestPickup = DroppedPickups[DroppedPickupsHead++].Get();
+
+		if (OldestPickup && !OldestPickup->IsPendingKillPending())
+		{
+			INC_DWORD_STAT(STAT_CulledDroppedPickups);
+
+			//Destroying the pickup unregisters it
+			OldestPickup->Destroy();
+		}
+	}
+
+	//Compact the queue once most of it has been handled, so it doesn't grow forever
+	if (DroppedPickupsHead > 64 && DroppedPickupsHead * 2 > DroppedPickups.Num())
+	{
+		DroppedPickups.RemoveAt(0, DroppedPickupsHead);
+		DroppedPickupsHead = 0;
+	}
+}
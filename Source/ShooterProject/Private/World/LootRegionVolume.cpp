@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "World/LootRegionVolume.h"
+#include "Engine/World.h"
+#include "World/LootDirectorSubsystem.h"
+
+ALootRegionVolume::ALootRegionVolume()
+{
+	//Regions are only used for bookkeeping on the server
+	bNetLoadOnClient = false;
+
+	MaxItems = 0;
+}
+
+
+void ALootRegionVolume::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		if (ULootDirectorSubsystem* LootDirector = GetWorld()->GetSubsystem<ULootDirectorSubsystem>())
+		{
+			LootDirector->RegisterRegion(this);
+		}
+	}
+}
+
+
+void ALootRegionVolume::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ULootDirectorSubsystem* LootDirector = GetWorld()->GetSubsystem<ULootDirectorSubsystem>())
+	{
+		LootDirector->UnregisterRegion(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
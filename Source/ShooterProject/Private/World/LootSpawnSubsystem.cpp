@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "World/LootSpawnSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "World/ItemSpawn.h"
+#include "World/LootTableSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Loot Spawn Frame Time"), STAT_LootSpawnFrameTime, STATGROUP_Loot);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Loot Spawn Queue Depth"), STAT_LootSpawnQueueDepth, STATGROUP_Loot);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Loot Spawns This Frame"), STAT_LootSpawnsThisFrame, STATGROUP_Loot);
+
+CSV_DEFINE_CATEGORY(LootSpawning, true);
+
+static TAutoConsoleVariable<float> CVarLootSpawnBudgetMs(
+	TEXT("loot.SpawnBudgetMs"),
+	1.f,
+	TEXT("Milliseconds per frame the server may spend spawning queued loot. At least one spawner is always processed per frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarLootSpawnPrioritizeInterval(
+	TEXT("loot.SpawnPrioritizeInterval"),
+	0.25f,
+	TEXT("Seconds between refreshing how far each queued loot spawn is from the closest player."),
+	ECVF_Default);
+
+
+bool ULootSpawnSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+
+void ULootSpawnSubsystem::Deinitialize()
+{
+	PendingSpawns.Empty();
+	QueuedSpawners.Empty();
+	SET_DWORD_STAT(STAT_LootSpawnQueueDepth, 0);
+
+	Super::Deinitialize();
+}
+
+
+void ULootSpawnSubsystem::RequestSpawn(AItemSpawn* ItemSpawn)
+{
+	if (!ItemSpawn || !ItemSpawn->HasAuthority())
+	{
+		return;
+	}
+
+	bool bAlreadyQueued = false;
+	QueuedSpawners.Add(ItemSpawn, &bAlreadyQueued);
+
+	if (!bAlreadyQueued)
+	{
+		FPendingSpawn PendingSpawn;
+		PendingSpawn.ItemSpawn = ItemSpawn;
+		PendingSpawn.PriorityDistanceSq = GetPriorityDistanceSq(ItemSpawn);
+		PendingSpawn.RequestOrder = NextRequestOrder++;
+
+		PendingSpawns.HeapPush(PendingSpawn);
+
+		SET_DWORD_STAT(STAT_LootSpawnQueueDepth, PendingSpawns.Num());
+	}
+}
+
+
+void ULootSpawnSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LootSpawnFrameTime);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = StartTime + (CVarLootSpawnBudgetMs.GetValueOnGameThread() / 1000.0);
+
+	if (StartTime - LastPrioritizeTime >= CVarLootSpawnPrioritizeInterval.GetValueOnGameThread())
+	{
+		PrioritizePendingSpawns();
+		LastPrioritizeTime = StartTime;
+	}
+
+	int32 NumProcessed = 0;
+
+	//Always make some progress, even if prioritizing the queue already used up the budget
+	while (PendingSpawns.Num() > 0 && (NumProcessed == 0 || FPlatformTime::Seconds() < EndTime))
+	{
+		FPendingSpawn PendingSpawn;
+		PendingSpawns.HeapPop(PendingSpawn, false);
+		QueuedSpawners.Remove(PendingSpawn.ItemSpawn);
+
+		//Removed before spawning so a later respawn of the same spawner can be queued again
+		if (AItemSpawn* ItemSpawn = PendingSpawn.ItemSpawn.Get())
+		{
+			ItemSpawn->SpawnItem();
+		}
+
+		++NumProcessed;
+	}
+
+	const float SpawnTimeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	INC_DWORD_STAT_BY(STAT_LootSpawnsThisFrame, NumProcessed);
+	SET_DWORD_STAT(STAT_LootSpawnQueueDepth, PendingSpawns.Num());
+	CSV_CUSTOM_STAT(LootSpawning, QueueDepth, PendingSpawns.Num(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(LootSpawning, SpawnsPerFrame, NumProcessed, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(LootSpawning, SpawnTimeMs, SpawnTimeMs, ECsvCustomStatOp::Set);
+}
+
+
+void ULootSpawnSubsystem::PrioritizePendingSpawns()
+{
+	PlayerLocations.Reset();
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APlayerController* PC = It->Get())
+		{
+			if (const APawn* Pawn = PC->GetPawn())
+			{
+				PlayerLocations.Add(Pawn->GetActorLocation());
+			}
+		}
+	}
+
+	//With nobody to sort by (usually the first frame of the map) every distance is MAX_flt, so we spawn in the order we were asked to
+	for (FPendingSpawn& PendingSpawn : PendingSpawns)
+	{
+		PendingSpawn.PriorityDistanceSq = GetPriorityDistanceSq(PendingSpawn.ItemSpawn.Get());
+	}
+
+	PendingSpawns.Heapify();
+}
+
+
+float ULootSpawnSubsystem::GetPriorityDistanceSq(const AItemSpawn* ItemSpawn) const
+{
+	float PriorityDistanceSq = MAX_flt;
+
+	if (ItemSpawn)
+	{
+		const FVector SpawnLocation = ItemSpawn->GetActorLocation();
+
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			PriorityDistanceSq = FMath::Min(PriorityDistanceSq, FVector::DistSquared(SpawnLocation, PlayerLocation));
+		}
+	}
+
+	return PriorityDistanceSq;
+}
+
+
+bool ULootSpawnSubsystem::IsTickable() const
+{
+	return PendingSpawns.Num() > 0;
+}
+
+
+ETickableTickType ULootSpawnSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+UWorld* ULootSpawnSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+
+TStatId ULootSpawnSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULootSpawnSubsystem, STATGROUP_Tickables);
+}
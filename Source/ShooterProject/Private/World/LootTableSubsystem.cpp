@@ -0,0 +1,327 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "World/LootTableSubsystem.h"
+#include "Engine/DataTable.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Framework/ShooterProjectGameMode.h"
+#include "HAL/IConsoleManager.h"
+#include "Items/Item.h"
+#include "World/ItemSpawn.h"
+#include "World/LootableObject.h"
+
+FCompiledLootTable::FCompiledLootTable(const UDataTable* LootTable)
+{
+	if (!LootTable)
+	{
+		return;
+	}
+
+	TArray<FLootTableRow*> AllRows;
+	LootTable->GetAllRows("", AllRows);
+
+	float TotalWeight = 0.f;
+
+	for (const FLootTableRow* Row : AllRows)
+	{
+		if (Row && Row->Probability > 0.f)
+		{
+			Rows.Add(Row);
+			Weights.Add(Row->Probability);
+			TotalWeight += Row->Probability;
+		}
+	}
+
+	const int32 NumRows = Rows.Num();
+
+	if (NumRows == 0)
+	{
+		return;
+	}
+
+	KeepProbability.SetNumUninitialized(NumRows);
+	Alias.SetNumUninitialized(NumRows);
+
+	//Scale every weight so the average column holds exactly 1.0, then split columns into under and overfull ones
+	TArray<int32> Small;
+	TArray<int32> Large;
+
+	for (int32 i = 0; i < NumRows; ++i)
+	{
+		Weights[i] /= TotalWeight;
+		KeepProbability[i] = Weights[i] * NumRows;
+		Alias[i] = i;
+
+		if (KeepProbability[i] < 1.f)
+		{
+			Small.Add(i);
+		}
+		else
+		{
+			Large.Add(i);
+		}
+	}
+
+	//Fill up each underfull column with the remainder of an overfull one
+	while (Small.Num() && Large.Num())
+	{
+		const int32 Less = Small.Pop(false);
+		const int32 More = Large.Pop(false);
+
+		Alias[Less] = More;
+		KeepProbability[More] = (KeepProbability[More] + KeepProbability[Less]) - 1.f;
+
+		if (KeepProbability[More] < 1.f)
+		{
+			Small.Add(More);
+		}
+		else
+		{
+			Large.Add(More);
+		}
+	}
+
+	//Whatever is left is only off by floating point error, so it should always keep its own column
+	for (const int32 Index : Large)
+	{
+		KeepProbability[Index] = 1.f;
+	}
+
+	for (const int32 Index : Small)
+	{
+		KeepProbability[Index] = 1.f;
+	}
+}
+
+
+const FLootTableRow* FCompiledLootTable::Sample(const float ColumnRoll, const float AliasRoll) const
+{
+	if (IsEmpty())
+	{
+		return nullptr;
+	}
+
+	//Rolls may include 1.0, which would step one past the last column
+	const int32 Column = FMath::Min(FMath::FloorToInt(ColumnRoll * Rows.Num()), Rows.Num() - 1);
+
+	return Rows[AliasRoll < KeepProbability[Column] ? Column : Alias[Column]];
+}
+
+
+const FLootTableRow* FCompiledLootTable::Sample() const
+{
+	return Sample(FMath::FRand(), FMath::FRand());
+}
+
+
+const FLootTableRow* FCompiledLootTable::Sample(const FRandomStream& RandomStream) const
+{
+	const float ColumnRoll = RandomStream.GetFraction();
+	return Sample(ColumnRoll, RandomStream.GetFraction());
+}
+
+
+float FCompiledLootTable::GetRowWeight(const int32 RowIndex) const
+{
+	return Weights.IsValidIndex(RowIndex) ? Weights[RowIndex] : 0.f;
+}
+
+
+void ULootTableSubsystem::Deinitialize()
+{
+	for (auto& CompiledTable : CompiledTables)
+	{
+		if (const UDataTable* LootTable = CompiledTable.Key.Get())
+		{
+			const_cast<UDataTable*>(LootTable)->OnDataTableChanged().RemoveAll(this);
+		}
+	}
+
+	CompiledTables.Empty();
+
+	Super::Deinitialize();
+}
+
+
+const FCompiledLootTable* ULootTableSubsystem::GetCompiledTable(const UDataTable* LootTable)
+{
+	if (!LootTable)
+	{
+		return nullptr;
+	}
+
+	if (const TSharedRef<FCompiledLootTable>* CompiledTable = CompiledTables.Find(LootTable))
+	{
+		return &CompiledTable->Get();
+	}
+
+	//Recompile if a designer edits the table while we're running
+	const_cast<UDataTable*>(LootTable)->OnDataTableChanged().AddUObject(this, &ULootTableSubsystem::OnLootTableChanged, TWeakObjectPtr<const UDataTable>(LootTable));
+
+	const TSharedRef<FCompiledLootTable>& NewTable = CompiledTables.Add(LootTable, MakeShared<FCompiledLootTable>(LootTable));
+	return &NewTable.Get();
+}
+
+
+const FCompiledLootTable* ULootTableSubsystem::FindOrCompile(const UObject* WorldContextObject, const UDataTable* LootTable)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+
+	if (UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr)
+	{
+		if (ULootTableSubsystem* LootTableSubsystem = GameInstance->GetSubsystem<ULootTableSubsystem>())
+		{
+			return LootTableSubsystem->GetCompiledTable(LootTable);
+		}
+	}
+
+	return nullptr;
+}
+
+
+int32 ULootTableSubsystem::GetMatchLootSeed(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+
+	if (const AShooterProjectGameMode* GameMode = World ? World->GetAuthGameMode<AShooterProjectGameMode>() : nullptr)
+	{
+		return GameMode->GetLootSeed();
+	}
+
+	return 0;
+}
+
+
+int32 ULootTableSubsystem::MakeLootSeed(const int32 MatchSeed, const AActor* Spawner, const int32 SpawnerSeed /*= 0*/)
+{
+	return CombineLootSeed(MatchSeed, GetSpawnerHash(Spawner, SpawnerSeed));
+}
+
+
+uint32 ULootTableSubsystem::GetSpawnerHash(const AActor* Spawner, const int32 SpawnerSeed /*= 0*/)
+{
+	uint32 SpawnerHash = static_cast<uint32>(SpawnerSeed);
+
+	if (SpawnerHash == 0 && Spawner)
+	{
+		//The path name is stable between runs for level placed actors, but PIE adds a prefix we need to strip
+		SpawnerHash = FCrc::StrCrc32(*UWorld::RemovePIEPrefix(Spawner->GetPathName()));
+	}
+
+	return SpawnerHash;
+}
+
+
+int32 ULootTableSubsystem::CombineLootSeed(const int32 MatchSeed, const uint32 SpawnerHash)
+{
+	return static_cast<int32>(HashCombine(static_cast<uint32>(MatchSeed), SpawnerHash));
+}
+
+
+void ULootTableSubsystem::OnLootTableChanged(TWeakObjectPtr<const UDataTable> LootTable)
+{
+	if (const UDataTable* ChangedTable = LootTable.Get())
+	{
+		CompiledTables.Add(LootTable, MakeShared<FCompiledLootTable>(ChangedTable));
+	}
+}
+
+
+/** loot.Simulate [Matches] [FirstMatchSeed]
+Re-rolls the loot of every spawner and container in the current map for a number of match seeds without spawning anything,
+then logs how often each item came up. Useful for balancing loot tables and checking their distributions. */
+static FAutoConsoleCommandWithWorldAndArgs SimulateLootCommand(
+	TEXT("loot.Simulate"),
+	TEXT("Simulate the loot of N matches on the current map and print an item histogram. Usage: loot.Simulate [Matches] [FirstMatchSeed]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		const int32 NumMatches = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		const int32 FirstMatchSeed = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1;
+
+		//Everything that doesn't change between matches is looked up here, so the timed loop only measures the rolls
+		struct FSimulatedSpawner
+		{
+			const AItemSpawn* ItemSpawn;
+			const ALootableObject* LootableObject;
+			const FCompiledLootTable* CompiledTable;
+			uint32 SpawnerHash;
+		};
+
+		TArray<FSimulatedSpawner> Spawners;
+		int32 NumItemSpawns = 0;
+		int32 NumLootableObjects = 0;
+
+		for (TActorIterator<AItemSpawn> It(World); It; ++It)
+		{
+			if (const FCompiledLootTable* CompiledTable = ULootTableSubsystem::FindOrCompile(World, It->GetLootTable()))
+			{
+				Spawners.Add({ *It, nullptr, CompiledTable, ULootTableSubsystem::GetSpawnerHash(*It) });
+				++NumItemSpawns;
+			}
+		}
+
+		for (TActorIterator<ALootableObject> It(World); It; ++It)
+		{
+			if (const FCompiledLootTable* CompiledTable = ULootTableSubsystem::FindOrCompile(World, It->LootTable))
+			{
+				Spawners.Add({ nullptr, *It, CompiledTable, ULootTableSubsystem::GetSpawnerHash(*It, It->LootSeed) });
+				++NumLootableObjects;
+			}
+		}
+
+		TMap<UClass*, int64> ItemCounts;
+		TArray<TSubclassOf<UItem>> RolledItems;
+		FRandomStream LootStream;
+		int64 NumItems = 0;
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 Match = 0; Match < NumMatches; ++Match)
+		{
+			const int32 MatchSeed = FirstMatchSeed + Match;
+
+			RolledItems.Reset();
+
+			for (const FSimulatedSpawner& Spawner : Spawners)
+			{
+				LootStream.Initialize(ULootTableSubsystem::CombineLootSeed(MatchSeed, Spawner.SpawnerHash));
+
+				if (Spawner.ItemSpawn)
+				{
+					Spawner.ItemSpawn->RollLoot(*Spawner.CompiledTable, LootStream, RolledItems);
+				}
+				else
+				{
+					Spawner.LootableObject->RollLoot(*Spawner.CompiledTable, LootStream, RolledItems);
+				}
+			}
+
+			for (const TSubclassOf<UItem>& ItemClass : RolledItems)
+			{
+				++ItemCounts.FindOrAdd(ItemClass.Get());
+			}
+
+			NumItems += RolledItems.Num();
+		}
+
+		const double ElapsedTime = FMath::Max(FPlatformTime::Seconds() - StartTime, SMALL_NUMBER);
+		const int64 NumSpawners = int64(Spawners.Num()) * NumMatches;
+
+		UE_LOG(LogTemp, Display, TEXT("Simulated %d matches (%d spawners, %d containers): %lld spawner rolls, %lld items in %.3fs (%.2f million spawners per second)"),
+			NumMatches, NumItemSpawns, NumLootableObjects, NumSpawners, NumItems, ElapsedTime, (NumSpawners / ElapsedTime) / 1000000.0);
+
+		ItemCounts.ValueSort([](const int64 A, const int64 B) { return A > B; });
+
+		for (const auto& ItemCount : ItemCounts)
+		{
+			UE_LOG(LogTemp, Display, TEXT("  %-48s %12lld  %6.2f%%  %.3f per match"),
+				ItemCount.Key ? *ItemCount.Key->GetName() : TEXT("None"), ItemCount.Value, (100.0 * ItemCount.Value) / FMath::Max<int64>(NumItems, 1), double(ItemCount.Value) / NumMatches);
+		}
+	}));
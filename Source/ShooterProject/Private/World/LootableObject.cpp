@@ -4,14 +4,21 @@
 #include "World/LootableObject.h"
 #include "Components/InteractionComponent.h"
 #include "Components/InventoryComponent.h"
+#include "Components/SphereComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "World/ItemSpawn.h"
+#include "World/LootDirectorSubsystem.h"
+#include "World/LootTableSubsystem.h"
 #include "Engine/DataTable.h"
 #include "Items/Item.h"
 #include "Player/ShooterProjectCharacter.h"
 
 #define LOCTEXT_NAMESPACE "LootableObject"
 
+DECLARE_CYCLE_STAT(TEXT("Generate Loot"), STAT_GenerateLoot, STATGROUP_Loot);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pending Loot Containers"), STAT_PendingLootContainers, STATGROUP_Loot);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Generated Loot Containers"), STAT_GeneratedLootContainers, STATGROUP_Loot);
+
 // Sets default values
 ALootableObject::ALootableObject()
 {
@@ -28,6 +35,9 @@ ALootableObject::ALootableObject()
 	Inventory->SetWeightCapacity(80.f);
 
 	LootRolls = FIntPoint(2, 8);
+	LootSeed = 0;
+	LootGenerationRadius = 0.f;
+	bLootGenerated = false;
 
 	SetReplicates(true);
 }
@@ -39,50 +49,160 @@ void ALootableObject::BeginPlay()
 
 	LootInteraction->OnInteract.AddDynamic(this, &ALootableObject::OnInteract);
 
-	if (HasAuthority() && LootTable)
+	if (HasAuthority())
+	{
+		INC_DWORD_STAT(STAT_PendingLootContainers);
+
+		if (LootGenerationRadius > 0.f)
+		{
+			LootGenerationTrigger = NewObject<USphereComponent>(this, TEXT("LootGenerationTrigger"));
+			LootGenerationTrigger->InitSphereRadius(LootGenerationRadius);
+			LootGenerationTrigger->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+			LootGenerationTrigger->SetCollisionResponseToAllChannels(ECR_Ignore);
+			LootGenerationTrigger->SetCollisionResponseToChannel(ECC_Pawn, ECR_Overlap);
+			LootGenerationTrigger->SetGenerateOverlapEvents(true);
+			LootGenerationTrigger->SetupAttachment(GetRootComponent());
+			LootGenerationTrigger->OnComponentBeginOverlap.AddDynamic(this, &ALootableObject::OnLootGenerationTriggerOverlap);
+			LootGenerationTrigger->RegisterComponent();
+		}
+	}
+}
+
+
+void ALootableObject::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (HasAuthority() && !bLootGenerated)
+	{
+		DEC_DWORD_STAT(STAT_PendingLootContainers);
+	}
+
+	//Anything still in the container leaves the world with it
+	if (HasAuthority() && bLootGenerated)
+	{
+		for (UItem* Item : Inventory->GetItems())
+		{
+			OnLootRemoved(Item);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void ALootableObject::GenerateLoot()
+{
+	if (!HasAuthority() || bLootGenerated)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GenerateLoot);
+
+	bLootGenerated = true;
+	DEC_DWORD_STAT(STAT_PendingLootContainers);
+	INC_DWORD_STAT(STAT_GeneratedLootContainers);
+
+	if (LootGenerationTrigger)
 	{
-		TArray<FLootTableRow*> SpawnItems;
-		LootTable->GetAllRows("", SpawnItems);
+		LootGenerationTrigger->DestroyComponent();
+		LootGenerationTrigger = nullptr;
+	}
+
+	//Seeded, so a container always rolls the same loot no matter when it gets opened
+	const FRandomStream LootStream(GetLootSeed(ULootTableSubsystem::GetMatchLootSeed(this)));
 
-		int32 Rolls = FMath::RandRange(LootRolls.GetMin(), LootRolls.GetMax());
+	ULootDirectorSubsystem* LootDirector = GetWorld()->GetSubsystem<ULootDirectorSubsystem>();
 
-		for (int32 i = 0; i < Rolls; ++i)
+	TArray<TSubclassOf<UItem>> ItemClasses;
+	RollLoot(LootStream, ItemClasses, LootDirector);
+
+	for (auto& ItemClass : ItemClasses)
+	{
+		if (ItemClass)
 		{
-			const FLootTableRow* LootRow = SpawnItems[FMath::RandRange(0, SpawnItems.Num() - 1)];
-
-			ensure(LootRow);
-
-			float ProbabilityRoll = FMath::FRandRange(0.f, 1.f);
-
-			while (ProbabilityRoll > LootRow->Probability)
-			{
-				LootRow = SpawnItems[FMath::RandRange(0, SpawnItems.Num() - 1)];
-				ProbabilityRoll = FMath::FRandRange(0.f, 1.f);
-			}
-
-			if (LootRow && LootRow->Items.Num())
-			{
-				for (auto& ItemClass : LootRow->Items)
-				{
-					if (ItemClass)
-					{
-						const int32 Quantity = Cast<UItem>(ItemClass->GetDefaultObject())->GetQuantity();
-						Inventory->TryAddItemFromClass(ItemClass, Quantity);
-					}
-				}
-			}
+			const int32 Quantity = Cast<UItem>(ItemClass->GetDefaultObject())->GetQuantity();
+			Inventory->TryAddItemFromClass(ItemClass, Quantity);
 		}
 	}
-	
+
+	//Count the items that actually ended up in the container, since stackable items may have merged
+	if (LootDirector)
+	{
+		for (UItem* Item : Inventory->GetItems())
+		{
+			LootDirector->AddContainerLoot(Item->GetClass(), this);
+		}
+
+		Inventory->OnItemRemoved.AddUObject(this, &ALootableObject::OnLootRemoved);
+	}
 }
 
+
+void ALootableObject::RollLoot(const FRandomStream& RandomStream, TArray<TSubclassOf<UItem>>& OutItems, const ULootDirectorSubsystem* LootDirector /*= nullptr*/) const
+{
+	if (const FCompiledLootTable* CompiledTable = ULootTableSubsystem::FindOrCompile(this, LootTable))
+	{
+		RollLoot(*CompiledTable, RandomStream, OutItems, LootDirector);
+	}
+}
+
+
+void ALootableObject::RollLoot(const FCompiledLootTable& CompiledTable, const FRandomStream& RandomStream, TArray<TSubclassOf<UItem>>& OutItems, const ULootDirectorSubsystem* LootDirector /*= nullptr*/) const
+{
+	if (CompiledTable.IsEmpty())
+	{
+		return;
+	}
+
+	const int32 Rolls = RandomStream.RandRange(LootRolls.GetMin(), LootRolls.GetMax());
+
+	for (int32 i = 0; i < Rolls; ++i)
+	{
+		const FLootTableRow* LootRow = LootDirector ? LootDirector->SampleLootTable(CompiledTable, RandomStream, this) : CompiledTable.Sample(RandomStream);
+
+		if (LootRow)
+		{
+			OutItems.Append(LootRow->Items);
+		}
+	}
+}
+
+
+void ALootableObject::OnLootRemoved(UItem* Item)
+{
+	if (Item)
+	{
+		if (ULootDirectorSubsystem* LootDirector = GetWorld()->GetSubsystem<ULootDirectorSubsystem>())
+		{
+			LootDirector->RemoveContainerLoot(Item->GetClass(), this);
+		}
+	}
+}
+
+
 void ALootableObject::OnInteract(class AShooterProjectCharacter* Character)
 {
 	if (Character)
 	{
+		GenerateLoot();
 		Character->SetLootSource(Inventory);
 	}
 }
 
+
+void ALootableObject::OnLootGenerationTriggerOverlap(class UPrimitiveComponent* OverlappedComponent, class AActor* OtherActor, class UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	if (Cast<AShooterProjectCharacter>(OtherActor))
+	{
+		GenerateLoot();
+	}
+}
+
+
+int32 ALootableObject::GetLootSeed(const int32 MatchSeed) const
+{
+	return ULootTableSubsystem::MakeLootSeed(MatchSeed, this, LootSeed);
+}
+
 #undef LOCTEXT_NAMESPACE
 
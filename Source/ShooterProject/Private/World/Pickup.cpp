@@ -9,6 +9,9 @@
 #include "Components/InteractionComponent.h"
 #include "Components/InventoryComponent.h"
 #include "Engine/ActorChannel.h"
+#include "World/LootDirectorSubsystem.h"
+#include "Framework/AssetStreamingSubsystem.h"
+#include "Engine/StaticMesh.h"
 
 // Sets default values
 APickup::APickup()
@@ -24,13 +27,14 @@ APickup::APickup()
 	InteractionComponent->InteractibleNameText = FText::FromString("Pickup");
 	InteractionComponent->InteractibleActionText = FText::FromString("Take");
 	InteractionComponent->OnInteract.AddDynamic(this, &APickup::OnTakePickup);
+	InteractionComponent->OnBeginFocus.AddDynamic(this, &APickup::OnBeginFocus);
 	InteractionComponent->SetupAttachment(PickupMesh);
 
 	SetReplicates(true);
 }
 
 
-void APickup::InitializePickup(const TSubclassOf<class UItem> ItemClass, const int32 Quantity)
+void APickup::InitializePickup(const TSubclassOf<class UItem> ItemClass, const int32 Quantity, const bool bDropped /*= false*/)
 {
 	if (HasAuthority() && ItemClass && Quantity > 0)
 	{
@@ -39,6 +43,11 @@ void APickup::InitializePickup(const TSubclassOf<class UItem> ItemClass, const i
 
 		OnRep_Item();
 		Item->MarkDirtyForReplication();
+
+		if (ULootDirectorSubsystem* LootDirector = GetWorld()->GetSubsystem<ULootDirectorSubsystem>())
+		{
+			LootDirector->RegisterPickup(this, ItemClass, bDropped);
+		}
 	}
 }
 
@@ -47,7 +56,7 @@ void APickup::OnRep_Item()
 {
 	if (Item)
 	{
-		PickupMesh->SetStaticMesh(Item->PickupMesh);
+		RequestPickupMesh(EAssetStreamPriority::Nearby);
 
 		InteractionComponent->InteractibleNameText = Item->ItemDisplayName;
 
@@ -69,6 +78,40 @@ void APickup::OnItemModified()
 }
 
 
+void APickup::RequestPickupMesh(const EAssetStreamPriority Priority)
+{
+	if (!Item || Item->PickupMesh.IsNull())
+	{
+		return;
+	}
+
+	if (UAssetStreamingSubsystem* Streaming = GetWorld()->GetSubsystem<UAssetStreamingSubsystem>())
+	{
+		Streaming->RequestAsset(Item->PickupMesh.ToSoftObjectPath(), Priority, FSimpleDelegate::CreateUObject(this, &APickup::OnPickupMeshLoaded));
+	}
+}
+
+
+void APickup::OnPickupMeshLoaded()
+{
+	if (Item)
+	{
+		PickupMesh->SetStaticMesh(Item->PickupMesh.Get());
+	}
+}
+
+
+void APickup::OnBeginFocus(class AShooterProjectCharacter* Character)
+{
+	RequestPickupMesh(EAssetStreamPriority::FocusedPickup);
+
+	if (Item)
+	{
+		Item->RequestThumbnail(EAssetStreamPriority::FocusedPickup);
+	}
+}
+
+
 // Called when the game starts or when spawned
 void APickup::BeginPlay()
 {
@@ -94,6 +137,20 @@ void APickup::BeginPlay()
 }
 
 
+void APickup::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (HasAuthority())
+	{
+		if (ULootDirectorSubsystem* LootDirector = GetWorld()->GetSubsystem<ULootDirectorSubsystem>())
+		{
+			LootDirector->UnregisterPickup(this);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
 void APickup::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
@@ -127,7 +184,7 @@ void APickup::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent
 	{
 		if (ItemTemplate)
 		{
-			PickupMesh->SetStaticMesh(ItemTemplate->PickupMesh);
+			PickupMesh->SetStaticMesh(ItemTemplate->PickupMesh.LoadSynchronous());
 		}
 	}
 }
@@ -3,7 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Components/WidgetComponent.h"
+#include "Components/SceneComponent.h"
 #include "InteractionComponent.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBeginInteract, class AShooterProjectCharacter*, Character);
@@ -13,8 +13,12 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnEndFocus, class AShooterProjectCh
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInteract, class AShooterProjectCharacter*, Character);
 
 
+/**
+ * Makes its actor interactable. Only holds the interaction data, the widget shown when a player looks at us belongs to
+ * that player's controller and is placed over our location, so an interactable costs no widget of its own.
+ */
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
-class SHOOTERPROJECT_API UInteractionComponent : public UWidgetComponent
+class SHOOTERPROJECT_API UInteractionComponent : public USceneComponent
 {
 	GENERATED_BODY()
 
@@ -73,6 +77,7 @@ protected:
 
 	//Called when the game starts
 	virtual void Deactivate() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	bool CanInteract(class AShooterProjectCharacter* Character) const;
 
@@ -10,6 +10,9 @@
 //Called when the inventory is changed and the UI needs an update.
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnInventoryUpdated);
 
+//[Server] Called when an item has been taken out of the inventory
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnInventoryItemRemoved, class UItem*);
+
 UENUM(BlueprintType)
 enum class EItemAddResult : uint8
 {
@@ -18,6 +21,20 @@ enum class EItemAddResult : uint8
 	IAR_AllItemsAdded UMETA(DisplayName = "All items added")
 };
 
+//Why an item couldn't be added. The server only sends this, and the client turns it into localized text.
+UENUM(BlueprintType)
+enum class EItemAddError : uint8
+{
+	IAE_None UMETA(DisplayName = "None"),
+	IAE_InventoryFull UMETA(DisplayName = "Inventory full"),
+	IAE_TooMuchWeight UMETA(DisplayName = "Too much weight"),
+	IAE_NotAllAdded UMETA(DisplayName = "Not all added"),
+	IAE_StackTooMuchWeight UMETA(DisplayName = "Stack too much weight"),
+	IAE_StackInventoryFull UMETA(DisplayName = "Stack inventory full"),
+	IAE_CouldntAdd UMETA(DisplayName = "Couldn't add"),
+	IAE_FullStack UMETA(DisplayName = "Full stack")
+};
+
 //Represents the result of adding an item to the inventory
 USTRUCT(BlueprintType)
 struct FItemAddResult
@@ -44,25 +61,34 @@ public:
 
 	//If something went wrong, like we didn't have enough capacity or carrying too much, this contains the reason why
 	UPROPERTY(BlueprintReadOnly, Category = "Item Add Result")
-	FText ErrorText;
+	EItemAddError Error = EItemAddError::IAE_None;
+
+	//The item we tried to add, so the error can name it
+	UPROPERTY(BlueprintReadOnly, Category = "Item Add Result")
+	TSubclassOf<class UItem> ItemClass;
+
+	//The error as localized text. Formatted the first time it's asked for and cached after that, so only call this on clients.
+	FText GetErrorText() const;
 
 	//Helpers
-	static FItemAddResult AddedNone(const int32 InItemQuantity, const FText& ErrorText)
+	static FItemAddResult AddedNone(const int32 InItemQuantity, const EItemAddError Error, TSubclassOf<class UItem> ItemClass = nullptr)
 	{
 		FItemAddResult AddedNoneResult(InItemQuantity);
 
 		AddedNoneResult.Result = EItemAddResult::IAR_NoItemsAdded;
-		AddedNoneResult.ErrorText = ErrorText;
+		AddedNoneResult.Error = Error;
+		AddedNoneResult.ItemClass = ItemClass;
 
 		return AddedNoneResult;
 	}
 
-	static FItemAddResult AddedSome(const int32 InItemQuantity, const int32 ActualAmountGiven, const FText& ErrorText)
+	static FItemAddResult AddedSome(const int32 InItemQuantity, const int32 ActualAmountGiven, const EItemAddError Error, TSubclassOf<class UItem> ItemClass = nullptr)
 	{
 		FItemAddResult AddedSomeResult(InItemQuantity, ActualAmountGiven);
 
 		AddedSomeResult.Result = EItemAddResult::IAR_SomeItemsAdded;
-		AddedSomeResult.ErrorText = ErrorText;
+		AddedSomeResult.Error = Error;
+		AddedSomeResult.ItemClass = ItemClass;
 
 		return AddedSomeResult;
 	}
@@ -101,6 +127,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	FItemAddResult TryAddItemFromClass(TSubclassOf<class UItem> ItemClass, const int32 Quanity);
 
+	/**The reason an item couldn't be added, as localized text. Call this on clients, the server only deals in error codes*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	static FText GetItemAddErrorText(const FItemAddResult& AddResult);
+
 	/** Take some quantity away from the item, and remove it from the inventory when quantity reaches zero
 	Useful for things like eating food, using ammo, ect*/
 	int32 ConsumeItem(class UItem* Item);
@@ -126,6 +156,13 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Inventory")
 	TArray<UItem*> FindItemsByClass(TSubclassOf<class UItem> ItemClass) const;
 
+	/**Return how much of ItemClass we have, across all of its stacks*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 GetItemQuantity(TSubclassOf<class UItem> ItemClass) const;
+
+	/**[Server] Take up to Quantity of ItemClass away, across as many stacks as it takes. Returns how much was taken.*/
+	int32 ConsumeItemsByClass(TSubclassOf<class UItem> ItemClass, const int32 Quantity);
+
 	//Get the current weight of the inventory. To get the amount of item in the inventory, just do GetItems().Num()
 	UFUNCTION(BlueprintPure, Category = "Inventory")
 	float GetCurrentWeight() const;
@@ -151,6 +188,8 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Inventory")
 	FOnInventoryUpdated OnInventoryUpdated;
 
+	FOnInventoryItemRemoved OnItemRemoved;
+
 protected:
 
 	// THe Maximum weight the inventory can hold. For players, backpacks and other items increase this limit
@@ -175,6 +214,11 @@ private:
 	UFUNCTION()
 	void OnRep_Items();
 
+	void RebuildItemClassIndex();
+
+	//Items grouped by their exact class, so class lookups (like finding ammo every shot) don't scan the whole inventory
+	TMap<UClass*, TArray<UItem*, TInlineAllocator<1>>> ItemClassIndex;
+
 	UPROPERTY()
 	int32 ReplicatedItemsKey;
 
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AssetStreamingSubsystem.generated.h"
+
+//How soon a streamed asset is needed. Higher priorities jump ahead of lower ones in the async loading queue.
+UENUM()
+enum class EAssetStreamPriority : uint8
+{
+	//Pickups the player could walk up to
+	Nearby,
+
+	//The pickup the player is looking at
+	FocusedPickup,
+
+	//Shown in the UI right now
+	VisibleUI,
+
+	//Worn by a character, so it is missing from the world until it loads
+	Equipped
+};
+
+/**
+ * Loads item thumbnails and meshes in the background when something asks for them, instead of every item class pulling all
+ * of its assets in when it loads. Loaded assets are held in an LRU cache with a memory budget, so going back to something
+ * seen recently is free, while assets nothing has asked for in a while are let go for the garbage collector.
+ */
+UCLASS(config = Game)
+class SHOOTERPROJECT_API UAssetStreamingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UAssetStreamingSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	/**
+	* Load an asset in the background, or move it up the queue if it is already loading at a lower priority.
+	* @param OnLoaded Called once the asset is in memory, straight away if it already is
+	*/
+	void RequestAsset(const FSoftObjectPath& Path, const EAssetStreamPriority Priority, FSimpleDelegate OnLoaded = FSimpleDelegate());
+
+	FORCEINLINE int32 GetNumCached() const { return Assets.Num(); };
+	FORCEINLINE int64 GetCachedBytes() const { return CachedBytes; };
+
+	//Log what the cache is holding and how much memory the process is using
+	void LogCache() const;
+
+protected:
+
+	struct FStreamedAsset
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+
+		EAssetStreamPriority Priority = EAssetStreamPriority::Nearby;
+
+		//Waiting on the asset to load. Empty once it has.
+		TArray<FSimpleDelegate> PendingCallbacks;
+
+		bool bLoaded = false;
+
+		int64 SizeBytes = 0;
+
+		double LastRequestTime = 0.0;
+	};
+
+	//How much the cache can hold before the least recently requested assets are let go
+	UPROPERTY(Config)
+	float CacheBudgetMB;
+
+	FStreamableManager StreamableManager;
+
+	TMap<FSoftObjectPath, FStreamedAsset> Assets;
+
+	int64 CachedBytes;
+
+	void OnAssetLoaded(FSoftObjectPath Path);
+
+	//Release the least recently requested loaded assets until the cache fits its budget
+	void TrimCache();
+};
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BatchedTickSubsystem.generated.h"
+
+class AShooterProjectCharacter;
+class AWeaponClass;
+class AShooterProjectPlayerController;
+
+//The kinds of object we tick in batches instead of giving each its own tick function
+enum class EBatchedTick : uint8
+{
+	//Interaction checks for every character
+	Characters,
+
+	//Weapons that are firing
+	Weapons,
+
+	//Local players' interaction widgets that are on screen
+	InteractionWidgets,
+
+	MAX
+};
+
+//When and how often a batch ticks
+USTRUCT()
+struct FBatchedTickSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	TEnumAsByte<ETickingGroup> TickGroup = TG_PrePhysics;
+
+	//Seconds between ticks, zero ticks every frame
+	UPROPERTY(Config)
+	float TickInterval = 0.f;
+};
+
+//One tick function for a whole batch
+USTRUCT()
+struct FBatchedTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	class UBatchedTickSubsystem* Subsystem = nullptr;
+	EBatchedTick Batch = EBatchedTick::Characters;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRefOrdered& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FBatchedTickFunction> : public TStructOpsTypeTraitsBase2<FBatchedTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Ticks characters, firing weapons and visible interaction widgets from one tick function per kind, walking a packed
+ * array of whatever is registered, instead of every actor and component paying for a tick function of its own. Each
+ * batch only ticks while it has something in it.
+ */
+UCLASS(config = Game)
+class SHOOTERPROJECT_API UBatchedTickSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UBatchedTickSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	void AddCharacter(AShooterProjectCharacter* Character);
+	void RemoveCharacter(AShooterProjectCharacter* Character);
+
+	void AddWeapon(AWeaponClass* Weapon);
+	void RemoveWeapon(AWeaponClass* Weapon);
+
+	void AddInteractionWidget(AShooterProjectPlayerController* PlayerController);
+	void RemoveInteractionWidget(AShooterProjectPlayerController* PlayerController);
+
+	int32 GetNum(const EBatchedTick Batch) const;
+
+	//How long the batch took the last time it ticked
+	FORCEINLINE double GetLastTickSeconds(const EBatchedTick Batch) const { return LastTickSeconds[(uint8)Batch]; };
+
+	void TickBatch(const EBatchedTick Batch, const float DeltaTime);
+
+protected:
+
+	UPROPERTY(Config)
+	FBatchedTickSettings CharacterTick;
+
+	UPROPERTY(Config)
+	FBatchedTickSettings WeaponTick;
+
+	UPROPERTY(Config)
+	FBatchedTickSettings InteractionWidgetTick;
+
+	UPROPERTY()
+	TArray<AShooterProjectCharacter*> Characters;
+
+	UPROPERTY()
+	TArray<AWeaponClass*> Weapons;
+
+	UPROPERTY()
+	TArray<AShooterProjectPlayerController*> InteractionWidgets;
+
+	FBatchedTickFunction TickFunctions[(uint8)EBatchedTick::MAX];
+
+	double LastTickSeconds[(uint8)EBatchedTick::MAX];
+
+	const FBatchedTickSettings& GetSettings(const EBatchedTick Batch) const;
+
+	//Registers the batch's tick function the first time it's needed, and only has it tick while the batch has something in it
+	void UpdateTickFunction(const EBatchedTick Batch);
+};
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CharacterSignificanceSubsystem.generated.h"
+
+class AShooterProjectCharacter;
+
+//How much a character matters to the local player, which decides how often its animation updates
+enum class ECharacterSignificance : uint8
+{
+	//Our own character, characters close by and the character we are looting or looking at. Always animates every frame.
+	Critical,
+	High,
+	Medium,
+	Low,
+
+	MAX
+};
+
+//How a significance tier drives the update rate optimizations of a character's body mesh
+USTRUCT()
+struct FSignificanceUpdateRate
+{
+	GENERATED_BODY()
+
+	/** Screen sizes below which the body mesh skips another frame between animation updates, largest first. The body
+	animates every N frames, where N is one more than the number of these it is smaller than. */
+	UPROPERTY(Config)
+	TArray<float> VisibleScreenSizeThresholds;
+
+	//The body animates every this many frames while it isn't being rendered
+	UPROPERTY(Config)
+	int32 NonRenderedUpdateRate = 4;
+};
+
+/**
+ * [Client] Works out how significant every character is to the local player, from their distance, their size on screen
+ * and whether we are interacting with them, and sets how often their animation updates from that.
+ */
+UCLASS(config = Game)
+class SHOOTERPROJECT_API UCharacterSignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UCharacterSignificanceSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	void RegisterCharacter(AShooterProjectCharacter* Character);
+	void UnregisterCharacter(AShooterProjectCharacter* Character);
+
+	const FSignificanceUpdateRate& GetUpdateRate(const ECharacterSignificance Significance) const;
+
+	//Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	//End FTickableGameObject
+
+protected:
+
+	//Characters closer than this are always critical
+	UPROPERTY(Config)
+	float CriticalDistance;
+
+	//How much of the screen's height a character has to cover to be high or medium significance
+	UPROPERTY(Config)
+	float HighScreenSize;
+
+	UPROPERTY(Config)
+	float MediumScreenSize;
+
+	//How often we work out significance again
+	UPROPERTY(Config)
+	float UpdateInterval;
+
+	//Critical characters always animate every frame, so only the other tiers have update rates
+	UPROPERTY(Config)
+	FSignificanceUpdateRate HighUpdateRate;
+
+	UPROPERTY(Config)
+	FSignificanceUpdateRate MediumUpdateRate;
+
+	UPROPERTY(Config)
+	FSignificanceUpdateRate LowUpdateRate;
+
+	FSignificanceUpdateRate CriticalUpdateRate;
+
+	ECharacterSignificance CalculateSignificance(const AShooterProjectCharacter* Character, const FVector& ViewLocation, const float ScreenSizeScale, const AShooterProjectCharacter* LocalCharacter) const;
+
+	TArray<TWeakObjectPtr<AShooterProjectCharacter>> Characters;
+
+	float TimeSinceUpdate;
+};
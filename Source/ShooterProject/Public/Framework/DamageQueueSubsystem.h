@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "DamageQueueSubsystem.generated.h"
+
+class AShooterProjectCharacter;
+
+/**
+ * [Server] Collects all the damage characters take during a frame and applies it in one go at the end of the frame.
+ * Every victim gets their armor applied in one pass, their health changed once and their death handled once, and every
+ * player that hit them gets one hit marker for the frame naming the victim, however many pellets or explosions were involved.
+ */
+UCLASS()
+class SHOOTERPROJECT_API UDamageQueueSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	//[Server] Queue damage to be applied to a character at the end of the frame
+	void QueueDamage(AShooterProjectCharacter* Victim, const float Damage, const struct FDamageEvent& DamageEvent, AController* EventInstigator, AActor* DamageCauser);
+
+	//Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	//End FTickableGameObject
+
+protected:
+
+	struct FPendingDamage
+	{
+		TWeakObjectPtr<AShooterProjectCharacter> Victim;
+		TWeakObjectPtr<AController> EventInstigator;
+		TWeakObjectPtr<AActor> DamageCauser;
+		TSubclassOf<class UDamageType> DamageTypeClass;
+		FName HitBone;
+		float Damage;
+	};
+
+	/** Apply all the damage one victim took this frame.
+	@param First index of the victims first pending damage
+	@param Last index after the victims last pending damage */
+	void ApplyVictimDamage(AShooterProjectCharacter* Victim, const int32 First, const int32 Last);
+
+	TArray<FPendingDamage> PendingDamage;
+
+	//Damage each instigator dealt to the victim being applied, so we can send one hit marker per pair
+	TArray<TPair<AController*, float>, TInlineAllocator<8>> InstigatorDamage;
+};
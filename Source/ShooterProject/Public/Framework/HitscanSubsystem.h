@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "HitscanSubsystem.generated.h"
+
+class AWeaponClass;
+
+/**
+ * [Server] Collects every hitscan shot fired during a frame and traces them all in one pass at the end of the frame.
+ * Each weapon then gets a single batch of results to send to clients, instead of a replicated actor per bullet.
+ */
+UCLASS()
+class SHOOTERPROJECT_API UHitscanSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	//[Server] Queue a shot to be traced with the rest of this frame's shots
+	void QueueShot(AWeaponClass* Weapon, const FVector& Start, const FVector& End);
+
+	//Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	//End FTickableGameObject
+
+protected:
+
+	struct FPendingShot
+	{
+		TWeakObjectPtr<AWeaponClass> Weapon;
+		FVector Start;
+		FVector End;
+	};
+
+	TArray<FPendingShot> PendingShots;
+};
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class AShooterProjectCharacter;
+
+DECLARE_STATS_GROUP(TEXT("Combat"), STATGROUP_Combat, STATCAT_Advanced);
+
+/**
+ * [Server] Records where every character's capsule and hitboxes were over the last moments, so hits that clients report
+ * can be checked against what the client actually saw instead of where the target is on the server right now.
+ * Rewinding reads the history into a scratch pose and tests the sweep against that, so the live world is never touched.
+ * Hitboxes need a character's bones to be refreshed, which dedicated servers otherwise skip, so they are only recorded
+ * while another character is close enough to hit them. Frames without hitboxes are checked against the capsule.
+ */
+UCLASS(config = Game)
+class SHOOTERPROJECT_API ULagCompensationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	ULagCompensationSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	void RegisterCharacter(AShooterProjectCharacter* Character);
+	void UnregisterCharacter(AShooterProjectCharacter* Character);
+
+	/** Check a sphere sweep a client says hit a character, against where that character was at the clients time.
+	@param Timestamp the servers world time as seen by the client when it did the sweep
+	@param HitBone the bone the client says it hit. If none, any hitbox counts.
+	@return true if the sweep would have hit the character at that time */
+	bool ValidateSweep(const AShooterProjectCharacter* Target, const FVector& TraceStart, const FVector& TraceEnd, const float SweepRadius, const float Timestamp, const FName HitBone = NAME_None) const;
+
+	//Whether we record per bone hitboxes as well as the capsule. Hitboxes need the server to keep characters bones up to date.
+	FORCEINLINE bool IsRecordingHitboxes() const { return bRecordHitboxes; };
+
+	//Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	//End FTickableGameObject
+
+protected:
+
+	//How many frames of history we keep for each character
+	UPROPERTY(Config)
+	int32 HistoryFrames;
+
+	//We never rewind further back than this, however laggy the client is
+	UPROPERTY(Config)
+	float MaxRewindTime;
+
+	//Extra distance we allow between the sweep and a hitbox, to cover interpolation on the client
+	UPROPERTY(Config)
+	float HitTolerance;
+
+	UPROPERTY(Config)
+	bool bRecordHitboxes;
+
+	//Characters only refresh their bones for hitboxes while another character is this close. Zero always refreshes them.
+	UPROPERTY(Config)
+	float HitboxRecordRadius;
+
+	/** The poses of one character as a ring buffer. Each field lives in its own array so a rewind only reads the data
+	it needs. Hitbox arrays hold NumHitboxes entries per frame, one frame after the other. */
+	struct FPoseHistory
+	{
+		TWeakObjectPtr<AShooterProjectCharacter> Character;
+
+		//Slot the newest frame was written to, and how many frames are valid
+		int32 Head = INDEX_NONE;
+		int32 NumFrames = 0;
+
+		float CapsuleRadius = 0.f;
+		float CapsuleHalfHeight = 0.f;
+
+		//Whether the character's bones are being refreshed for us, so this frame's hitboxes can be recorded
+		bool bRefreshingPose = false;
+
+		//Shape of each hitbox. These don't change, so they're only stored once.
+		TArray<int32> HitboxBoneIndices;
+		TArray<FName> HitboxBoneNames;
+		TArray<FVector> HitboxLocalCenters;
+		TArray<FVector> HitboxLocalAxes;
+		TArray<float> HitboxRadii;
+		TArray<float> HitboxHalfLengths;
+
+		TArray<float> Timestamps;
+		TArray<bool> HitboxesRecorded;
+		TArray<FVector> CapsuleLocations;
+		TArray<FVector> CapsuleAxes;
+		TArray<FVector> HitboxCenters;
+		TArray<FVector> HitboxAxes;
+
+		FORCEINLINE int32 NumHitboxes() const { return HitboxBoneIndices.Num(); };
+	};
+
+	void InitializeHistory(FPoseHistory& History, AShooterProjectCharacter* Character) const;
+	void RecordPose(FPoseHistory& History, const float Timestamp) const;
+
+	//Have characters refresh their bones only while another character is within HitboxRecordRadius of them
+	void UpdatePoseRefresh();
+
+	/** Find the two frames around a timestamp. Returns false if we have no history.
+	@param OutAlpha how far between the older and newer frame the timestamp is */
+	bool FindFrames(const FPoseHistory& History, const float Timestamp, int32& OutOlder, int32& OutNewer, float& OutAlpha) const;
+
+	TArray<FPoseHistory> Histories;
+
+	TMap<const AShooterProjectCharacter*, int32> HistoryIndices;
+};
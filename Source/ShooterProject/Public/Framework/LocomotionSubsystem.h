@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LocomotionSubsystem.generated.h"
+
+class AShooterProjectCharacter;
+struct FCharacterLocomotion;
+
+/**
+ * Locomotion inputs and results for every character, stored as one array per field so they can be worked out four
+ * characters at a time. The arrays are always padded to a multiple of four with zeroed entries.
+ */
+struct SHOOTERPROJECT_API FLocomotionBuffer
+{
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> VelocityZ;
+
+	//Degrees, like FRotator
+	TArray<float> Yaw;
+
+	//The character's EMovementMode
+	TArray<float> MovementMode;
+
+	TArray<float> Speed;
+
+	//Degrees from the way the character is facing to the way it is moving, -180 to 180. Zero while standing still.
+	TArray<float> Direction;
+
+	//1 while falling, 0 otherwise
+	TArray<float> InAir;
+
+	//Resize for this many characters, zeroing everything
+	void SetNum(const int32 NewNum);
+
+	void Set(const int32 Index, const FVector& Velocity, const float InYaw, const uint8 InMovementMode);
+
+	//Work out speed, direction and whether we're in the air for every character
+	void Compute();
+
+	FCharacterLocomotion GetLocomotion(const int32 Index) const;
+
+	FORCEINLINE int32 Num() const { return NumCharacters; };
+
+private:
+
+	int32 NumCharacters = 0;
+};
+
+//Runs the locomotion pass once every registered character has moved for the frame
+USTRUCT()
+struct FLocomotionTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	class ULocomotionSubsystem* Subsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRefOrdered& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FLocomotionTickFunction> : public TStructOpsTypeTraitsBase2<FLocomotionTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Works out the locomotion values every character's anim instance needs in one pass and hands each character its
+ * results. The pass ticks in TG_PrePhysics after every registered character's movement component and before their
+ * meshes, so it reads this frame's velocity and movement mode, the same frame the anim instance proxy copies.
+ */
+UCLASS()
+class SHOOTERPROJECT_API ULocomotionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	void RegisterCharacter(AShooterProjectCharacter* Character);
+	void UnregisterCharacter(AShooterProjectCharacter* Character);
+
+	void UpdateLocomotion();
+
+protected:
+
+	TArray<TWeakObjectPtr<AShooterProjectCharacter>> Characters;
+
+	FLocomotionBuffer Buffer;
+
+	FLocomotionTickFunction LocomotionTick;
+};
@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/ObjectKey.h"
+#include "MeshMergeSubsystem.generated.h"
+
+class AShooterProjectCharacter;
+
+DECLARE_STATS_GROUP(TEXT("Characters"), STATGROUP_Characters, STATCAT_Advanced);
+
+//Everything that goes into a merged mesh, each part's mesh followed by the material shown on each of its sections
+struct FMeshMergeKey
+{
+	TArray<FObjectKey> Objects;
+
+	FORCEINLINE bool operator==(const FMeshMergeKey& Other) const { return Objects == Other.Objects; };
+
+	friend FORCEINLINE uint32 GetTypeHash(const FMeshMergeKey& Key)
+	{
+		uint32 Hash = 0;
+
+		for (const FObjectKey& Object : Key.Objects)
+		{
+			Hash = HashCombine(Hash, GetTypeHash(Object));
+		}
+
+		return Hash;
+	}
+};
+
+/**
+ * [Client] Merges a character's body and gear meshes into one skeletal mesh, so players that are far away only cost one
+ * skinned component instead of one per gear slot. Merged meshes are cached by the meshes and materials that went into
+ * them, so every character wearing the same gear shares one merged mesh. A merged mesh is released once no character
+ * has worn its gear for a while.
+ */
+UCLASS(config = Game)
+class SHOOTERPROJECT_API UMeshMergeSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UMeshMergeSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	FORCEINLINE bool IsMergingEnabled() const { return bMergeCharacterMeshes; };
+
+	/** Ask for a merged mesh of these parts. If it hasn't been merged yet, it is given to the character with
+	SetMergedMesh once it has been.
+	@param Parts the first part's skeleton is used for the merged mesh
+	@param OutHash the hash of the parts, the character should only accept a merged mesh with this hash
+	@return the merged mesh if we already have it. Null for parts that can't be merged, like two parts showing different
+	materials over the same base material. */
+	class USkeletalMesh* RequestMergedMesh(AShooterProjectCharacter* Character, const TArray<class USkeletalMeshComponent*>& Parts, uint32& OutHash);
+
+	void UnregisterCharacter(AShooterProjectCharacter* Character);
+
+	//Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	//End FTickableGameObject
+
+protected:
+
+	//Merging is optional, since source meshes need CPU access enabled on their LODs to be merged
+	UPROPERTY(Config)
+	bool bMergeCharacterMeshes;
+
+	//Characters further than this from the camera show their merged mesh
+	UPROPERTY(Config)
+	float MergeDistance;
+
+	//Merging has to happen on the game thread, so we spread merges out over frames
+	UPROPERTY(Config)
+	int32 MaxMergesPerFrame;
+
+	//How often we check which characters should show their merged mesh
+	UPROPERTY(Config)
+	float DistanceCheckInterval;
+
+	//Seconds a merged mesh is kept after the last character wearing its gear stopped, in case someone puts it on again
+	UPROPERTY(Config)
+	float UnusedMergedMeshLifetime;
+
+	struct FMergeRequest
+	{
+		FMeshMergeKey Key;
+		uint32 Hash;
+		TArray<class USkeletalMesh*> SourceMeshes;
+
+		//The material each base material shows as on the merged mesh, whether or not a part overrides it
+		TArray<TPair<class UMaterialInterface*, class UMaterialInterface*>> MaterialOverrides;
+
+		TArray<TWeakObjectPtr<AShooterProjectCharacter>> Characters;
+	};
+
+	struct FCachedMergedMesh
+	{
+		//Null if the merge failed. Dropped with the rest of the entry once it's unused, so the gear gets another try.
+		class USkeletalMesh* Mesh = nullptr;
+		float LastUsedTime = 0.f;
+	};
+
+	struct FMergedCharacter
+	{
+		TWeakObjectPtr<AShooterProjectCharacter> Character;
+		FMeshMergeKey Key;
+	};
+
+	class USkeletalMesh* MergeMeshes(const FMergeRequest& Request) const;
+
+	void UpdateMergedCharacters();
+
+	//Drop merged meshes no character has worn for UnusedMergedMeshLifetime
+	void ReleaseUnusedMergedMeshes();
+
+	TMap<FMeshMergeKey, FCachedMergedMesh> MergedMeshes;
+
+	TArray<FMergeRequest> PendingMerges;
+
+	//Characters that have asked for a merged mesh and the gear they asked for, so we can swap them to it when they are far away
+	TArray<FMergedCharacter> MergedCharacters;
+
+	float TimeSinceDistanceCheck;
+};
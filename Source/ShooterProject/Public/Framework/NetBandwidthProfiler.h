@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class ENetBandwidthCategory : uint8
+{
+	//Everything actor channels send except RPCs, by actor class. Includes the actor's subobjects.
+	ActorClass,
+
+	//Replicated subobjects such as inventory items, by class. Already counted in their actor's class.
+	Subobject,
+
+	//RPCs sent, by function. Multicasts count once per connection they go to, including unreliable ones that are queued
+	//and sent inside the actor's next update.
+	RPC,
+
+	//Everything actor channels receive, by actor class. Client moves show up here on the server.
+	Received,
+
+	MAX
+};
+
+struct FNetBandwidthStat
+{
+	int64 Bits = 0;
+	int32 Count = 0;
+};
+
+/**
+ * [Server] Adds up how many bits are sent and received for each actor class, subobject class and RPC while it is running,
+ * so replication changes can be measured. Fed by UShooterNetDriver and UShooterActorChannel, and does nothing until
+ * started with net.BandwidthProfile start.
+ */
+class SHOOTERPROJECT_API FNetBandwidthProfiler
+{
+public:
+
+	static FNetBandwidthProfiler& Get();
+
+	void Start();
+	void Stop();
+	void Reset();
+
+	FORCEINLINE bool IsEnabled() const { return bEnabled; };
+
+	FORCEINLINE void Track(const ENetBandwidthCategory Category, const FName Name, const int64 Bits)
+	{
+		if (bEnabled)
+		{
+			FNetBandwidthStat& Stat = Stats[(uint8)Category].FindOrAdd(Name);
+			Stat.Bits += Bits;
+			++Stat.Count;
+		}
+	}
+
+	//How long we've been counting for, not including time we were stopped
+	double GetElapsedSeconds() const;
+
+	/** Write every stat to a CSV file, with per second rates.
+	@return false if the file couldn't be written */
+	bool WriteCSV(const FString& Filename) const;
+
+	//Log the biggest few entries of each category
+	void LogTopOffenders(const int32 NumPerCategory) const;
+
+	//The RPC being sent right now. Bunches sent while this is set are counted against the RPC instead of its actor.
+	FName CurrentRPC;
+
+private:
+
+	TMap<FName, FNetBandwidthStat> Stats[(uint8)ENetBandwidthCategory::MAX];
+
+	double StartTime = 0.0;
+	double ElapsedSecondsBeforeStart = 0.0;
+	bool bEnabled = false;
+};
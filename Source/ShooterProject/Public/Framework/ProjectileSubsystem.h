@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ProjectileSubsystem.generated.h"
+
+class AWeaponClass;
+
+/**
+ * Every in-flight projectile, stored as one array per field so flight can be integrated four projectiles at a time.
+ * The arrays are always padded to a multiple of four with zeroed entries, so the vector loop never needs a scalar tail.
+ */
+struct SHOOTERPROJECT_API FProjectileBuffer
+{
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+
+	//Where each projectile was before the last Integrate, the segment from here to Position is what we trace
+	TArray<float> StartX;
+	TArray<float> StartY;
+	TArray<float> StartZ;
+
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> VelocityZ;
+
+	TArray<float> Drag;
+	TArray<float> Lifetime;
+
+	//Only read when a projectile hits something
+	TArray<TWeakObjectPtr<AWeaponClass>> Weapons;
+
+	int32 Add(AWeaponClass* Weapon, const FVector& Origin, const FVector& Velocity, const float InDrag, const float InLifetime);
+	void RemoveAtSwap(const int32 Index);
+	void Empty();
+
+	/** Move every projectile forward under gravity and quadratic drag (drag acceleration is -Drag * |v| * v).
+	Uses semi-implicit euler, so velocity is updated first and then used to move. */
+	void Integrate(const float DeltaTime, const float GravityZ);
+
+	FORCEINLINE int32 Num() const { return NumProjectiles; };
+
+	FORCEINLINE FVector GetStart(const int32 Index) const { return FVector(StartX[Index], StartY[Index], StartZ[Index]); };
+	FORCEINLINE FVector GetPosition(const int32 Index) const { return FVector(PositionX[Index], PositionY[Index], PositionZ[Index]); };
+	FORCEINLINE FVector GetVelocity(const int32 Index) const { return FVector(VelocityX[Index], VelocityY[Index], VelocityZ[Index]); };
+
+private:
+
+	int32 NumProjectiles = 0;
+};
+
+/**
+ * [Server] Flies ballistic projectiles without an actor per bullet. Each frame integrates all projectiles, then traces
+ * only the distance each one moved this frame. Hits go through ApplyPointDamage like every other weapon hit.
+ * Rounds fired during a frame are sent to clients as one batch per weapon, like hitscan shots.
+ */
+UCLASS()
+class SHOOTERPROJECT_API UProjectileSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	//[Server] Start flying a projectile fired by a weapon
+	void SpawnProjectile(AWeaponClass* Weapon, const FVector& Origin, const FVector& Velocity, const float Drag, const float Lifetime);
+
+	/** Trace every projectile from where it started this step to where it is now, and remove the ones that hit something or ran out of time.
+	@param bApplyDamage if false, hits still stop projectiles but don't damage anything (used by benchmarks) */
+	void TraceProjectiles(FProjectileBuffer& Buffer, const bool bApplyDamage) const;
+
+	FORCEINLINE int32 GetNumProjectiles() const { return Projectiles.Num(); };
+
+	//Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	//End FTickableGameObject
+
+protected:
+
+	//Group the rounds fired this frame by weapon and hand each weapon its batch to send to clients
+	void SendFiredProjectiles();
+
+	FProjectileBuffer Projectiles;
+
+	struct FFiredProjectile
+	{
+		TWeakObjectPtr<AWeaponClass> Weapon;
+		FVector Origin;
+		FVector Velocity;
+	};
+
+	TArray<FFiredProjectile> FiredProjectiles;
+};
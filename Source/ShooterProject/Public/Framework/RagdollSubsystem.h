@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "RagdollSubsystem.generated.h"
+
+class AShooterProjectCharacter;
+
+/**
+ * Keeps the number of dead characters simulating ragdoll physics within a budget. Once a ragdoll has settled, has been
+ * simulating for too long, or is far from the camera, its pose is frozen and it stops simulating and ticking. When too
+ * many characters die at once, the ragdolls that are moving the least are frozen to make room for new ones.
+ */
+UCLASS(config = Game)
+class SHOOTERPROJECT_API URagdollSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	URagdollSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	//Start a dead character's ragdoll, freezing other ragdolls if we're over the budget
+	void AddRagdoll(AShooterProjectCharacter* Character);
+
+	void RemoveRagdoll(AShooterProjectCharacter* Character);
+
+	FORCEINLINE int32 GetNumSimulatingRagdolls() const { return Ragdolls.Num(); };
+
+	//Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	//End FTickableGameObject
+
+protected:
+
+	UPROPERTY(Config)
+	int32 MaxSimulatingRagdolls;
+
+	//A ragdoll whose root is moving slower than this is counted as settling
+	UPROPERTY(Config)
+	float SettleSpeed;
+
+	//How long a ragdoll has to stay slow before we freeze it
+	UPROPERTY(Config)
+	float SettleTime;
+
+	//We freeze ragdolls after this long even if they never settle, like bodies stuck sliding down a slope
+	UPROPERTY(Config)
+	float MaxSimulationTime;
+
+	//Ragdolls further than this from the camera are frozen straight away
+	UPROPERTY(Config)
+	float FreezeDistance;
+
+	struct FRagdoll
+	{
+		TWeakObjectPtr<AShooterProjectCharacter> Character;
+		float SimulationTime = 0.f;
+		float SettledTime = 0.f;
+		float Speed = 0.f;
+	};
+
+	//Returns false if we have no camera, like on a dedicated server
+	bool GetViewLocation(FVector& OutViewLocation) const;
+
+	void FreezeRagdoll(const int32 Index);
+
+	TArray<FRagdoll> Ragdolls;
+};
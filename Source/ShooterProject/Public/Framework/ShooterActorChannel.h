@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/ActorChannel.h"
+#include "ShooterActorChannel.generated.h"
+
+/**
+ * Actor channel that reports every bunch it sends and receives to the bandwidth profiler. Set as the actor channel class
+ * of UShooterNetDriver in DefaultEngine.ini.
+ */
+UCLASS(transient)
+class SHOOTERPROJECT_API UShooterActorChannel : public UActorChannel
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual FPacketIdRange SendBunch(FOutBunch* Bunch, bool Merge) override;
+
+	//Bits of unreliable RPCs queued on this channel that were already counted against their RPC. They go out inside the
+	//actor's next update, so they are taken back off the actor class when that is sent and cleared after it. The net driver
+	//also trims this to what is really still queued before each replication pass, in case queued RPCs were dropped.
+	int64 QueuedRPCBits = 0;
+
+protected:
+
+	virtual void ReceivedBunch(FInBunch& Bunch) override;
+};
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IpNetDriver.h"
+#include "ShooterNetDriver.generated.h"
+
+/**
+ * The game net driver. Tells the bandwidth profiler which RPC is being sent, so the bunches it goes out in are counted
+ * against it. Unreliable multicasts are queued rather than sent, so what they queue on each connection is counted instead.
+ */
+UCLASS(transient, config = Engine)
+class SHOOTERPROJECT_API UShooterNetDriver : public UIpNetDriver
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+	virtual void ProcessRemoteFunction(class AActor* Actor, class UFunction* Function, void* Parameters, struct FOutParmRec* OutParms, struct FFrame* Stack, class UObject* SubObject = nullptr) override;
+};
@@ -6,13 +6,24 @@
 #include "GameFramework/GameModeBase.h"
 #include "ShooterProjectGameMode.generated.h"
 
-UCLASS(minimalapi)
+UCLASS(minimalapi, config=Game)
 class AShooterProjectGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	AShooterProjectGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	//Seed that all loot in this match is rolled from. Pass ?LootSeed=X on the URL to replay the loot of an earlier match.
+	FORCEINLINE int32 GetLootSeed() const { return LootSeed; };
+
+protected:
+
+	//Zero picks a random seed every match
+	UPROPERTY(Config, EditDefaultsOnly, Category = "Loot")
+	int32 LootSeed;
 };
 
 
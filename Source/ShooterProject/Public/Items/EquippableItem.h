@@ -20,7 +20,98 @@ enum class EEquippableSlot : uint8
 	EIS_Backpack UMETA(DisplayName = "Backpack"),
 	EIS_PrimaryWeapon UMETA(DisplayName = "Primary Weapon"),
 	EIS_SecondaryWeapon UMETA(DisplayName = "Secondary Weapon"), 
-	EIS_Throwable UMETA(DisplayName = "Throwable Item")
+	EIS_Throwable UMETA(DisplayName = "Throwable Item"),
+
+	EIS_MAX UMETA(Hidden)
+};
+
+/**
+ * Holds one element per equippable slot, looked up by indexing straight into an array with the slot. A bitmask of the
+ * slots in use lets us visit only those slots, in slot order. ElementType must be a pointer, null means the slot is empty.
+ */
+template<typename ElementType>
+class TEquippableSlotArray
+{
+public:
+
+	static constexpr int32 NumSlots = (int32)EEquippableSlot::EIS_MAX;
+	static_assert(NumSlots <= 16, "The occupied mask only has room for 16 slots");
+
+	FORCEINLINE ElementType operator[](const EEquippableSlot Slot) const { return Elements[(uint8)Slot]; };
+
+	FORCEINLINE bool Contains(const EEquippableSlot Slot) const { return (OccupiedMask >> (uint8)Slot) & 1; };
+
+	FORCEINLINE void Set(const EEquippableSlot Slot, ElementType Element)
+	{
+		Elements[(uint8)Slot] = Element;
+		OccupiedMask = (OccupiedMask & ~(1 << (uint8)Slot)) | ((uint16)(Element != nullptr) << (uint8)Slot);
+	}
+
+	FORCEINLINE void Remove(const EEquippableSlot Slot) { Set(Slot, nullptr); };
+
+	//One bit per slot, set if that slot has an element
+	FORCEINLINE uint16 GetOccupiedMask() const { return OccupiedMask; };
+
+	FORCEINLINE int32 Num() const { return FMath::CountBits(OccupiedMask); };
+
+	//Calls Function(Slot, Element) for every slot that has an element
+	template<typename FunctionType>
+	FORCEINLINE void ForEach(FunctionType Function) const
+	{
+		for (uint32 Mask = OccupiedMask; Mask; Mask &= Mask - 1)
+		{
+			const int32 Index = FMath::CountTrailingZeros(Mask);
+			Function((EEquippableSlot)Index, Elements[Index]);
+		}
+	}
+
+	void AddReferencedObjects(FReferenceCollector& Collector, const UObject* Referencer = nullptr)
+	{
+		for (uint32 Mask = OccupiedMask; Mask; Mask &= Mask - 1)
+		{
+			Collector.AddReferencedObject(Elements[FMath::CountTrailingZeros(Mask)], Referencer);
+		}
+	}
+
+	bool operator==(const TEquippableSlotArray& Other) const
+	{
+		return OccupiedMask == Other.OccupiedMask && FMemory::Memcmp(Elements, Other.Elements, sizeof(Elements)) == 0;
+	}
+
+	bool operator!=(const TEquippableSlotArray& Other) const { return !(*this == Other); };
+
+private:
+
+	ElementType Elements[NumSlots] = {};
+	uint16 OccupiedMask = 0;
+};
+
+/**
+ * The items a character has equipped. Replicates as the occupied slot mask followed by only the items in those slots.
+ */
+USTRUCT()
+struct FEquippedItemSlots
+{
+	GENERATED_BODY()
+
+	TEquippableSlotArray<class UEquippableItem*> Items;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	void AddStructReferencedObjects(FReferenceCollector& Collector) const;
+
+	bool operator==(const FEquippedItemSlots& Other) const { return Items == Other.Items; };
+};
+
+template<>
+struct TStructOpsTypeTraits<FEquippedItemSlots> : public TStructOpsTypeTraitsBase2<FEquippedItemSlots>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+		WithAddStructReferencedObjects = true
+	};
 };
 
 /**
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "Items/EquippableItem.h"
+
+/** How a gear slot looks with a piece of gear, or nothing, equipped. Shared by every character wearing the same thing.
+Only weakly references the mesh and materials, whoever is showing them keeps them loaded. */
+struct SHOOTERPROJECT_API FGearAppearance
+{
+	EEquippableSlot Slot;
+
+	TWeakObjectPtr<class USkeletalMesh> Mesh;
+
+	//The material the gear put on its mesh, if any
+	TWeakObjectPtr<class UMaterialInterface> Material;
+
+	//Goes onto the slot's mesh component. Null entries use the mesh's own material.
+	TArray<TWeakObjectPtr<class UMaterialInterface>> OverrideMaterials;
+};
+
+/**
+ * Every gear appearance that has been used, shared across all characters and worlds. Appearances are keyed by the slot and
+ * the mesh and material the gear uses, so characters wearing the same gear share one set of material overrides and
+ * equipping is a lookup instead of setting up the materials again. The cache doesn't keep meshes loaded, so gear meshes
+ * the asset streaming subsystem lets go of can be freed once nobody is wearing them.
+ */
+class SHOOTERPROJECT_API FGearAppearanceCache
+{
+public:
+
+	static FGearAppearanceCache& Get();
+
+	/** Find the appearance of a mesh and material in a slot, preparing it the first time it is asked for.
+	@param Material goes on the last material of the mesh, as gear materials always have */
+	const FGearAppearance* FindOrAdd(const EEquippableSlot Slot, class USkeletalMesh* Mesh, class UMaterialInterface* Material);
+
+	FORCEINLINE int32 Num() const { return Appearances.Num(); };
+
+private:
+
+	//Object keys rather than pointers, so a mesh that is freed and loaded again never matches its old appearance
+	typedef TTuple<EEquippableSlot, TObjectKey<class USkeletalMesh>, TObjectKey<class UMaterialInterface>> FAppearanceKey;
+
+	//Appearances are handed out as pointers, so each lives in its own allocation that never moves, and is never removed
+	TMap<FAppearanceKey, TUniquePtr<FGearAppearance>> Appearances;
+};
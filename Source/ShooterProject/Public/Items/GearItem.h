@@ -21,9 +21,9 @@ public:
 	virtual bool Equip(class AShooterProjectCharacter* Character) override;
 	virtual bool Unequip(class AShooterProjectCharacter* Character) override;
 
-	/**The skeletal mesh for this gear*/
+	/**The skeletal mesh for this gear. Streamed in when the gear is equipped*/
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Gear")
-	class USkeletalMesh* Mesh;
+	TSoftObjectPtr<class USkeletalMesh> Mesh;
 
 	/**Optional material instance to apply to the gear*/
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Gear")
@@ -32,4 +32,15 @@ public:
 	/**The amount of defence this item provides. 0.2 = 20% less damage*/
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Gear", meta = (ClampMin = 0.0, ClampMax = 1.0))
 	float DamageDefenceMultiplier;
+
+	/**The mesh if it has been streamed in, otherwise null*/
+	UFUNCTION(BlueprintPure, Category = "Gear")
+	class USkeletalMesh* GetMesh() const;
+
+	//How this gear looks when worn, shared with all other gear using the same mesh and material. Null until the mesh is loaded.
+	const struct FGearAppearance* GetAppearance() const;
+
+private:
+
+	mutable const struct FGearAppearance* CachedAppearance;
 };
@@ -6,6 +6,10 @@
 #include "UObject/NoExportTypes.h"
 #include "Item.generated.h"
 
+class UStaticMesh;
+class UTexture2D;
+enum class EAssetStreamPriority : uint8;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnItemModified);
 
 UCLASS(Blueprintable, EditInlineNew, DefaultToInstanced)
@@ -18,6 +22,8 @@ protected:
 	virtual void GetLifetimeReplicatedProps(TArray<class FLifetimeProperty> & OutLifetimeProps) const override;
 	virtual bool IsSupportedForNetworking() const override;
 
+	virtual void PostLoad() override;
+
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
@@ -26,9 +32,9 @@ public:
 
 	UItem();
 
-	/** The mesh to display for this item pickup */
+	/** The mesh to display for this item pickup. Streamed in by the pickup, so loading the item doesn't load the mesh */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item")
-	class UStaticMesh* PickupMesh;
+	TSoftObjectPtr<UStaticMesh> PickupMesh;
 
 	/** The display name for this item in the inventory */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item")
@@ -38,9 +44,14 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item", meta = (MultiLine = true))
 	FText ItemDescription;
 
-	/** The thumbnail for this item */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item")
-	class UTexture2D* Thumbnail;
+	/** The thumbnail for this item. Streamed in when the item is shown in the UI */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item", meta = (DisplayName = "Thumbnail"))
+	TSoftObjectPtr<UTexture2D> ThumbnailAsset;
+
+	/** The thumbnail once it has been streamed in by RequestThumbnail, null until then. Used to be the asset itself, so items
+	* saved before ThumbnailAsset have theirs moved over on load */
+	UPROPERTY(BlueprintReadWrite, Category = "Item")
+	UTexture2D* Thumbnail;
 
 	/** The text for using the item. (Equip, Eat, ect */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item")
@@ -92,9 +103,31 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Item")
 	virtual bool ShouldShowInInventory() const;
 
+	/**The thumbnail if it has been streamed in, otherwise null*/
+	UFUNCTION(BlueprintPure, Category = "Item")
+	UTexture2D* GetThumbnail() const;
+
+	/**
+	* Stream the thumbnail in, and set Thumbnail once it has loaded.
+	* @param OnLoaded Called once Thumbnail is set, straight away if it already is
+	*/
+	void RequestThumbnail(const EAssetStreamPriority Priority, FSimpleDelegate OnLoaded = FSimpleDelegate());
+
+	/**The display name and quantity, "Ammo x30". Cached per item class and quantity, so it's cheap to call on every refresh*/
+	UFUNCTION(BlueprintPure, Category = "Item")
+	FText GetQuantityText() const;
+
+	/**The weight of the stack, "4.5 kg". Cached per item class and quantity*/
+	UFUNCTION(BlueprintPure, Category = "Item")
+	FText GetStackWeightText() const;
+
 	virtual void Use(class AShooterProjectCharacter* Character);
 	virtual void AddedToInventory(class UInventoryComponent* Inventory);
 
 	/** Mark the object as needing replication. We must call this internally after modifying any replicated properties */
 	void MarkDirtyForReplication();
+
+protected:
+
+	void OnThumbnailLoaded(FSimpleDelegate OnLoaded);
 };
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "Components/InventoryComponent.h"
+
+/**
+ * Formatted text for each item class, so tooltips, interaction widgets and inventory errors format their strings once
+ * instead of on every refresh. Quantity and weight texts are keyed by quantity too, so a quantity change just looks up
+ * another entry. Texts are built from the class defaults, so items whose name or weight was changed at runtime are
+ * formatted on every call instead. Each map is cleared when it gets too big, and everything is thrown away when the
+ * culture changes.
+ */
+class SHOOTERPROJECT_API FItemTextCache
+{
+public:
+
+	static FItemTextCache& Get();
+
+	~FItemTextCache();
+
+	//Why an item couldn't be added, naming the item where the message needs it
+	FText GetAddErrorText(const EItemAddError Error, TSubclassOf<class UItem> ItemClass);
+
+	//The item's name followed by its quantity, "Ammo x30"
+	FText GetQuantityText(const class UItem* Item);
+
+	//The weight of the whole stack, "4.5 kg"
+	FText GetWeightText(const class UItem* Item);
+
+	FORCEINLINE int32 Num() const { return ErrorTexts.Num() + QuantityTexts.Num() + WeightTexts.Num(); };
+
+	void Empty();
+
+private:
+
+	FItemTextCache();
+
+	typedef TTuple<EItemAddError, FObjectKey> FErrorKey;
+	typedef TTuple<FObjectKey, int32> FQuantityKey;
+
+	//Keyed with FObjectKey so the cache doesn't keep item classes loaded
+	TMap<FErrorKey, FText> ErrorTexts;
+	TMap<FQuantityKey, FText> QuantityTexts;
+	TMap<FQuantityKey, FText> WeightTexts;
+};
@@ -19,6 +19,17 @@ enum class EWeaponState : uint8
 	UNEQUIPPING			UMETA(DisplayName = "Unequipping")
 };
 
+UENUM(BlueprintType)
+enum class EWeaponFireMode : uint8
+{
+	//Spawns ProjectileClass at the muzzle for every shot
+	Projectile			UMETA(DisplayName = "Projectile"),
+	//Shots are instant traces done by the server
+	Hitscan				UMETA(DisplayName = "Hitscan"),
+	//Shots fly under gravity and drag, simulated by the server without an actor per bullet
+	Ballistic			UMETA(DisplayName = "Ballistic")
+};
+
 USTRUCT(BlueprintType)
 struct FWeaponData
 {
@@ -28,13 +39,13 @@ struct FWeaponData
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = GeneralConfig)
 	int InventorySlotID;
 
-	//Inventory GUI Image
+	//Inventory GUI Image. Streamed in when the weapon is equipped by the local player
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ItemConfig)
-	UTexture2D* ThumbnailNormal;
+	TSoftObjectPtr<UTexture2D> ThumbnailNormal;
 
 	//Inventory GUI Image
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = ItemConfig)
-	UTexture2D* ThumbnailHover;
+	TSoftObjectPtr<UTexture2D> ThumbnailHover;
 
 	//Name of the Item
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = GeneralConfig)
@@ -77,6 +88,76 @@ struct FWeaponData
 	int32 MagazineSize;
 };
 
+//Where a single hitscan shot ended up. Normals are only sent for shots that hit something.
+USTRUCT(BlueprintType)
+struct FHitscanImpact
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = Weapon)
+	FVector_NetQuantize Location;
+
+	UPROPERTY(BlueprintReadOnly, Category = Weapon)
+	FVector_NetQuantizeNormal Normal;
+
+	UPROPERTY(BlueprintReadOnly, Category = Weapon)
+	uint8 bBlockingHit : 1;
+
+	FHitscanImpact()
+		: bBlockingHit(false)
+	{}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FHitscanImpact> : public TStructOpsTypeTraitsBase2<FHitscanImpact>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+//All the hitscan shots a weapon fired in one server frame, sent to clients in one go so they can play tracers and impacts
+USTRUCT(BlueprintType)
+struct FHitscanShotsFired
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = Weapon)
+	FVector_NetQuantize Origin;
+
+	UPROPERTY(BlueprintReadOnly, Category = Weapon)
+	TArray<FHitscanImpact> Impacts;
+};
+
+//All the ballistic rounds a weapon fired in one server frame, sent to clients in one go so they can play muzzle flashes and tracers
+USTRUCT(BlueprintType)
+struct FBallisticShotsFired
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = Weapon)
+	FVector_NetQuantize Origin;
+
+	UPROPERTY(BlueprintReadOnly, Category = Weapon)
+	TArray<FVector_NetQuantize10> Velocities;
+};
+
+/** Keeps automatic fire at exactly one shot per TimeBetweenShots whatever the frame rate. Shots are owed from the time
+the last one was due rather than when the frame happened, so a long frame fires several shots and short ones fire none. */
+struct FWeaponFireTimer
+{
+	double NextShotTime = 0.0;
+
+	//Start a burst. A burst can never start before the last one's cooldown is over, but it never owes shots from while we weren't firing.
+	FORCEINLINE void Start(const double Now) { NextShotTime = FMath::Max(NextShotTime, Now); };
+
+	FORCEINLINE bool IsShotDue(const double Now) const { return NextShotTime <= Now; };
+	FORCEINLINE void ShotFired(const float TimeBetweenShots) { NextShotTime += TimeBetweenShots; };
+};
+
 //Montage Struct used for Weapon related Pawn Animations 
 USTRUCT()
 struct FWeaponAnim
@@ -119,13 +200,163 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
 	TSubclassOf<AActor> ProjectileClass;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = Weapon)
 	FWeaponData WeaponData;
 
+	//The item reloading takes from our owners inventory. If none, reloading is free.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	TSubclassOf<class UItem> AmmoClass;
+
+	//How long a reload takes if there is no reload animation
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	float ReloadDuration;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	EWeaponFireMode FireMode;
+
+	//How far hitscan shots can reach
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Hitscan, meta = (EditCondition = "FireMode == EWeaponFireMode::Hitscan"))
+	float HitscanRange;
+
+	//Damage dealt by each hitscan or ballistic shot
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon, meta = (EditCondition = "FireMode != EWeaponFireMode::Projectile"))
+	float ShotDamage;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon, meta = (EditCondition = "FireMode != EWeaponFireMode::Projectile"))
+	TSubclassOf<class UDamageType> ShotDamageType;
+
+	//Speed ballistic rounds leave the muzzle at, in cm/s
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistic, meta = (EditCondition = "FireMode == EWeaponFireMode::Ballistic"))
+	float MuzzleVelocity;
+
+	//How quickly air slows ballistic rounds down. Drag acceleration is this times speed squared.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistic, meta = (EditCondition = "FireMode == EWeaponFireMode::Ballistic"))
+	float ProjectileDrag;
+
+	//Seconds a ballistic round flies before it is removed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistic, meta = (EditCondition = "FireMode == EWeaponFireMode::Ballistic"))
+	float ProjectileLifetime;
+
 public:
 
+	//Pull and release the trigger for a single shot. Goes through the same ammo, fire rate and server checks as held fire.
 	UFUNCTION(BlueprintCallable, Category = "Weapon")
 	virtual void Fire();
+
+	//[Local] Pull and release the trigger. Shots are predicted locally, the server runs the same burst and owns the ammo.
+	void StartFire();
+	void StopFire();
+
+	//[Local] Reload if we have room in the magazine and ammo to put in it
+	void StartReload();
+
+	//Called on every machine when a character takes this weapon out or puts it away
+	void OnEquip(class AShooterProjectCharacter* NewOwner);
+	void OnUnequip();
+
+	UFUNCTION(BlueprintPure, Category = "Weapon")
+	FORCEINLINE EWeaponState GetCurrentState() const { return CurrentState; };
+
+	UFUNCTION(BlueprintPure, Category = "Weapon")
+	bool CanFire() const;
+
+	UFUNCTION(BlueprintPure, Category = "Weapon")
+	bool CanReload() const;
+
+	//The inventory images if they have been streamed in, otherwise null
+	UFUNCTION(BlueprintPure, Category = "Weapon")
+	UTexture2D* GetThumbnailNormal() const;
+
+	UFUNCTION(BlueprintPure, Category = "Weapon")
+	UTexture2D* GetThumbnailHover() const;
+
+	//Called as each of our thumbnails streams in
+	void OnThumbnailLoaded();
+
+	//How much ammo is left in our owners inventory
+	UFUNCTION(BlueprintPure, Category = "Weapon")
+	int32 GetInventoryAmmo() const;
+
+	//[Server] Called by the hitscan subsystem once it has traced all the shots we fired this frame
+	void OnHitscanShotsResolved(const FHitscanShotsFired& ShotsFired);
+
+	//[Server] Called by the projectile subsystem with every ballistic round we fired this frame
+	void OnBallisticShotsFired(const FBallisticShotsFired& ShotsFired);
+
+protected:
+
+	UFUNCTION(Server, Reliable)
+	void ServerStartFire();
+
+	/** End a burst on the server.
+	@param ClientBurstShots how many shots the client fired in the burst. The server fires any of these that are due on its own fire timer but haven't gone off yet. */
+	UFUNCTION(Server, Reliable)
+	void ServerStopFire(const uint16 ClientBurstShots);
+
+	UFUNCTION(Server, Reliable)
+	void ServerStartReload();
+
+	//Work out which state we should be in from what we want to do, and switch to it
+	void DetermineWeaponState();
+	void SetWeaponState(const EWeaponState NewState);
+
+	//Fire every shot that is due this frame
+	void HandleFiring();
+
+	//Spend a round and fire it. Only the server actually traces or spawns anything.
+	void FireShot();
+
+	//Move ammo from the inventory into the magazine once the reload is done
+	void FinishReload();
+	void FinishEquip();
+	void FinishUnequip();
+
+	//Play a montage on our owner and return how long it is, or Fallback if there is none
+	float PlayPawnAnimation(const FWeaponAnim& Animation, const float Fallback = 0.f);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Weapon")
+	void PlayFireEffects();
+
+	UPROPERTY(Transient)
+	class AShooterProjectCharacter* OwningCharacter;
+
+	EWeaponState CurrentState;
+
+	FWeaponFireTimer FireTimer;
+
+	//Shots fired since the trigger was pulled, and when that was
+	int32 BurstShots;
+	float BurstStartTime;
+
+	uint8 bWantsToFire : 1;
+	uint8 bPendingReload : 1;
+	uint8 bPendingEquip : 1;
+	uint8 bPendingUnequip : 1;
+
+	FTimerHandle TimerHandle_Reload;
+	FTimerHandle TimerHandle_Equip;
+
+	//[Server] Queue a trace from the muzzle along where our owner is aiming
+	void FireHitscan();
+
+	void FireProjectile();
+
+	//[Server] Hand a round to the projectile subsystem to fly
+	void FireBallistic();
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastBallisticShotsFired(const FBallisticShotsFired& ShotsFired);
+
+	//Play muzzle flash and tracer for a ballistic round the server fired
+	UFUNCTION(BlueprintImplementableEvent, Category = "Weapon")
+	void OnProjectileFired(const FVector& Origin, const FVector& Velocity);
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastShotsFired(const FHitscanShotsFired& ShotsFired);
+
+	//Play tracers and impacts for shots the server traced
+	UFUNCTION(BlueprintImplementableEvent, Category = "Weapon")
+	void OnShotsFired(const FHitscanShotsFired& ShotsFired);
 	
 public:	
 	// Sets default values for this actor's properties
@@ -135,8 +366,9 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	//Firing weapons are ticked by the batched tick subsystem
+	friend class UBatchedTickSubsystem;
 };
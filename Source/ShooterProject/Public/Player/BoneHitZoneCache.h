@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "Items/EquippableItem.h"
+
+//The body slot of every bone in a mesh, by bone name so working out where a hit landed is a single lookup
+typedef TMap<FName, EEquippableSlot> FBoneHitZones;
+
+/**
+ * Which body slot every bone of a character mesh belongs to, shared across all characters and worlds. Hit zones only
+ * depend on the mesh and the character class's HitZoneBones, so characters of the same class and mesh share one table.
+ * Characters hold on to their own table, and entries for meshes or classes that have gone away are dropped whenever
+ * a new one is added.
+ */
+class SHOOTERPROJECT_API FBoneHitZoneCache
+{
+public:
+
+	static FBoneHitZoneCache& Get();
+
+	/** Find the hit zones of a mesh, working them out the first time they are asked for.
+	@param HitZoneBones the body slot of the listed bones. Bones that aren't listed belong to the same slot as their parent. */
+	TSharedPtr<const FBoneHitZones> FindOrAdd(const class USkeletalMesh* Mesh, const UClass* CharacterClass, const TMap<FName, EEquippableSlot>& HitZoneBones);
+
+	FORCEINLINE int32 Num() const { return HitZones.Num(); };
+
+private:
+
+	typedef TTuple<TObjectKey<class USkeletalMesh>, TObjectKey<UClass>> FHitZonesKey;
+
+	TMap<FHitZonesKey, TSharedPtr<const FBoneHitZones>> HitZones;
+};
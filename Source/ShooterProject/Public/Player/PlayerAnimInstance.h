@@ -4,8 +4,45 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
 #include "PlayerAnimInstance.generated.h"
 
+/**
+ * Fills in the player anim instance's values from its character on the game thread, before the anim graph is updated
+ * on a worker thread. The values are Blueprint readable, so they are only ever written here and never while the graph
+ * runs in parallel. Speed, direction and in-air come from the locomotion subsystem's batch pass, so there is little to do.
+ */
+USTRUCT()
+struct SHOOTERPROJECT_API FPlayerAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+public:
+
+	FPlayerAnimInstanceProxy()
+		: FAnimInstanceProxy()
+	{
+	}
+
+	FPlayerAnimInstanceProxy(UAnimInstance* InAnimInstance)
+		: FAnimInstanceProxy(InAnimInstance)
+	{
+	}
+
+protected:
+
+	virtual void Initialize(UAnimInstance* InAnimInstance) override;
+
+	//Game thread, copies the character state into the anim instance
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+private:
+
+	//Cached once, the character that owns our mesh never changes
+	class AShooterProjectCharacter* Character = nullptr;
+	class UPlayerAnimInstance* PlayerAnimInstance = nullptr;
+};
+
 /**
  * 
  */
@@ -44,19 +81,15 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation")
 	bool bIsProning;
 
-private:
-
-	float CalculateDirection(const FVector& PlayerVelocity, const FRotator& PlayerRotation) const;
-
 public:
 	UPlayerAnimInstance();
 
-	virtual void NativeInitializeAnimation() override;
+	//The scalar direction calculation, used when the locomotion subsystem hasn't given our character its results
+	static float CalculateDirection(const FVector& PlayerVelocity, const FRotator& PlayerRotation);
 
-	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+protected:
 
-private:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
 
-	UPROPERTY()
-	APawn* Owner;
+	friend struct FPlayerAnimInstanceProxy;
 };
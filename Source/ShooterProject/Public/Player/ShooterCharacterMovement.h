@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "ShooterCharacterMovement.generated.h"
+
+enum class EPawnStates : uint8;
+
+/**
+ * Character movement with sprinting and going prone. Both are sent to the server in the compressed flags of every saved
+ * move, so the owning client predicts them and the server replays them exactly like crouching, with no extra RPCs.
+ * Prone is a lower crouch: it uses the crouch code to shrink the capsule, just to ProneHalfHeight instead.
+ */
+UCLASS()
+class SHOOTERPROJECT_API UShooterCharacterMovement : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_Shooter;
+
+public:
+
+	UShooterCharacterMovement();
+
+	//Speed while sprinting on the ground
+	UPROPERTY(Category = "Character Movement: Walking", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float MaxWalkSpeedSprint;
+
+	UPROPERTY(Category = "Character Movement: Walking", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float MaxWalkSpeedProne;
+
+	//Capsule half height while prone. Can't be smaller than the capsule radius, so prone is as flat as our capsule gets.
+	UPROPERTY(Category = "Character Movement (General Settings)", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float ProneHalfHeight;
+
+	//Set the stance the player wants, we get into it on our next move if there is room
+	void SetWantedStance(const EPawnStates Stance);
+	EPawnStates GetWantedStance() const;
+
+	//The stance we are actually in
+	EPawnStates GetStance() const;
+
+	FORCEINLINE void SetWantsToSprint(const bool bNewWantsToSprint) { bWantsToSprint = bNewWantsToSprint; };
+	FORCEINLINE bool IsProne() const { return bIsProne; };
+	bool IsSprinting() const;
+
+	//Simulated proxies get their stance replicated from the server, this puts the capsule at the matching height
+	void SetSimulatedStance(const EPawnStates Stance);
+
+	//Corrections the server has sent us since ResetCorrectionCount
+	FORCEINLINE int32 GetNumCorrections() const { return NumCorrections; };
+	float GetCorrectionsPerMinute() const;
+	void ResetCorrectionCount();
+
+	//Begin UCharacterMovementComponent
+	virtual void InitializeComponent() override;
+	virtual float GetMaxSpeed() const override;
+	virtual bool CanAttemptJump() const override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual void ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode) override;
+	//End UCharacterMovementComponent
+
+protected:
+
+	virtual void OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity) override;
+
+	//The crouched half height we were set up with, CrouchedHalfHeight is swapped for ProneHalfHeight while prone
+	float StandardCrouchedHalfHeight;
+
+	uint8 bWantsToSprint : 1;
+	uint8 bWantsToProne : 1;
+	uint8 bIsProne : 1;
+
+	int32 NumCorrections;
+	float CorrectionCountStartTime;
+};
@@ -11,6 +11,8 @@
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnEquippedItemsChanged, const EEquippableSlot, Slot, const UEquippableItem*, Item);
 
 class AWeaponClass;
+enum class ECharacterSignificance : uint8;
+struct FSignificanceUpdateRate;
 
 //AnimBP States.
 UENUM(BlueprintType)
@@ -53,6 +55,20 @@ struct FInteractionData
 		bool bInteractHeld;
 };
 
+//What our anim instance needs to know about how we're moving, worked out for every character at once by the locomotion subsystem
+struct FCharacterLocomotion
+{
+	float Speed = 0.f;
+
+	//Degrees from the way we're facing to the way we're moving, -180 to 180
+	float Direction = 0.f;
+
+	bool bIsInAir = false;
+
+	//False until the locomotion subsystem has filled this in
+	bool bValid = false;
+};
+
 UCLASS(config=Game)
 class AShooterProjectCharacter : public ACharacter
 {
@@ -66,21 +82,34 @@ class AShooterProjectCharacter : public ACharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;
 
+	/** Our character movement component, cached so we don't have to cast it */
+	UPROPERTY()
+	class UShooterCharacterMovement* ShooterMovement;
+
 	/** Melee fist attack montage */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, meta = (AllowPrivateAccess = "true"))
 	class UAnimMontage* MeleeFistAttackMontage;
 
 public:
-	AShooterProjectCharacter();
+	AShooterProjectCharacter(const FObjectInitializer& ObjectInitializer);
+
+	FORCEINLINE class UShooterCharacterMovement* GetShooterMovement() const { return ShooterMovement; };
 
 	//The Mesh to have equipped if we don't have an item equipped - ie. the bare skin meshes.
-	UPROPERTY(BlueprintReadOnly, Category = Mesh)
-	TMap<EEquippableSlot, USkeletalMesh*> NakedMeshes;
+	TEquippableSlotArray<const struct FGearAppearance*> NakedAppearances;
+
+	//What each slot's mesh component is currently showing
+	TEquippableSlotArray<const struct FGearAppearance*> SlotAppearances;
 
 	//The players body meshes
+	TEquippableSlotArray<USkeletalMeshComponent*> SlotMeshes;
+
+	//The same body meshes as SlotMeshes, for blueprints
 	UPROPERTY(BlueprintReadOnly, Category = Mesh)
 	TMap<EEquippableSlot, USkeletalMeshComponent*> PlayerMeshes;
 
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
 	/**Modular character */
 	UPROPERTY(EditAnywhere, Category = "Components")
 	class USkeletalMeshComponent* HelmetMesh;
@@ -111,6 +140,15 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Looting")
 	bool IsLooting() const;
 
+	FORCEINLINE class UInventoryComponent* GetLootSource() const { return LootSource; };
+
+	//Called by the significance subsystem to set how often our animation updates
+	void SetSignificance(const ECharacterSignificance NewSignificance, const FSignificanceUpdateRate& UpdateRate);
+
+	//Called by the locomotion subsystem at the start of every frame, before our anim instance updates
+	FORCEINLINE void SetLocomotion(const FCharacterLocomotion& NewLocomotion) { Locomotion = NewLocomotion; };
+	FORCEINLINE const FCharacterLocomotion& GetLocomotion() const { return Locomotion; };
+
 
 protected:
 
@@ -155,16 +193,19 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
 	float BaseLookUpRate;
 
-	//The current stance of the player character
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Animation)
+	//The current stance of the player character, set by our movement component and replicated to simulated proxies
+	UPROPERTY(ReplicatedUsing = OnRep_CurrentState, VisibleAnywhere, BlueprintReadWrite, Category = Animation)
 	EPawnStates CurrentState = EPawnStates::STAND;
 
+	UFUNCTION()
+	void OnRep_CurrentState();
+
 	// Indicates whether the Player Character is running or not.
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	bool bIsRunning = false;
 
 	// Indicates whether the Player Character is sprinting or not.
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly)
 	bool bIsSprinting = false;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
@@ -216,6 +257,9 @@ public:
 	//Get the time till we interact with the current interactable
 	float GetRemainingInteractTime() const;
 
+	//Called by the batched tick subsystem every frame, checks for interactables when it's time to
+	void TickInteraction(float DeltaTime);
+
 	// Items
 
 	/**[Server] Use an item from our inventory*/
@@ -244,22 +288,81 @@ public:
 	void EquipGear(class UGearItem* Gear);
 	void UnequipGear(const EEquippableSlot Slot);
 
+	//Put a shared appearance on a slot's mesh component
+	void SetSlotAppearance(const EEquippableSlot Slot, const struct FGearAppearance* Appearance);
+
+	//Gear meshes are streamed in, so gear equipped before its mesh loaded is put on once it has
+	void OnGearMeshLoaded(TWeakObjectPtr<class UGearItem> Gear);
+
 
 	UPROPERTY(BlueprintAssignable, Category = "Items")
 	FOnEquippedItemsChanged OnEquippedItemsChanged;
 
+	//Broadcast OnEquippedItemsChanged for a slot that hasn't changed, so the hotbar picks up a thumbnail that has just streamed in
+	void RefreshEquippedSlot(const EEquippableSlot Slot);
+
 	UFUNCTION(BlueprintPure)
 	class USkeletalMeshComponent* GetSlotSkeletalMeshComponent(const EEquippableSlot Slot);
 
+	FORCEINLINE const TEquippableSlotArray<UEquippableItem*>& GetEquippedItemSlots() const { return EquippedItems.Items; };
+
+	//A copy of our equipped items for blueprints. Native code should use GetEquippedItemSlots or GetEquippedItem.
 	UFUNCTION(BlueprintPure)
-	FORCEINLINE TMap<EEquippableSlot, UEquippableItem*> GetEquippedItems() const { return EquippedItems; };
+	TMap<EEquippableSlot, UEquippableItem*> GetEquippedItems() const;
+
+	UFUNCTION(BlueprintPure)
+	FORCEINLINE UEquippableItem* GetEquippedItem(const EEquippableSlot Slot) const { return EquippedItems.Items[Slot]; };
+
+	//Called by the mesh merge subsystem once the merged mesh of our body and gear is ready
+	void SetMergedMesh(class USkeletalMesh* MergedMesh, const uint32 Hash);
+
+	//Show our merged mesh instead of our separate body and gear meshes. Does nothing until our merged mesh is ready.
+	void SetUseMergedMesh(bool bUseMergedMesh);
+
+	FORCEINLINE bool HasMergedMesh() const { return bMergedMeshReady; };
+	FORCEINLINE bool IsUsingMergedMesh() const { return bUsingMergedMesh; };
+
+	//[Server] Called by the lag compensation subsystem while someone is close enough that our hitboxes may need rewinding
+	void SetRecordingHitboxes(const bool bRecord);
 
 
 protected:
 
 	//Allows for efficient access of equipped item
-	UPROPERTY(VisibleAnywhere, Category = "Items")
-	TMap<EEquippableSlot, UEquippableItem*> EquippedItems;
+	UPROPERTY(ReplicatedUsing = OnRep_EquippedItems)
+	FEquippedItemSlots EquippedItems;
+
+	//Swap gear meshes on clients for the slots that changed
+	UFUNCTION()
+	void OnRep_EquippedItems(const FEquippedItemSlots& PreviousEquippedItems);
+
+	//Ask for our body and gear meshes to be merged into one, if mesh merging is turned on
+	void RequestMergedMesh();
+
+	//Our body and gear merged into one mesh, shown instead of them when we're far away. Only created if merging is used.
+	UPROPERTY(Transient)
+	class USkeletalMeshComponent* MergedMeshComponent;
+
+	//Hash of the meshes we last asked to be merged, so we ignore merges of gear we've since changed
+	uint32 MergedMeshHash;
+
+	bool bMergedMeshReady;
+	bool bUsingMergedMesh;
+
+	//Pick whether our body mesh evaluates its pose when nobody can see it
+	void UpdateAnimTickOption();
+
+	//What our body mesh does when it isn't rendered, unless something needs its bones
+	EVisibilityBasedAnimTickOption DefaultAnimTickOption;
+
+	//The lag compensation hitboxes and our merged mesh both need our bones to move even though the body mesh isn't rendered.
+	//Hitboxes are only recorded while another character is near enough to hit us.
+	bool bRecordingHitboxes;
+
+	ECharacterSignificance Significance;
+	bool bSignificanceApplied;
+
+	FCharacterLocomotion Locomotion;
 
 	//Function used for scrolling up in the inventory GUI
 	void NextInventoryItem();
@@ -273,17 +376,60 @@ protected:
 	void StartProning();
 	void StopProning();
 
+	void StartSprinting();
+	void StopSprinting();
+
 	UPROPERTY(ReplicatedUsing = OnRep_Health, BlueprintReadOnly, Category = "Health")
 	float Health;
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Health")
 	float MaxHealth;
 
+	/** Which body slot each of these bones belongs to, for working out which gear protects a hit. Bones that aren't
+	listed belong to the same slot as their parent. */
+	UPROPERTY(EditDefaultsOnly, Category = "Health")
+	TMap<FName, EEquippableSlot> HitZoneBones;
+
+	//Damage taken multipliers from our equipped gear, so we don't have to look through our gear on every hit
+	struct FDefenceProfile
+	{
+		//Indexed by the body slot that was hit
+		float ZoneDamageTaken[(uint8)EEquippableSlot::EIS_MAX];
+
+		//For damage that didn't hit a bone, like explosions
+		float OverallDamageTaken;
+	};
+
+	FDefenceProfile DefenceProfile;
+
+	//The body slot of every bone in our mesh, shared with every other character using the same mesh
+	TSharedPtr<const TMap<FName, EEquippableSlot>> BoneHitZones;
+
+	UFUNCTION()
+	void OnEquipmentChanged(const EEquippableSlot Slot, const UEquippableItem* Item);
+
+	void UpdateDefenceProfile();
+
 public:
 
 	//Modify the players health by either a negative or positive amount. Return the amount of health actually removed.
 	float ModifyHealth(const float Delta);
 
+	UFUNCTION(BlueprintPure, Category = "Health")
+	FORCEINLINE float GetHealth() const { return Health; };
+
+	UFUNCTION(BlueprintPure, Category = "Health")
+	FORCEINLINE bool IsAlive() const { return Killer == nullptr; };
+
+	/** How much of incoming damage we actually take after our gear's defence. 1 means no protection.
+	@param HitBone the bone that was hit. Only gear covering that bone counts. If none, all our gear counts. */
+	float GetDamageTakenMultiplier(const FName HitBone = NAME_None) const;
+
+	/** [Server] Take all the damage the damage queue collected for us this frame, and die if it was enough.
+	@param DamageEvent, EventInstigator, DamageCauser describe the killing blow, or the last hit if we survived
+	@return true if this killed us */
+	bool ApplyQueuedDamage(const float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser);
+
 	UFUNCTION()
 	void OnRep_Health(float OldHealth);
 
@@ -292,15 +438,37 @@ public:
 
 
 
+public:
+
+	//[Server] Take a weapon out, putting away the one we're holding. Pass null to go back to melee.
+	UFUNCTION(BlueprintCallable, Category = "Weapon")
+	void EquipWeapon(class AWeaponClass* Weapon);
+
+	UFUNCTION(BlueprintPure, Category = "Weapon")
+	FORCEINLINE class AWeaponClass* GetCurrentWeapon() const { return CurrentWeapon; };
+
 protected:
 
+	//The weapon in our hands. Fire goes to this, or to melee if we don't have one.
+	UPROPERTY(ReplicatedUsing = OnRep_CurrentWeapon, BlueprintReadOnly, Category = "Weapon")
+	class AWeaponClass* CurrentWeapon;
+
+	UFUNCTION()
+	void OnRep_CurrentWeapon(class AWeaponClass* PreviousWeapon);
+
 	void StartFire();
 	void StopFire();
 
+	void StartReload();
+
 	void BeginMeleeAttack();
 
+	/** @param ClientTimestamp the servers world time as the client saw it when it swept, so the server can rewind the target to where the client saw it */
 	UFUNCTION(Server, Reliable)
-	void ServerProcessMeleeHit(const FHitResult& MeleeHit);
+	void ServerProcessMeleeHit(const FHitResult& MeleeHit, const float ClientTimestamp);
+
+	//[Server] Check a melee hit the client sent us is one it could have actually made
+	bool IsValidMeleeHit(const FHitResult& MeleeHit, const float ClientTimestamp) const;
 
 	UFUNCTION(NetMulticast, Unreliable)
 	void MulticastPlayMeleeFX();
@@ -312,6 +480,10 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = Melee)
 	float MeleeAttackDistance;
 
+	//Radius of the sphere we sweep for melee hits
+	UPROPERTY(EditDefaultsOnly, Category = Melee)
+	float MeleeAttackRadius;
+
 	UPROPERTY(EditDefaultsOnly, Category = Melee)
 	float MeleeAttackDamage;
 
@@ -332,6 +504,14 @@ protected:
 	UFUNCTION()
 	void OnRep_Killer();
 
+public:
+
+	//Called by the ragdoll subsystem when we die, and when our ragdoll has settled or is too far away to be worth simulating
+	void StartRagdoll();
+	void FreezeRagdoll();
+
+protected:
+
 	UFUNCTION(BlueprintImplementableEvent)
 	void OnDeath();
 
@@ -375,11 +555,16 @@ protected:
 	// End of APawn interface
 
 protected:
+	virtual void PostInitializeComponents() override;
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
-	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	virtual void Restart() override;
+
+	/** Damage goes through the damage queue and is only applied at the end of the frame, so this returns 0 while the queue exists.
+	OnTakeAnyDamage and the other damage events see the amount before armor. What was actually dealt goes to instigators in hit markers. */
 	virtual float TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
 
 public:
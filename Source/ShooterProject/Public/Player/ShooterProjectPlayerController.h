@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "Components/InventoryComponent.h"
 #include "ShooterProjectPlayerController.generated.h"
 
 /**
@@ -25,6 +26,10 @@ public:
 	UFUNCTION(BlueprintImplementableEvent)
 	void ShowNotification(const FText& Message);
 
+	//Tell the client why an item couldn't be added. Only the error code is sent, the client localizes it.
+	UFUNCTION(Client, Reliable)
+	void ClientShowItemAddError(const EItemAddError Error, TSubclassOf<class UItem> ItemClass);
+
 	UFUNCTION(BlueprintImplementableEvent)
 	void ShowDeathScreen(class AShooterProjectCharacter* Killer);
 
@@ -39,4 +44,40 @@ public:
 
 	UFUNCTION(BlueprintImplementableEvent)
 	void OnHitPlayer();
+
+	//[Server] Tell the client how much damage it did to a player this frame. Victim is null if the client doesn't know about them.
+	UFUNCTION(Client, Unreliable)
+	void ClientHitMarker(class APawn* Victim, const uint16 Damage, const bool bKilled);
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnHitMarker(class APawn* Victim, const float Damage, const bool bKilled);
+
+	//Show our interaction widget over an interactable we've started looking at. Made the first time it's needed.
+	void ShowInteractionWidget(class UInteractionComponent* InteractionComponent);
+
+	//Hide our interaction widget, if it's showing this interactable
+	void HideInteractionWidget(class UInteractionComponent* InteractionComponent);
+
+	//Let the widget know the interactable changed, if it's the one we're showing
+	void RefreshInteractionWidget(class UInteractionComponent* InteractionComponent);
+
+	//Called by the batched tick subsystem after the camera has moved, to keep the widget over the interactable
+	void UpdateInteractionWidgetPosition();
+
+	FORCEINLINE class UInteractionWidget* GetInteractionWidget() const { return InteractionWidget; };
+	FORCEINLINE TSubclassOf<class UInteractionWidget> GetInteractionWidgetClass() const { return InteractionWidgetClass; };
+
+protected:
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//The widget shown over whatever we're looking at. Interactables don't have widgets of their own. Defaults to WBP_InteractionCard.
+	UPROPERTY(EditDefaultsOnly, Category = "Interaction")
+	TSubclassOf<class UInteractionWidget> InteractionWidgetClass;
+
+	UPROPERTY()
+	class UInteractionWidget* InteractionWidget;
+
+	UPROPERTY()
+	class UInteractionComponent* ShownInteraction;
 };
@@ -4,13 +4,16 @@
 
 #include "CoreMinimal.h"
 #include "Blueprint/UserWidget.h"
+#include "Blueprint/IUserObjectListEntry.h"
 #include "InventoryItemWidget.generated.h"
 
 /**
- * 
+ * An item in the inventory. Used as the entry widget of UInventoryListWidget, which only makes enough of these for the rows
+ * on screen and hands them a different item as the list scrolls, so anything that depends on the item belongs in
+ * RefreshItem rather than Construct.
  */
 UCLASS()
-class SHOOTERPROJECT_API UInventoryItemWidget : public UUserWidget
+class SHOOTERPROJECT_API UInventoryItemWidget : public UUserWidget, public IUserObjectListEntry
 {
 	GENERATED_BODY()
 
@@ -18,5 +21,25 @@ public:
 
 	UPROPERTY(BlueprintReadOnly, Category = "Inventory Item Widget", meta = (ExposeOnSpawn = true))
 	class UItem* Item;
-	
+
+	/**Called when this widget is given an item, and whenever that item is modified*/
+	UFUNCTION(BlueprintImplementableEvent, Category = "Inventory Item Widget")
+	void RefreshItem();
+
+protected:
+
+	//Only made once the widget is hovered, instead of one per item up front
+	UPROPERTY()
+	class UItemTooltip* Tooltip;
+
+	virtual void NativeOnListItemObjectSet(UObject* ListItemObject) override;
+	virtual void NativeOnEntryReleased() override;
+	virtual void NativeOnMouseEnter(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
+
+	UFUNCTION()
+	void OnItemModified();
+
+	void OnThumbnailLoaded(TWeakObjectPtr<class UItem> LoadedItem);
+
+	void SetItem(class UItem* NewItem);
 };
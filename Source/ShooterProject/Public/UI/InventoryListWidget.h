@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "InventoryListWidget.generated.h"
+
+class UListView;
+class UInventoryComponent;
+
+/**
+ * Shows an inventory in a list or tile view. Only the rows on screen get an item widget, these are recycled as the list
+ * scrolls, and an inventory update only adds and removes the items that changed instead of rebuilding every widget.
+ * A Blueprint can lay out its own ItemList, whose entry widget class should be a UInventoryItemWidget. Without one, the
+ * widget builds a tile view of EntryWidgetClass itself, so it can be placed in a layout as is.
+ */
+UCLASS()
+class SHOOTERPROJECT_API UInventoryListWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryListWidget(const FObjectInitializer& ObjectInitializer);
+
+	virtual bool Initialize() override;
+
+	//Can be a UTileView too. Built at initialize if the Blueprint doesn't have one
+	UPROPERTY(BlueprintReadOnly, Category = "Widgets", meta = (BindWidgetOptional))
+	UListView* ItemList;
+
+	//The entry widget of the list we build when there's no ItemList in the Blueprint
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Widgets")
+	TSubclassOf<class UInventoryItemWidget> EntryWidgetClass;
+
+	/**
+	* Show the items in an inventory, and keep them up to date as it changes.
+	* @param NewInventory The inventory to show, or null to clear the list
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void SetInventory(UInventoryComponent* NewInventory);
+
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	FORCEINLINE UInventoryComponent* GetInventory() const { return Inventory; };
+
+	/**Bring the list in line with the inventory, only touching the items that were added or removed*/
+	UFUNCTION()
+	void SyncItems();
+
+protected:
+
+	virtual void NativeDestruct() override;
+
+	UPROPERTY()
+	UInventoryComponent* Inventory;
+};
@@ -12,18 +12,19 @@
 class UButton;
 class UTextBlock;
 class UImage;
+class UInventoryListWidget;
 
 USTRUCT(BlueprintType)
 struct FCachedInventoryData
 {
 	GENERATED_BODY()
 
-	//CACHED THUMBNAILS 
+	//CACHED THUMBNAILS, streamed in when the inventory is shown
 	UPROPERTY(EditDefaultsOnly, Category = "Widgets")
-	UTexture2D* Primary_Thumbnail;
+	TSoftObjectPtr<UTexture2D> Primary_Thumbnail;
 
 	UPROPERTY(EditDefaultsOnly, Category = "Widgets")
-	UTexture2D* Secondary_Thumbnail;
+	TSoftObjectPtr<UTexture2D> Secondary_Thumbnail;
 };
 
 UCLASS()
@@ -46,4 +47,9 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (BindWidget))
 	UButton* SecondaryButton;
 
+	//Virtualized list of the player's items, pointed at their inventory on construct. Optional, as WBP_InventoryWidget
+	//isn't a UInventoryUserWidget and builds a widget per item in its own graph until it places a UInventoryListWidget.
+	UPROPERTY(BlueprintReadOnly, meta = (BindWidgetOptional))
+	UInventoryListWidget* InventoryList;
+
 };
@@ -31,6 +31,8 @@ class SHOOTERPROJECT_API AItemSpawn : public ATargetPoint
 {
 	GENERATED_BODY()
 
+	friend class ULootSpawnSubsystem;
+
 	UPROPERTY(EditAnywhere, Category = "Loot")
 	class UDataTable* LootTable;
 
@@ -44,10 +46,23 @@ public:
 	//Sets default values for this actor
 	AItemSpawn();
 
+	/** Roll the loot table without spawning anything. The same stream state always gives the same items.
+	@param LootDirector optional director used to steer the roll away from items that are at or near their caps */
+	void RollLoot(const FRandomStream& RandomStream, TArray<TSubclassOf<class UItem>>& OutItems, const class ULootDirectorSubsystem* LootDirector = nullptr) const;
+
+	/** Roll an already compiled version of our loot table, for callers that roll many times and look it up once.
+	Returns false if no row was picked, which with a director means every row we tried was capped. */
+	bool RollLoot(const struct FCompiledLootTable& CompiledTable, const FRandomStream& RandomStream, TArray<TSubclassOf<class UItem>>& OutItems, const class ULootDirectorSubsystem* LootDirector = nullptr) const;
+
+	FORCEINLINE const class UDataTable* GetLootTable() const { return LootTable; };
+
 protected:
 
 	FTimerHandle TimerHandle_RespawnItem;
 
+	//Drives both the loot rolls and the respawn timer, seeded from the match seed and this spawner
+	FRandomStream LootStream;
+
 	UPROPERTY()
 	TArray<AActor*> SpawnedPickups;
 
@@ -55,6 +70,13 @@ protected:
 	UFUNCTION()
 	void OnItemTaken(AActor* DestroyedActor);
 
+	//Queue up another spawn after a random delay within RespawnRange
+	void ScheduleRespawn();
+
+	//Hand our spawn to the loot spawn scheduler, which calls SpawnItem when there is time for it
+	UFUNCTION()
+	void QueueSpawn();
+
 	UFUNCTION()
 	void SpawnItem();
 	
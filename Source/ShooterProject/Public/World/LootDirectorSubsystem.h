@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "LootDirectorSubsystem.generated.h"
+
+struct FCompiledLootTable;
+struct FLootTableRow;
+
+//A limit on how many of an item can be lying around the world at once
+USTRUCT()
+struct FLootPopulationCap
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config, EditAnywhere, Category = "Loot")
+	TSoftClassPtr<class UItem> ItemClass;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Loot", meta = (ClampMin = 0))
+	int32 MaxCount = 0;
+};
+
+/**
+ * Keeps a world wide view of the loot that is lying around, in spawned and dropped pickups and in lootable containers.
+ * Spawners ask the director before rolling loot so items that are at their cap don't get spawned, and items that are
+ * close to their cap get spawned less often. Dropped pickups are culled oldest first when there are too many pickups.
+ */
+UCLASS(config = Game)
+class SHOOTERPROJECT_API ULootDirectorSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	ULootDirectorSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	void RegisterRegion(class ALootRegionVolume* Region);
+	void UnregisterRegion(class ALootRegionVolume* Region);
+
+	//[Server] Start counting a pickup. Dropped pickups can be culled when the world has too many pickups.
+	void RegisterPickup(class APickup* Pickup, UClass* ItemClass, const bool bDropped);
+	void UnregisterPickup(class APickup* Pickup);
+
+	//[Server] Count items that are sitting in a lootable container
+	void AddContainerLoot(UClass* ItemClass, const AActor* Container);
+	void RemoveContainerLoot(UClass* ItemClass, const AActor* Container);
+
+	/** Roll a loot table, biased away from items that are close to their caps. Rows containing an item that is at its
+	cap are never picked, so this can return null if we couldn't find anything that is allowed to spawn.
+	@param Spawner the spawner or container rolling, whose region caps apply to the roll */
+	const FLootTableRow* SampleLootTable(const FCompiledLootTable& LootTable, const FRandomStream& RandomStream, const AActor* Spawner) const;
+
+	//Whether spawners should hold off because the world already has as many pickups as we allow
+	bool IsAtPickupBudget() const;
+
+	UFUNCTION(BlueprintPure, Category = "Loot")
+	int32 GetLiveCount(TSubclassOf<class UItem> ItemClass) const;
+
+	UFUNCTION(BlueprintPure, Category = "Loot")
+	FORCEINLINE int32 GetNumLivePickups() const { return LivePickups.Num(); };
+
+protected:
+
+	//Caps on single item classes across the whole world
+	UPROPERTY(Config)
+	TArray<FLootPopulationCap> GlobalItemCaps;
+
+	//The max amount of pickup actors in the world. Dropped pickups are culled oldest first to stay under this.
+	UPROPERTY(Config)
+	int32 MaxLivePickups;
+
+	//The least likely an item gets to keep its roll when it is almost at its cap, so items never completely stop spawning until they hit it
+	UPROPERTY(Config)
+	float MinSpawnBias;
+
+	//How many times we re-roll when the bias rejects a row, so a roll always takes bounded time
+	UPROPERTY(Config)
+	int32 MaxBiasRerolls;
+
+	struct FRegionPopulation
+	{
+		TWeakObjectPtr<class ALootRegionVolume> Region;
+		TMap<UClass*, int32> LiveCounts;
+		int32 LiveTotal = 0;
+	};
+
+	struct FTrackedPickup
+	{
+		UClass* ItemClass;
+		int32 RegionIndex;
+	};
+
+	//Returns INDEX_NONE if the location isn't inside any region
+	int32 FindRegionIndex(const FVector& Location) const;
+
+	//The region a spawner or container is in. These don't move, so the result is cached until the regions change.
+	int32 GetActorRegionIndex(const AActor* Actor) const;
+
+	void AddLive(UClass* ItemClass, const int32 RegionIndex);
+	void RemoveLive(UClass* ItemClass, const int32 RegionIndex);
+
+	//How likely an item is to keep its roll, 1 means we aren't anywhere near a cap and 0 means it is at one
+	float GetSpawnBias(UClass* ItemClass, const int32 RegionIndex) const;
+
+	void CullDroppedPickups();
+
+	TMap<UClass*, int32> ResolvedGlobalCaps;
+
+	TMap<UClass*, int32> LiveCounts;
+
+	TArray<FRegionPopulation> Regions;
+
+	mutable TMap<TObjectKey<AActor>, int32> ActorRegionIndices;
+
+	TMap<class APickup*, FTrackedPickup> LivePickups;
+
+	//Dropped pickups oldest first. Entries before DroppedPickupsHead have already been handled.
+	TArray<TWeakObjectPtr<class APickup>> DroppedPickups;
+	int32 DroppedPickupsHead;
+};
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Volume.h"
+#include "LootRegionVolume.generated.h"
+
+/**
+ * An area of the map with its own loot population caps, on top of the global caps set on the loot director.
+ * Loot belongs to the first region it is inside of.
+ */
+UCLASS()
+class SHOOTERPROJECT_API ALootRegionVolume : public AVolume
+{
+	GENERATED_BODY()
+
+public:
+
+	ALootRegionVolume();
+
+	//The max number of each item that can be lying around in this region at once
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	TMap<TSubclassOf<class UItem>, int32> ItemCaps;
+
+	//The max number of items of any type in this region. Zero means there is no limit.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = 0))
+	int32 MaxItems;
+
+protected:
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "LootSpawnSubsystem.generated.h"
+
+/**
+ * Queues pickup spawns from every AItemSpawn in the world and works through them within a per-frame time budget,
+ * nearest to a player first. This spreads out the map load spike and respawn timers that happen to fire together.
+ * The queue is a heap on distance to the closest player, and distances are only refreshed every loot.SpawnPrioritizeInterval seconds.
+ */
+UCLASS()
+class SHOOTERPROJECT_API ULootSpawnSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	//[Server] Queue up a spawner to spawn its loot once there is time left in a frame. Does nothing if the spawner is already queued.
+	void RequestSpawn(class AItemSpawn* ItemSpawn);
+
+	FORCEINLINE int32 GetQueueDepth() const { return PendingSpawns.Num(); };
+
+	//Begin FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	//End FTickableGameObject
+
+protected:
+
+	struct FPendingSpawn
+	{
+		TWeakObjectPtr<class AItemSpawn> ItemSpawn;
+
+		//Squared distance to the closest player when the queue was last prioritized
+		float PriorityDistanceSq;
+
+		//Order the spawn was requested in, so spawners at the same distance keep their queue order
+		uint32 RequestOrder;
+
+		FORCEINLINE bool operator<(const FPendingSpawn& Other) const
+		{
+			return PriorityDistanceSq < Other.PriorityDistanceSq || (PriorityDistanceSq == Other.PriorityDistanceSq && RequestOrder < Other.RequestOrder);
+		}
+	};
+
+	//Refresh player locations and the distance of every queued spawn, then rebuild the heap
+	void PrioritizePendingSpawns();
+
+	//Squared distance from a spawner to the closest player we know about
+	float GetPriorityDistanceSq(const class AItemSpawn* ItemSpawn) const;
+
+	//Heap of queued spawns, closest to a player at the top
+	TArray<FPendingSpawn> PendingSpawns;
+
+	//Spawners that are somewhere in PendingSpawns
+	TSet<TWeakObjectPtr<class AItemSpawn>> QueuedSpawners;
+
+	//Player locations from the last time we prioritized, used to place new requests in the heap
+	TArray<FVector> PlayerLocations;
+
+	double LastPrioritizeTime = 0.0;
+	uint32 NextRequestOrder = 0;
+};
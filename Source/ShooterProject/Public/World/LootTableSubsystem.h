@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "LootTableSubsystem.generated.h"
+
+class UDataTable;
+struct FLootTableRow;
+
+DECLARE_STATS_GROUP(TEXT("Loot"), STATGROUP_Loot, STATCAT_Advanced);
+
+/**
+ * A loot table flattened into an alias table (Vose's method) so a weighted row can be picked in O(1).
+ * Each row is weighted by its Probability, which gives the same distribution as the old "pick a random row,
+ * then roll against its Probability" loop without the unbounded re-rolls.
+ */
+struct SHOOTERPROJECT_API FCompiledLootTable
+{
+public:
+
+	FCompiledLootTable() {};
+	explicit FCompiledLootTable(const UDataTable* LootTable);
+
+	//Pick a row using two uniform numbers in the range [0, 1]
+	const FLootTableRow* Sample(const float ColumnRoll, const float AliasRoll) const;
+
+	//Pick a row using the global random generator
+	const FLootTableRow* Sample() const;
+
+	//Pick a row using a seeded stream, so the same seed always gives the same loot
+	const FLootTableRow* Sample(const FRandomStream& RandomStream) const;
+
+	FORCEINLINE int32 Num() const { return Rows.Num(); };
+	FORCEINLINE bool IsEmpty() const { return Rows.Num() == 0; };
+
+	//The normalized chance of a row being picked. Mostly useful for debugging and validating the table.
+	float GetRowWeight(const int32 RowIndex) const;
+
+	FORCEINLINE const FLootTableRow* GetRow(const int32 RowIndex) const { return Rows[RowIndex]; };
+
+private:
+
+	//Rows with a non-zero probability. Pointers are owned by the data table.
+	TArray<const FLootTableRow*> Rows;
+
+	//Chance of keeping the column we rolled, instead of jumping to its alias
+	TArray<float> KeepProbability;
+
+	TArray<int32> Alias;
+
+	//Normalized weights, kept around so the table can be inspected
+	TArray<float> Weights;
+};
+
+/**
+ * Compiles loot tables once and shares them between every spawner that references the same data table.
+ */
+UCLASS()
+class SHOOTERPROJECT_API ULootTableSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	//Returns the compiled version of a loot table, compiling it the first time it is requested. Don't hold on to the result.
+	const FCompiledLootTable* GetCompiledTable(const UDataTable* LootTable);
+
+	//Helper for actors that just want the compiled table for a data table they reference
+	static const FCompiledLootTable* FindOrCompile(const UObject* WorldContextObject, const UDataTable* LootTable);
+
+	//[Server] The loot seed of the current match, or zero if there is no game mode to ask
+	static int32 GetMatchLootSeed(const UObject* WorldContextObject);
+
+	/** Build the seed for a spawner's loot stream. Level placed spawners get the same seed every time the map is loaded,
+	so a match seed always reproduces the same loot.
+	@param SpawnerSeed optional designer set seed that replaces the spawners name in the hash */
+	static int32 MakeLootSeed(const int32 MatchSeed, const AActor* Spawner, const int32 SpawnerSeed = 0);
+
+	//The part of a spawner's loot seed that doesn't change between matches. Hashes the path name, so work it out once per spawner.
+	static uint32 GetSpawnerHash(const AActor* Spawner, const int32 SpawnerSeed = 0);
+
+	//Combine a match seed with a hash from GetSpawnerHash
+	static int32 CombineLootSeed(const int32 MatchSeed, const uint32 SpawnerHash);
+
+private:
+
+	void OnLootTableChanged(TWeakObjectPtr<const UDataTable> LootTable);
+
+	TMap<TWeakObjectPtr<const UDataTable>, TSharedRef<FCompiledLootTable>> CompiledTables;
+};
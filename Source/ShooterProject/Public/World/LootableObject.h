@@ -32,10 +32,50 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Components")
 	FIntPoint LootRolls;
 
+	//Seed used to roll the loot, combined with the match seed. Zero means the seed is a hash of the container's path name, which is the same every time the map is loaded.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	int32 LootSeed;
+
+	//Loot is generated when a player comes this close to the container. Zero means loot is only generated when a player opens it.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = 0.0))
+	float LootGenerationRadius;
+
+	//[Server] Roll the loot table and fill the inventory. Only does anything the first time it is called.
+	UFUNCTION(BlueprintCallable, Category = "Loot")
+	void GenerateLoot();
+
+	UFUNCTION(BlueprintPure, Category = "Loot")
+	FORCEINLINE bool HasGeneratedLoot() const { return bLootGenerated; };
+
+	/** Roll the loot table without creating any items. The same stream state always gives the same items.
+	@param LootDirector optional director used to steer the rolls away from items that are at or near their caps */
+	void RollLoot(const FRandomStream& RandomStream, TArray<TSubclassOf<class UItem>>& OutItems, const class ULootDirectorSubsystem* LootDirector = nullptr) const;
+
+	//Roll an already compiled version of our loot table, for callers that roll many times and look it up once
+	void RollLoot(const struct FCompiledLootTable& CompiledTable, const FRandomStream& RandomStream, TArray<TSubclassOf<class UItem>>& OutItems, const class ULootDirectorSubsystem* LootDirector = nullptr) const;
+
+	//The seed this container rolls its loot with for a given match seed
+	int32 GetLootSeed(const int32 MatchSeed) const;
+
 protected:
+
+	//Tell the loot director when an item is taken out of the container
+	void OnLootRemoved(class UItem* Item);
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	UFUNCTION()
 	void OnInteract(class AShooterProjectCharacter* Character);
+
+	UFUNCTION()
+	void OnLootGenerationTriggerOverlap(class UPrimitiveComponent* OverlappedComponent, class AActor* OtherActor, class UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	//Only created on the server when LootGenerationRadius is set, and destroyed again once loot has been generated
+	UPROPERTY(Transient)
+	class USphereComponent* LootGenerationTrigger;
+
+	//Containers stay empty until a player opens them or comes close, so unopened containers don't cost any item objects
+	bool bLootGenerated;
 };
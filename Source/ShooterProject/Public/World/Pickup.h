@@ -6,6 +6,8 @@
 #include "GameFramework/Actor.h"
 #include "Pickup.generated.h"
 
+enum class EAssetStreamPriority : uint8;
+
 UCLASS()
 class SHOOTERPROJECT_API APickup : public AActor
 {
@@ -16,7 +18,7 @@ public:
 	APickup();
 
 	//Takes the item to represent and creates the pickup from it. Done on BeginPlay and when a player drops an item on the ground.
-	void InitializePickup(const TSubclassOf<class UItem> ItemClass, const int32 Quantity);
+	void InitializePickup(const TSubclassOf<class UItem> ItemClass, const int32 Quantity, const bool bDropped = false);
 
 	/**Align pickups rotation with ground rotation. */
 	UFUNCTION(BlueprintImplementableEvent)
@@ -39,8 +41,18 @@ protected:
 	UFUNCTION()
 	void OnItemModified();
 
+	//Stream in the item's mesh, moving it up the queue if the pickup is more important than when it was first asked for
+	void RequestPickupMesh(const EAssetStreamPriority Priority);
+
+	void OnPickupMeshLoaded();
+
+	//The player is looking at us, so they'll want to see our mesh and thumbnail before any other pickups
+	UFUNCTION()
+	void OnBeginFocus(class AShooterProjectCharacter* Character);
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	virtual bool ReplicateSubobjects(class UActorChannel *Channel, class FOutBunch *Bunch, FReplicationFlags *RepFlags) override;
 